@@ -0,0 +1,398 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/**
+ * \file
+ * \brief Bulk certificate issuance on top of oqsprovider.
+ *
+ * oqs_bulk_issue() runs a three stage pipeline over a ring of jobs: the
+ * calling thread reads requests and builds the to-be-signed certificates,
+ * worker threads check request signatures and sign, and the calling thread
+ * again writes finished certificates in input order. Workers sign with a
+ * copy of a signature context initialized once per issuer, which skips the
+ * provider's algorithm identifier and digest setup for every certificate.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+
+#include "bulk_issuance.h"
+
+/** \brief Jobs in flight per worker thread. */
+#define JOBS_PER_THREAD 4
+
+typedef enum { JOB_FREE, JOB_READY, JOB_DONE } JOB_STATE;
+
+typedef struct {
+    JOB_STATE state;
+    X509 *cert;
+    X509_REQ *req; /* request to check, NULL for bare public keys */
+    unsigned char *der;
+    int derlen; /* <= 0 if the job failed */
+} JOB;
+
+struct oqs_bulk_issuer_st {
+    OSSL_LIB_CTX *libctx;
+    char *propq;
+    EVP_PKEY *ca_key;
+    X509 *ca_cert;
+    EVP_MD_CTX *sign_tmpl;
+    int threads;
+    long days;
+    uint64_t serial;
+
+    /* state of a running oqs_bulk_issue(), guarded by lock */
+    pthread_mutex_t lock;
+    pthread_cond_t work, done;
+    JOB *jobs;
+    size_t depth;
+    uint64_t next_read, next_sign, next_write;
+    int stop;
+};
+
+OQS_BULK_ISSUER *oqs_bulk_issuer_new(OSSL_LIB_CTX *libctx, const char *propq,
+                                     EVP_PKEY *ca_key, X509 *ca_cert,
+                                     const char *mdname, int threads)
+{
+    OQS_BULK_ISSUER *issuer;
+    long cpus;
+
+    if ((issuer = OPENSSL_zalloc(sizeof(*issuer))) == NULL)
+        return NULL;
+    issuer->libctx = libctx;
+    issuer->days = 365;
+    issuer->serial = 1;
+    if ((propq != NULL &&
+         (issuer->propq = OPENSSL_strdup(propq)) == NULL) ||
+        !EVP_PKEY_up_ref(ca_key))
+        goto err;
+    issuer->ca_key = ca_key;
+    if (!X509_up_ref(ca_cert))
+        goto err;
+    issuer->ca_cert = ca_cert;
+    if (!X509_check_private_key(ca_cert, ca_key))
+        goto err;
+
+    /* the only signature context initialization, copied for every job */
+    if ((issuer->sign_tmpl = EVP_MD_CTX_new()) == NULL ||
+        EVP_DigestSignInit_ex(issuer->sign_tmpl, NULL, mdname, libctx, propq,
+                              ca_key, NULL) <= 0)
+        goto err;
+
+    if (threads == 0) {
+        cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    issuer->threads = threads;
+    return issuer;
+
+err:
+    oqs_bulk_issuer_free(issuer);
+    return NULL;
+}
+
+void oqs_bulk_issuer_set_validity(OQS_BULK_ISSUER *issuer, long days)
+{
+    issuer->days = days;
+}
+
+void oqs_bulk_issuer_set_serial(OQS_BULK_ISSUER *issuer, uint64_t serial)
+{
+    issuer->serial = serial;
+}
+
+void oqs_bulk_issuer_free(OQS_BULK_ISSUER *issuer)
+{
+    if (issuer == NULL)
+        return;
+    EVP_MD_CTX_free(issuer->sign_tmpl);
+    X509_free(issuer->ca_cert);
+    EVP_PKEY_free(issuer->ca_key);
+    OPENSSL_free(issuer->propq);
+    OPENSSL_free(issuer);
+}
+
+static double now_seconds(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int add_ext(X509V3_CTX *ctx, X509 *cert, int nid, const char *value)
+{
+    X509_EXTENSION *ext = X509V3_EXT_conf_nid(NULL, ctx, nid, value);
+    int ret = ext != NULL && X509_add_ext(cert, ext, -1);
+
+    X509_EXTENSION_free(ext);
+    return ret;
+}
+
+/** \brief Builds the to-be-signed certificate for \p pkey and \p subject,
+ * or for the serial number as common name if \p subject is NULL. */
+static X509 *build_tbs(OQS_BULK_ISSUER *issuer, EVP_PKEY *pkey,
+                       const X509_NAME *subject)
+{
+    X509 *cert;
+    X509_NAME *name = NULL;
+    X509V3_CTX v3ctx;
+    char cn[24];
+    int ok;
+
+    if ((cert = X509_new_ex(issuer->libctx, issuer->propq)) == NULL)
+        return NULL;
+    if (subject == NULL) {
+        BIO_snprintf(cn, sizeof(cn), "%llx",
+                     (unsigned long long)issuer->serial);
+        if ((name = X509_NAME_new()) == NULL ||
+            !X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                        (unsigned char *)cn, -1, -1, 0))
+            goto err;
+        subject = name;
+    }
+    ok = X509_set_version(cert, X509_VERSION_3) &&
+         ASN1_INTEGER_set_uint64(X509_get_serialNumber(cert),
+                                 issuer->serial) &&
+         X509_set_issuer_name(cert, X509_get_subject_name(issuer->ca_cert)) &&
+         X509_set_subject_name(cert, subject) &&
+         X509_gmtime_adj(X509_getm_notBefore(cert), 0) != NULL &&
+         X509_time_adj_ex(X509_getm_notAfter(cert), (int)issuer->days, 0,
+                          NULL) != NULL &&
+         X509_set_pubkey(cert, pkey);
+    if (!ok)
+        goto err;
+    X509V3_set_ctx(&v3ctx, issuer->ca_cert, cert, NULL, NULL, 0);
+    if (!add_ext(&v3ctx, cert, NID_basic_constraints, "critical,CA:FALSE") ||
+        !add_ext(&v3ctx, cert, NID_subject_key_identifier, "hash") ||
+        (X509_get0_subject_key_id(issuer->ca_cert) != NULL &&
+         !add_ext(&v3ctx, cert, NID_authority_key_identifier, "keyid")))
+        goto err;
+    X509_NAME_free(name);
+    issuer->serial++;
+    return cert;
+
+err:
+    X509_NAME_free(name);
+    X509_free(cert);
+    return NULL;
+}
+
+/** \brief Reads the next request or public key from \p in into \p job.
+ *
+ * \returns 1 if the job is ready for signing, 0 at the end of the input,
+ * -1 if the input could not be used and -2 on fatal errors. */
+static int read_job(OQS_BULK_ISSUER *issuer, BIO *in, JOB *job)
+{
+    char *name = NULL, *header = NULL;
+    unsigned char *data = NULL;
+    const unsigned char *p;
+    EVP_PKEY *pkey = NULL;
+    long len;
+    int ret = -1;
+
+    if (!PEM_read_bio(in, &name, &header, &data, &len)) {
+        if (ERR_GET_REASON(ERR_peek_last_error()) != PEM_R_NO_START_LINE)
+            return -2;
+        ERR_clear_error();
+        return 0;
+    }
+    p = data;
+    if (strcmp(name, PEM_STRING_X509_REQ) == 0 ||
+        strcmp(name, PEM_STRING_X509_REQ_OLD) == 0) {
+        if ((job->req = X509_REQ_new_ex(issuer->libctx, issuer->propq)) ==
+                NULL ||
+            d2i_X509_REQ(&job->req, &p, len) == NULL ||
+            (pkey = X509_REQ_get0_pubkey(job->req)) == NULL ||
+            (job->cert = build_tbs(issuer, pkey,
+                                   X509_REQ_get_subject_name(job->req))) ==
+                NULL)
+            goto end;
+    } else if (strcmp(name, PEM_STRING_PUBLIC) == 0) {
+        if ((pkey = d2i_PUBKEY_ex(NULL, &p, len, issuer->libctx,
+                                  issuer->propq)) == NULL ||
+            (job->cert = build_tbs(issuer, pkey, NULL)) == NULL)
+            goto end;
+        EVP_PKEY_free(pkey);
+    } else {
+        goto end;
+    }
+    ret = 1;
+
+end:
+    if (ret != 1) {
+        if (job->req == NULL)
+            EVP_PKEY_free(pkey);
+        X509_REQ_free(job->req);
+        job->req = NULL;
+        ERR_clear_error();
+    }
+    OPENSSL_free(name);
+    OPENSSL_free(header);
+    OPENSSL_free(data);
+    return ret;
+}
+
+/** \brief Checks the request of \p job, if any, then signs and encodes its
+ * certificate. Runs on worker threads. */
+static void sign_job(OQS_BULK_ISSUER *issuer, EVP_MD_CTX *mctx, JOB *job)
+{
+    job->derlen = 0;
+    if (job->req != NULL &&
+        X509_REQ_verify_ex(job->req, X509_REQ_get0_pubkey(job->req),
+                           issuer->libctx, issuer->propq) <= 0)
+        goto end;
+    if (!EVP_MD_CTX_copy_ex(mctx, issuer->sign_tmpl) ||
+        X509_sign_ctx(job->cert, mctx) <= 0)
+        goto end;
+    job->derlen = i2d_X509(job->cert, &job->der);
+
+end:
+    if (job->derlen <= 0)
+        ERR_clear_error();
+}
+
+static void free_job(JOB *job)
+{
+    X509_free(job->cert);
+    X509_REQ_free(job->req);
+    OPENSSL_free(job->der);
+    memset(job, 0, sizeof(*job));
+}
+
+static void *worker_main(void *arg)
+{
+    OQS_BULK_ISSUER *issuer = arg;
+    EVP_MD_CTX *mctx = EVP_MD_CTX_new();
+    JOB *job;
+
+    pthread_mutex_lock(&issuer->lock);
+    for (;;) {
+        while (!issuer->stop && issuer->next_sign == issuer->next_read)
+            pthread_cond_wait(&issuer->work, &issuer->lock);
+        if (issuer->next_sign == issuer->next_read)
+            break;
+        job = &issuer->jobs[issuer->next_sign++ % issuer->depth];
+        pthread_mutex_unlock(&issuer->lock);
+        if (mctx != NULL)
+            sign_job(issuer, mctx, job);
+        else
+            job->derlen = 0;
+        pthread_mutex_lock(&issuer->lock);
+        job->state = JOB_DONE;
+        pthread_cond_signal(&issuer->done);
+    }
+    pthread_mutex_unlock(&issuer->lock);
+    EVP_MD_CTX_free(mctx);
+    OPENSSL_thread_stop();
+    return NULL;
+}
+
+int oqs_bulk_issue(OQS_BULK_ISSUER *issuer, BIO *in, BIO *out,
+                   OQS_BULK_STATS *stats)
+{
+    pthread_t *workers = NULL;
+    EVP_MD_CTX *mctx = NULL;
+    double start = now_seconds(CLOCK_MONOTONIC);
+    double cpu_start = now_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    JOB *job;
+    int i, started = 0, eof = 0, ret = 0, r;
+
+    memset(stats, 0, sizeof(*stats));
+    issuer->depth =
+        issuer->threads > 0 ? (size_t)issuer->threads * JOBS_PER_THREAD : 1;
+    issuer->next_read = issuer->next_sign = issuer->next_write = 0;
+    issuer->stop = 0;
+    if ((issuer->jobs = OPENSSL_zalloc(issuer->depth * sizeof(JOB))) == NULL)
+        return 0;
+    if (pthread_mutex_init(&issuer->lock, NULL) != 0) {
+        OPENSSL_free(issuer->jobs);
+        return 0;
+    }
+    pthread_cond_init(&issuer->work, NULL);
+    pthread_cond_init(&issuer->done, NULL);
+
+    if (issuer->threads > 0 &&
+        (workers = OPENSSL_malloc(issuer->threads * sizeof(*workers))) !=
+            NULL)
+        for (; started < issuer->threads; started++)
+            if (pthread_create(&workers[started], NULL, worker_main, issuer) !=
+                0)
+                break;
+    // sign inline if no worker could be started
+    if (started == 0 && (mctx = EVP_MD_CTX_new()) == NULL)
+        goto end;
+    stats->threads = started;
+
+    pthread_mutex_lock(&issuer->lock);
+    for (;;) {
+        job = &issuer->jobs[issuer->next_write % issuer->depth];
+        if (issuer->next_write < issuer->next_read &&
+            job->state == JOB_DONE) {
+            pthread_mutex_unlock(&issuer->lock);
+            if (job->derlen <= 0)
+                r = -1;
+            else
+                r = BIO_write(out, job->der, job->derlen) == job->derlen;
+            if (r > 0)
+                stats->issued++;
+            else if (r < 0)
+                stats->failed++;
+            free_job(job);
+            pthread_mutex_lock(&issuer->lock);
+            issuer->next_write++;
+            if (r == 0)
+                break;
+            continue;
+        }
+        if (!eof && issuer->next_read - issuer->next_write < issuer->depth) {
+            job = &issuer->jobs[issuer->next_read % issuer->depth];
+            pthread_mutex_unlock(&issuer->lock);
+            r = read_job(issuer, in, job);
+            if (r == 1 && started == 0)
+                sign_job(issuer, mctx, job);
+            pthread_mutex_lock(&issuer->lock);
+            if (r == 1) {
+                job->state = started > 0 ? JOB_READY : JOB_DONE;
+                issuer->next_read++;
+                pthread_cond_signal(&issuer->work);
+            } else if (r == 0) {
+                eof = 1;
+            } else if (r == -1) {
+                stats->failed++;
+            } else {
+                break;
+            }
+            continue;
+        }
+        if (eof && issuer->next_write == issuer->next_read) {
+            ret = 1;
+            break;
+        }
+        pthread_cond_wait(&issuer->done, &issuer->lock);
+    }
+    issuer->stop = 1;
+    pthread_cond_broadcast(&issuer->work);
+    pthread_mutex_unlock(&issuer->lock);
+
+end:
+    for (i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    for (i = 0; (size_t)i < issuer->depth; i++)
+        free_job(&issuer->jobs[i]);
+    EVP_MD_CTX_free(mctx);
+    OPENSSL_free(workers);
+    OPENSSL_free(issuer->jobs);
+    issuer->jobs = NULL;
+    pthread_cond_destroy(&issuer->work);
+    pthread_cond_destroy(&issuer->done);
+    pthread_mutex_destroy(&issuer->lock);
+    stats->seconds = now_seconds(CLOCK_MONOTONIC) - start;
+    stats->cpu_seconds = now_seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+    return ret;
+}
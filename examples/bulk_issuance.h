@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/**
+ * \file
+ * \brief Bulk certificate issuance on top of oqsprovider.
+ *
+ * The CA key is loaded and its signature context initialized once; for
+ * every request only that context is duplicated. Certificates are built by
+ * the calling thread, signed on a pool of worker threads and written out in
+ * input order, so the three stages overlap.
+ */
+
+#ifndef OQS_BULK_ISSUANCE_H
+#define OQS_BULK_ISSUANCE_H
+
+#include <stdint.h>
+
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+/** \brief Issuer holding CA key, CA certificate and certificate template. */
+typedef struct oqs_bulk_issuer_st OQS_BULK_ISSUER;
+
+/** \brief Counters of one oqs_bulk_issue() run. */
+typedef struct {
+    /** \brief Certificates written. */
+    uint64_t issued;
+    /** \brief Inputs skipped, e.g. requests with invalid signature. */
+    uint64_t failed;
+    /** \brief Worker threads used, 0 if signing was done inline. */
+    int threads;
+    /** \brief Wall clock time of the run in seconds. */
+    double seconds;
+    /** \brief Process CPU time of the run in seconds. */
+    double cpu_seconds;
+} OQS_BULK_STATS;
+
+/** \brief Creates an issuer signing with \p ca_key as \p ca_cert.
+ *
+ * \param mdname Digest for classic and hybrid CA keys, NULL for the default.
+ * \param threads Number of signing threads, 0 for one per online CPU and
+ * negative to sign in the calling thread.
+ *
+ * \returns the issuer or NULL on error. */
+OQS_BULK_ISSUER *oqs_bulk_issuer_new(OSSL_LIB_CTX *libctx, const char *propq,
+                                     EVP_PKEY *ca_key, X509 *ca_cert,
+                                     const char *mdname, int threads);
+
+/** \brief Sets validity in days (default 365) and the serial number of the
+ * next certificate (default 1). */
+void oqs_bulk_issuer_set_validity(OQS_BULK_ISSUER *issuer, long days);
+void oqs_bulk_issuer_set_serial(OQS_BULK_ISSUER *issuer, uint64_t serial);
+
+/** \brief Frees \p issuer. */
+void oqs_bulk_issuer_free(OQS_BULK_ISSUER *issuer);
+
+/** \brief Issues a certificate for every PEM certificate request or public
+ * key read from \p in and writes them DER encoded to \p out.
+ *
+ * Request signatures are checked on the worker threads; certificates for
+ * bare public keys get the serial number as common name. Inputs that
+ * cannot be used are counted in \p stats and skipped; requests failing the
+ * signature check leave a gap in the serial numbers.
+ *
+ * \returns 1 if the whole input was processed, 0 on fatal errors. */
+int oqs_bulk_issue(OQS_BULK_ISSUER *issuer, BIO *in, BIO *out,
+                   OQS_BULK_STATS *stats);
+
+#endif
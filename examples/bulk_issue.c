@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/**
+ * \file
+ * \brief Issues certificates for a stream of PEM certificate requests and
+ *        public keys with a post-quantum or hybrid CA key.
+ *
+ * Usage:
+ *
+ *     oqs_bulk_issue -cakey ca.key -cacert ca.crt [-in reqs.pem]
+ *                    [-out certs.der] [-days n] [-serial n] [-threads n]
+ *                    [-md name] [-propq query] [-provider name]
+ *
+ * Certificates are written DER encoded back to back in input order. The
+ * `default` and `oqsprovider` providers are loaded unless `-provider` is
+ * given (repeatable). Throughput is reported on stderr.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/provider.h>
+
+#include "bulk_issuance.h"
+
+#define MAX_PROVIDERS 8
+
+#ifdef OQS_PROVIDER_STATIC
+extern OSSL_provider_init_fn oqs_provider_init;
+#endif
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -cakey file -cacert file [-in file] [-out file]\n"
+            "       [-days n] [-serial n] [-threads n] [-md name]\n"
+            "       [-propq query] [-provider name]...\n",
+            prog);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *cakey = NULL, *cacert = NULL, *infile = NULL, *outfile = NULL;
+    const char *mdname = NULL, *propq = NULL;
+    const char *provnames[MAX_PROVIDERS] = {"default", "oqsprovider"};
+    OSSL_PROVIDER *providers[MAX_PROVIDERS] = {NULL};
+    int nprov = 0, threads = 0, i, ret = 1;
+    long days = 365;
+    uint64_t serial = 1;
+    OSSL_LIB_CTX *libctx = NULL;
+    OQS_BULK_ISSUER *issuer = NULL;
+    OQS_BULK_STATS stats;
+    EVP_PKEY *key = NULL;
+    X509 *cert = NULL;
+    BIO *bio = NULL, *in = NULL, *out = NULL;
+
+    for (i = 1; i < argc; i++) {
+        if (i + 1 == argc) {
+            usage(argv[0]);
+            return 1;
+        } else if (strcmp(argv[i], "-cakey") == 0) {
+            cakey = argv[++i];
+        } else if (strcmp(argv[i], "-cacert") == 0) {
+            cacert = argv[++i];
+        } else if (strcmp(argv[i], "-in") == 0) {
+            infile = argv[++i];
+        } else if (strcmp(argv[i], "-out") == 0) {
+            outfile = argv[++i];
+        } else if (strcmp(argv[i], "-days") == 0) {
+            days = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-serial") == 0) {
+            serial = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-threads") == 0) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-md") == 0) {
+            mdname = argv[++i];
+        } else if (strcmp(argv[i], "-propq") == 0) {
+            propq = argv[++i];
+        } else if (strcmp(argv[i], "-provider") == 0 &&
+                   nprov < MAX_PROVIDERS) {
+            provnames[nprov++] = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (cakey == NULL || cacert == NULL) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (nprov == 0)
+        nprov = 2;
+
+    if ((libctx = OSSL_LIB_CTX_new()) == NULL)
+        goto end;
+#ifdef OQS_PROVIDER_STATIC
+    if (!OSSL_PROVIDER_add_builtin(libctx, "oqsprovider", oqs_provider_init))
+        goto end;
+#endif
+    for (i = 0; i < nprov; i++) {
+        if ((providers[i] = OSSL_PROVIDER_load(libctx, provnames[i])) ==
+            NULL) {
+            fprintf(stderr, "Cannot load provider %s\n", provnames[i]);
+            goto end;
+        }
+    }
+
+    if ((bio = BIO_new_file(cakey, "r")) == NULL ||
+        (key = PEM_read_bio_PrivateKey_ex(bio, NULL, NULL, NULL, libctx,
+                                          propq)) == NULL) {
+        fprintf(stderr, "Cannot read CA key from %s\n", cakey);
+        goto end;
+    }
+    BIO_free(bio);
+    if ((bio = BIO_new_file(cacert, "r")) == NULL ||
+        (cert = X509_new_ex(libctx, propq)) == NULL ||
+        PEM_read_bio_X509(bio, &cert, NULL, NULL) == NULL) {
+        fprintf(stderr, "Cannot read CA certificate from %s\n", cacert);
+        goto end;
+    }
+
+    in = infile != NULL ? BIO_new_file(infile, "r")
+                        : BIO_new_fp(stdin, BIO_NOCLOSE);
+    out = outfile != NULL ? BIO_new_file(outfile, "wb")
+                          : BIO_new_fp(stdout, BIO_NOCLOSE);
+    if (in == NULL || out == NULL) {
+        fprintf(stderr, "Cannot open input or output\n");
+        goto end;
+    }
+
+    if ((issuer = oqs_bulk_issuer_new(libctx, propq, key, cert, mdname,
+                                      threads)) == NULL) {
+        fprintf(stderr, "Cannot set up issuer; CA key and certificate "
+                        "matching?\n");
+        goto end;
+    }
+    oqs_bulk_issuer_set_validity(issuer, days);
+    oqs_bulk_issuer_set_serial(issuer, serial);
+    if (!oqs_bulk_issue(issuer, in, out, &stats) || BIO_flush(out) <= 0) {
+        fprintf(stderr, "Issuance aborted\n");
+        goto end;
+    }
+
+    fprintf(stderr,
+            "%llu certificates issued, %llu inputs skipped in %.2f s "
+            "with %d signing threads\n",
+            (unsigned long long)stats.issued, (unsigned long long)stats.failed,
+            stats.seconds, stats.threads);
+    if (stats.seconds > 0 && stats.cpu_seconds > 0)
+        fprintf(stderr,
+                "%.1f certificates/s, %.1f certificates/s per core "
+                "(%.1f per CPU second)\n",
+                stats.issued / stats.seconds,
+                stats.issued / stats.seconds /
+                    (stats.threads > 0 ? stats.threads : 1),
+                stats.issued / stats.cpu_seconds);
+    ret = stats.failed > 0;
+
+end:
+    if (ret != 0)
+        ERR_print_errors_fp(stderr);
+    oqs_bulk_issuer_free(issuer);
+    BIO_free(bio);
+    BIO_free(in);
+    BIO_free(out);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    for (i = 0; i < nprov; i++)
+        OSSL_PROVIDER_unload(providers[i]);
+    OSSL_LIB_CTX_free(libctx);
+    return ret;
+}
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/**
+ * \file
+ * \brief Bandwidth-aware choice of TLS signature algorithm and group.
+ *
+ * Walks the `TLS-GROUP` and `TLS-SIGALG` capabilities of a provider and
+ * keeps the cheapest entry meeting the security floor. Entries without
+ * size parameters, e.g. of other providers, are skipped.
+ */
+
+#include <string.h>
+
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+
+#include "tls_sizes.h"
+
+typedef struct {
+    const char *name_key, *secbits_key, *publen_key, *outlen_key;
+    unsigned int min_secbits;
+    int ncerts; /* < 0 for groups */
+    OQS_TLS_ALG *best;
+    int found;
+} PICK;
+
+static int get_uint(const OSSL_PARAM params[], const char *key,
+                    unsigned int *val)
+{
+    const OSSL_PARAM *p = OSSL_PARAM_locate_const(params, key);
+
+    return p != NULL && OSSL_PARAM_get_uint(p, val);
+}
+
+static int pick_cb(const OSSL_PARAM params[], void *arg)
+{
+    PICK *pick = arg;
+    const OSSL_PARAM *p;
+    const char *name = NULL;
+    unsigned int secbits, publen, outlen;
+    size_t cost;
+
+    if ((p = OSSL_PARAM_locate_const(params, pick->name_key)) == NULL ||
+        !OSSL_PARAM_get_utf8_string_ptr(p, &name) ||
+        !get_uint(params, pick->secbits_key, &secbits) ||
+        !get_uint(params, pick->publen_key, &publen) ||
+        !get_uint(params, pick->outlen_key, &outlen) ||
+        secbits < pick->min_secbits || publen == 0 || outlen == 0)
+        return 1;
+
+    if (pick->ncerts < 0)
+        cost = (size_t)publen + outlen;
+    else
+        cost = (size_t)pick->ncerts * (publen + outlen) + outlen;
+    if (pick->found && cost >= pick->best->cost)
+        return 1;
+    OPENSSL_strlcpy(pick->best->name, name, sizeof(pick->best->name));
+    pick->best->secbits = secbits;
+    pick->best->publen = publen;
+    pick->best->outlen = outlen;
+    pick->best->cost = cost;
+    pick->found = 1;
+    return 1;
+}
+
+int oqs_tls_smallest_algs(OSSL_PROVIDER *prov, unsigned int min_secbits,
+                          int ncerts, OQS_TLS_ALG *sigalg, OQS_TLS_ALG *group)
+{
+    PICK pick;
+    int ret = 1;
+
+    if (group != NULL) {
+        memset(group, 0, sizeof(*group));
+        memset(&pick, 0, sizeof(pick));
+        pick.name_key = OSSL_CAPABILITY_TLS_GROUP_NAME;
+        pick.secbits_key = OSSL_CAPABILITY_TLS_GROUP_SECURITY_BITS;
+        pick.publen_key = OQS_TLS_SIZES_GROUP_KEYSHARE_LEN;
+        pick.outlen_key = OQS_TLS_SIZES_GROUP_CIPHERTEXT_LEN;
+        pick.min_secbits = min_secbits;
+        pick.ncerts = -1;
+        pick.best = group;
+        if (!OSSL_PROVIDER_get_capabilities(prov, "TLS-GROUP", pick_cb,
+                                            &pick) ||
+            !pick.found)
+            ret = 0;
+    }
+    if (sigalg != NULL) {
+        memset(sigalg, 0, sizeof(*sigalg));
+#ifdef OSSL_CAPABILITY_TLS_SIGALG_NAME
+        memset(&pick, 0, sizeof(pick));
+        pick.name_key = OSSL_CAPABILITY_TLS_SIGALG_NAME;
+        pick.secbits_key = OSSL_CAPABILITY_TLS_SIGALG_SECURITY_BITS;
+        pick.publen_key = OQS_TLS_SIZES_SIGALG_PUBKEY_LEN;
+        pick.outlen_key = OQS_TLS_SIZES_SIGALG_SIG_LEN;
+        pick.min_secbits = min_secbits;
+        pick.ncerts = ncerts < 0 ? 0 : ncerts;
+        pick.best = sigalg;
+        if (!OSSL_PROVIDER_get_capabilities(prov, "TLS-SIGALG", pick_cb,
+                                            &pick) ||
+            !pick.found)
+            ret = 0;
+#else
+        ret = 0;
+#endif
+    }
+    return ret;
+}
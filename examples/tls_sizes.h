@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/**
+ * \file
+ * \brief Bandwidth-aware choice of TLS signature algorithm and group.
+ *
+ * oqsprovider publishes the bytes its algorithms put on the wire with the
+ * `TLS-GROUP` and `TLS-SIGALG` capabilities. oqs_tls_smallest_algs() reads
+ * them via OSSL_PROVIDER_get_capabilities() and picks the signature
+ * algorithm and group adding the fewest bytes to a handshake while meeting
+ * a security floor, e.g. for servers whose certificate chain and key share
+ * shall fit into the TCP initial congestion window.
+ */
+
+#ifndef OQS_TLS_SIZES_H
+#define OQS_TLS_SIZES_H
+
+#include <stddef.h>
+
+#include <openssl/provider.h>
+
+/** \brief Capability parameters with the sizes in bytes, as defined in
+ * oqs_prov.h; 0 if the provider could not determine them. */
+#define OQS_TLS_SIZES_GROUP_KEYSHARE_LEN "oqs-keyshare-len"
+#define OQS_TLS_SIZES_GROUP_CIPHERTEXT_LEN "oqs-ciphertext-len"
+#define OQS_TLS_SIZES_SIGALG_PUBKEY_LEN "oqs-pubkey-len"
+#define OQS_TLS_SIZES_SIGALG_SIG_LEN "oqs-sig-len"
+
+/** \brief A TLS group or signature algorithm with its sizes. */
+typedef struct {
+    /** \brief Name for SSL_CTX_set1_groups_list() resp.
+     * SSL_CTX_set1_sigalgs_list(). */
+    char name[64];
+    /** \brief Bits of security as published by the provider. */
+    unsigned int secbits;
+    /** \brief Group: client key share; signature algorithm: public key. */
+    size_t publen;
+    /** \brief Group: server key share (ciphertext); signature algorithm:
+     * maximum signature length. */
+    size_t outlen;
+    /** \brief Handshake bytes attributed to the algorithm: key share plus
+     * ciphertext for groups; \p ncerts times public key plus signature and
+     * one more signature (CertificateVerify) for signature algorithms. */
+    size_t cost;
+} OQS_TLS_ALG;
+
+/** \brief Picks the signature algorithm and the group of \p prov with at
+ * least \p min_secbits bits of security and the lowest cost.
+ *
+ * \param ncerts Number of certificates the server sends that carry a key
+ * of and are signed with the signature algorithm, e.g. 2 for leaf and
+ * intermediate CA certificate.
+ * \param sigalg Set to the signature algorithm chosen; may be NULL.
+ * \param group Set to the group chosen; may be NULL.
+ *
+ * On ties the algorithm listed first by the provider wins. Signature
+ * algorithms are only available with OpenSSL 3.2 and later.
+ *
+ * \returns 1 if an algorithm was found for every non-NULL output, 0
+ * otherwise. */
+int oqs_tls_smallest_algs(OSSL_PROVIDER *prov, unsigned int min_secbits,
+                          int ncerts, OQS_TLS_ALG *sigalg, OQS_TLS_ALG *group);
+
+#endif
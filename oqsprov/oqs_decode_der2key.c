@@ -133,7 +133,9 @@ ASN1_SEQUENCE(X509_PUBKEY_INTERNAL) =
  */
 struct der2key_ctx_st {
     PROV_OQS_CTX *provctx;
-    struct keytype_desc_st *desc;
+    const struct keytype_desc_st *desc;
+    /* NID of the key type; desc->evp_type or resolved at provider init */
+    int evp_type;
     /* The selection that is passed to oqs_der2key_decode() */
     int selection;
     /* Flag used to signal that a failure is fatal */
@@ -169,12 +171,12 @@ static void *oqs_der2key_decode_p8(const unsigned char **input_der,
 
     OQS_DEC_PRINTF2(
         "OQS DEC provider: oqs_der2key_decode_p8 called. Keytype: %d.\n",
-        ctx->desc->evp_type);
+        ctx->evp_type);
 
     if ((p8inf = d2i_PKCS8_PRIV_KEY_INFO(NULL, input_der, input_der_len)) !=
             NULL &&
         PKCS8_pkey_get0(NULL, NULL, NULL, &alg, p8inf) &&
-        OBJ_obj2nid(alg->algorithm) == ctx->desc->evp_type)
+        OBJ_obj2nid(alg->algorithm) == ctx->evp_type)
         key = key_from_pkcs8(p8inf, PROV_OQS_LIBCTX_OF(ctx->provctx), NULL);
     PKCS8_PRIV_KEY_INFO_free(p8inf);
 
@@ -212,7 +214,7 @@ static OSSL_FUNC_decoder_decode_fn oqs_der2key_decode;
 static OSSL_FUNC_decoder_export_object_fn der2key_export_object;
 
 static struct der2key_ctx_st *der2key_newctx(void *provctx,
-                                             struct keytype_desc_st *desc,
+                                             const struct keytype_desc_st *desc,
                                              const char *tls_name) {
     struct der2key_ctx_st *ctx = OPENSSL_zalloc(sizeof(*ctx));
 
@@ -223,11 +225,14 @@ static struct der2key_ctx_st *der2key_newctx(void *provctx,
     if (ctx != NULL) {
         ctx->provctx = provctx;
         ctx->desc = desc;
-        if (desc->evp_type == 0) {
-            ctx->desc->evp_type = OBJ_sn2nid(tls_name);
+        ctx->evp_type = desc->evp_type;
+        if (ctx->evp_type == 0) {
+            const oqs_nid_name_t *alg = oqsx_alg_desc(tls_name);
+
+            ctx->evp_type = alg != NULL ? alg->nid : OBJ_sn2nid(tls_name);
             OQS_DEC_PRINTF2("OQS DEC provider: der2key_newctx set "
                             "evp_type to %d\n",
-                            ctx->desc->evp_type);
+                            ctx->evp_type);
         }
     }
     return ctx;
@@ -286,6 +291,7 @@ static int oqs_der2key_decode(void *vctx, OSSL_CORE_BIO *cin, int selection,
     const unsigned char *derp;
     long der_len = 0;
     void *key = NULL;
+    OQSX_OP_TIMER timer = {0};
     int ok = 0;
 
     OQS_DEC_PRINTF("OQS DEC provider: oqs_der2key_decode called.\n");
@@ -311,6 +317,7 @@ static int oqs_der2key_decode(void *vctx, OSSL_CORE_BIO *cin, int selection,
         goto next;
 
     ok = 0; /* Assume that we fail */
+    oqsx_op_timer_start(&timer);
 
     if ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0) {
         derp = der;
@@ -358,6 +365,11 @@ static int oqs_der2key_decode(void *vctx, OSSL_CORE_BIO *cin, int selection,
         ctx->desc->adjust_key(key, ctx);
 
 next:
+    // rejected input counts as well; the callback below is not our time
+    oqsx_op_timer_end(&timer, "decode", ctx->desc->keytype_name,
+                      key != NULL ? ((OQSX_KEY *)key)->keytype : -1,
+                      (size_t)der_len,
+                      key != NULL ? ((OQSX_KEY *)key)->pubkeylen : 0);
     /*
      * Indicated that we successfully decoded something, or not at all.
      * Ending up "empty handed" is not an error.
@@ -424,6 +436,17 @@ static void *oqsx_d2i_PKCS8(void **key, const unsigned char **der, long der_len,
                                  (key_from_pkcs8_t *)oqsx_key_from_pkcs8);
 }
 
+/* Public keys are decoded without library context, so the implementation
+ * pin of the instance decoding them can only be checked now. */
+static int oqsx_key_check_impl(void *key, struct der2key_ctx_st *ctx) {
+    OQSX_KEY *oqsxkey = key;
+
+    // the descriptor resolved at key creation avoids OBJ table lookups
+    return oqsxkey->desc == NULL ||
+           oqsx_impl_check(PROV_OQS_LIBCTX_OF(ctx->provctx),
+                           oqsxkey->desc->oqsname);
+}
+
 static void oqsx_key_adjust(void *key, struct der2key_ctx_st *ctx) {
     OQS_DEC_PRINTF("OQS DEC provider: oqsx_key_adjust called.\n");
 
@@ -431,7 +454,7 @@ static void oqsx_key_adjust(void *key, struct der2key_ctx_st *ctx) {
 }
 
 // OQS provider uses NIDs generated at load time as EVP_type identifiers
-// so initially this must be 0 and set to a real value by OBJ_sn2nid later
+// so this must be 0; der2key_newctx looks up the real value
 
 /* ---------------------------------------------------------------------- */
 
@@ -473,8 +496,8 @@ static void oqsx_key_adjust(void *key, struct der2key_ctx_st *ctx) {
 
 #define DO_SubjectPublicKeyInfo(keytype)                                       \
     "SubjectPublicKeyInfo", 0, (OSSL_KEYMGMT_SELECT_PUBLIC_KEY), NULL, NULL,   \
-        NULL, NULL, (d2i_of_void *)oqsx_d2i_PUBKEY, NULL, oqsx_key_adjust,     \
-        (free_key_fn *)oqsx_key_free
+        NULL, NULL, (d2i_of_void *)oqsx_d2i_PUBKEY, oqsx_key_check_impl,       \
+        oqsx_key_adjust, (free_key_fn *)oqsx_key_free
 
 /*
  * MAKE_DECODER is the single driver for creating OSSL_DISPATCH tables.
@@ -494,9 +517,8 @@ static void oqsx_key_adjust(void *key, struct der2key_ctx_st *ctx) {
  *              the DO_##kind macros above, to populate the keytype_desc_st
  *              structure.
  */
-// reverted const to be able to change NID/evp_type after assignment
 #define MAKE_DECODER(oqskemhyb, keytype_name, keytype, type, kind)             \
-    static struct keytype_desc_st kind##_##keytype##_desc = {                  \
+    static const struct keytype_desc_st kind##_##keytype##_desc = {            \
         keytype_name, oqs##oqskemhyb##_##keytype##_keymgmt_functions,          \
         DO_##kind(keytype)};                                                   \
                                                                                \
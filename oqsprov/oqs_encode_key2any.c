@@ -77,6 +77,15 @@ static void free_asn1_data(int type, void *data) {
     }
 }
 
+/* Object of the key's algorithm, resolved at provider init */
+static ASN1_OBJECT *oqsx_key_obj(const void *key, int key_nid) {
+    const oqs_nid_name_t *desc = ((const OQSX_KEY *)key)->desc;
+
+    if (desc != NULL && desc->nid == key_nid)
+        return (ASN1_OBJECT *)desc->obj;
+    return OBJ_nid2obj(key_nid);
+}
+
 static PKCS8_PRIV_KEY_INFO *key_to_p8info(const void *key, int key_nid,
                                           void *params, int params_type,
                                           i2d_of_void *k2d) {
@@ -90,7 +99,7 @@ static PKCS8_PRIV_KEY_INFO *key_to_p8info(const void *key, int key_nid,
 
     if ((p8info = PKCS8_PRIV_KEY_INFO_new()) == NULL ||
         (derlen = k2d(key, &der)) <= 0 ||
-        !PKCS8_pkey_set0(p8info, OBJ_nid2obj(key_nid), 0,
+        !PKCS8_pkey_set0(p8info, oqsx_key_obj(key, key_nid), 0,
                          // doesn't work with oqs-openssl:
                          //  params_type, params,
                          // does work/interop:
@@ -159,7 +168,7 @@ static X509_PUBKEY *oqsx_key_to_pubkey(const void *key, int key_nid,
 
     if ((xpk = X509_PUBKEY_new()) == NULL || (derlen = k2d(key, &der)) <= 0 ||
         !X509_PUBKEY_set0_param(
-            xpk, OBJ_nid2obj(key_nid), V_ASN1_UNDEF,
+            xpk, oqsx_key_obj(key, key_nid), V_ASN1_UNDEF,
             NULL, // as per logic in oqs_meth.c in oqs-openssl
             der, derlen)) {
         ERR_raise(ERR_LIB_USER, ERR_R_MALLOC_FAILURE);
@@ -459,13 +468,13 @@ static int prepare_oqsx_params(const void *oqsxkey, int nid, int save,
                     "(tlsname: %s)\n",
                     nid, k->tls_name);
 
-    if (k->tls_name && OBJ_sn2nid(k->tls_name) != nid) {
+    if (k->tls_name && oqsx_key_nid(k) != nid) {
         ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_KEY);
         return 0;
     }
 
     if (nid != NID_undef) {
-        params = OBJ_nid2obj(nid);
+        params = oqsx_key_obj(k, nid);
         if (params == NULL)
             return 0;
     } else {
@@ -490,6 +499,7 @@ static int oqsx_spki_pub_to_der(const void *vxkey, unsigned char **pder) {
     int keybloblen, nid, buflen = 0;
     ASN1_OCTET_STRING oct;
     STACK_OF(ASN1_TYPE) *sk = NULL;
+    size_t arena_mark;
     int ret = 0;
 
     OQS_ENC_PRINTF("OQS ENC provider: oqsx_spki_pub_to_der called\n");
@@ -509,13 +519,14 @@ static int oqsx_spki_pub_to_der(const void *vxkey, unsigned char **pder) {
     } else {
         if ((sk = sk_ASN1_TYPE_new_null()) == NULL)
             return -1;
+        arena_mark = oqsx_arena_mark();
         ASN1_TYPE **aType =
-            OPENSSL_malloc(oqsxkey->numkeys * sizeof(ASN1_TYPE *));
+            oqsx_arena_alloc(oqsxkey->numkeys * sizeof(ASN1_TYPE *));
         ASN1_BIT_STRING **aString =
-            OPENSSL_malloc(oqsxkey->numkeys * sizeof(ASN1_BIT_STRING *));
+            oqsx_arena_alloc(oqsxkey->numkeys * sizeof(ASN1_BIT_STRING *));
         unsigned char **temp =
-            OPENSSL_malloc(oqsxkey->numkeys * sizeof(unsigned char *));
-        size_t *templen = OPENSSL_malloc(oqsxkey->numkeys * sizeof(size_t));
+            oqsx_arena_alloc(oqsxkey->numkeys * sizeof(unsigned char *));
+        size_t *templen = oqsx_arena_alloc(oqsxkey->numkeys * sizeof(size_t));
         int i;
 
         for (i = 0; i < oqsxkey->numkeys; i++) {
@@ -524,7 +535,7 @@ static int oqsx_spki_pub_to_der(const void *vxkey, unsigned char **pder) {
             temp[i] = NULL;
 
             buflen = oqsxkey->pubkeylen_cmp[i];
-            buf = OPENSSL_secure_malloc(buflen);
+            buf = oqsx_arena_alloc(buflen);
             memcpy(buf, oqsxkey->comp_pubkey[i], buflen);
 
             oct.data = buf;
@@ -544,14 +555,15 @@ static int oqsx_spki_pub_to_der(const void *vxkey, unsigned char **pder) {
                 }
 
                 sk_ASN1_TYPE_pop_free(sk, &ASN1_TYPE_free);
-                OPENSSL_secure_clear_free(buf, buflen);
-                OPENSSL_free(aType);
-                OPENSSL_free(aString);
-                OPENSSL_free(temp);
-                OPENSSL_free(templen);
+                oqsx_arena_free(buf, buflen);
+                oqsx_arena_free(aType, 0);
+                oqsx_arena_free(aString, 0);
+                oqsx_arena_free(temp, 0);
+                oqsx_arena_free(templen, 0);
+                oqsx_arena_release(arena_mark, 0);
                 return -1;
             }
-            OPENSSL_secure_clear_free(buf, buflen);
+            oqsx_arena_free(buf, buflen);
         }
         keybloblen = i2d_ASN1_SEQUENCE_ANY(sk, pder);
 
@@ -564,10 +576,11 @@ static int oqsx_spki_pub_to_der(const void *vxkey, unsigned char **pder) {
         }
 
         sk_ASN1_TYPE_pop_free(sk, &ASN1_TYPE_free);
-        OPENSSL_free(aType);
-        OPENSSL_free(aString);
-        OPENSSL_free(temp);
-        OPENSSL_free(templen);
+        oqsx_arena_free(aType, 0);
+        oqsx_arena_free(aString, 0);
+        oqsx_arena_free(temp, 0);
+        oqsx_arena_free(templen, 0);
+        oqsx_arena_release(arena_mark, 0);
 
         return keybloblen;
     }
@@ -580,6 +593,7 @@ static int oqsx_pki_priv_to_der(const void *vxkey, unsigned char **pder) {
     ASN1_OCTET_STRING oct;
     int keybloblen, nid;
     STACK_OF(ASN1_TYPE) *sk = NULL;
+    size_t arena_mark = oqsx_arena_mark();
     char *name;
 
     OQS_ENC_PRINTF("OQS ENC provider: oqsx_pki_priv_to_der called\n");
@@ -655,17 +669,19 @@ static int oqsx_pki_priv_to_der(const void *vxkey, unsigned char **pder) {
         OPENSSL_secure_clear_free(buf, buflen);
     } else {
         ASN1_TYPE **aType =
-            OPENSSL_malloc(oqsxkey->numkeys * sizeof(ASN1_TYPE *));
+            oqsx_arena_alloc(oqsxkey->numkeys * sizeof(ASN1_TYPE *));
         ASN1_OCTET_STRING **aString =
-            OPENSSL_malloc(oqsxkey->numkeys * sizeof(ASN1_OCTET_STRING *));
+            oqsx_arena_alloc(oqsxkey->numkeys * sizeof(ASN1_OCTET_STRING *));
         unsigned char **temp =
-            OPENSSL_malloc(oqsxkey->numkeys * sizeof(unsigned char *));
-        size_t *templen = OPENSSL_malloc(oqsxkey->numkeys * sizeof(size_t));
+            oqsx_arena_alloc(oqsxkey->numkeys * sizeof(unsigned char *));
+        size_t *templen = oqsx_arena_alloc(oqsxkey->numkeys * sizeof(size_t));
         PKCS8_PRIV_KEY_INFO *p8inf_internal = NULL;
         int i;
 
-        if ((sk = sk_ASN1_TYPE_new_null()) == NULL)
+        if ((sk = sk_ASN1_TYPE_new_null()) == NULL) {
+            oqsx_arena_release(arena_mark, 1);
             return -1;
+        }
 
         for (i = 0; i < oqsxkey->numkeys; i++) {
             aType[i] = ASN1_TYPE_new();
@@ -675,8 +691,7 @@ static int oqsx_pki_priv_to_der(const void *vxkey, unsigned char **pder) {
             int nid, version;
             void *pval;
 
-            if ((name = get_cmpname(OBJ_sn2nid(oqsxkey->tls_name), i)) ==
-                NULL) {
+            if ((name = oqsx_key_cmpname(oqsxkey, i)) == NULL) {
                 for (int j = 0; j <= i; j++) {
                     OPENSSL_cleanse(aString[j]->data, aString[j]->length);
                     ASN1_OCTET_STRING_free(aString[j]);
@@ -691,11 +706,12 @@ static int oqsx_pki_priv_to_der(const void *vxkey, unsigned char **pder) {
                 else
                     ASN1_TYPE_free(aType[i]);
 
-                OPENSSL_free(aType);
-                OPENSSL_free(aString);
-                OPENSSL_free(temp);
-                OPENSSL_free(templen);
+                oqsx_arena_free(aType, 0);
+                oqsx_arena_free(aString, 0);
+                oqsx_arena_free(temp, 0);
+                oqsx_arena_free(templen, 0);
                 PKCS8_PRIV_KEY_INFO_free(p8inf_internal);
+                oqsx_arena_release(arena_mark, 1);
                 return -1;
             }
 
@@ -725,18 +741,20 @@ static int oqsx_pki_priv_to_der(const void *vxkey, unsigned char **pder) {
                         else
                             ASN1_TYPE_free(aType[i]);
 
-                        OPENSSL_free(aType);
-                        OPENSSL_free(aString);
-                        OPENSSL_free(temp);
-                        OPENSSL_free(templen);
+                        oqsx_arena_free(aType, 0);
+                        oqsx_arena_free(aString, 0);
+                        oqsx_arena_free(temp, 0);
+                        oqsx_arena_free(templen, 0);
                         PKCS8_PRIV_KEY_INFO_free(p8inf_internal);
                         OPENSSL_free(name);
+                        oqsx_arena_release(arena_mark, 1);
                         return -1;
                     }
                 } else
                     buflen = oqsxkey->privkeylen_cmp[i];
             } else {
-                nid = OBJ_sn2nid(name);
+                nid = oqsxkey->desc != NULL ? oqsxkey->desc->cmp_nid[i]
+                                            : OBJ_sn2nid(name);
                 buflen = oqsxkey->privkeylen_cmp[i] + oqsxkey->pubkeylen_cmp[i];
             }
 
@@ -756,13 +774,14 @@ static int oqsx_pki_priv_to_der(const void *vxkey, unsigned char **pder) {
                 else
                     ASN1_TYPE_free(aType[i]);
 
-                OPENSSL_free(aType);
-                OPENSSL_free(aString);
-                OPENSSL_free(temp);
-                OPENSSL_free(templen);
+                oqsx_arena_free(aType, 0);
+                oqsx_arena_free(aString, 0);
+                oqsx_arena_free(temp, 0);
+                oqsx_arena_free(templen, 0);
                 PKCS8_PRIV_KEY_INFO_free(p8inf_internal);
                 OPENSSL_free(name);
                 ERR_raise(ERR_LIB_USER, ERR_R_MALLOC_FAILURE);
+                oqsx_arena_release(arena_mark, 1);
                 return -1;
             }
             if (get_oqsname_fromtls(name) !=
@@ -798,15 +817,16 @@ static int oqsx_pki_priv_to_der(const void *vxkey, unsigned char **pder) {
 
                 sk_ASN1_TYPE_pop_free(sk, &ASN1_TYPE_free);
                 OPENSSL_free(name);
-                OPENSSL_free(aType);
-                OPENSSL_free(aString);
-                OPENSSL_free(temp);
-                OPENSSL_free(templen);
+                oqsx_arena_free(aType, 0);
+                oqsx_arena_free(aString, 0);
+                oqsx_arena_free(temp, 0);
+                oqsx_arena_free(templen, 0);
                 OPENSSL_cleanse(buf,
                                 buflen); // buf is part of p8inf_internal so we
                                          // cant free now, we cleanse it to
                                          // remove pkey from memory
                 PKCS8_PRIV_KEY_INFO_free(p8inf_internal); // this also free buf
+                oqsx_arena_release(arena_mark, 1);
                 return -1;
             }
 
@@ -831,15 +851,16 @@ static int oqsx_pki_priv_to_der(const void *vxkey, unsigned char **pder) {
 
                 sk_ASN1_TYPE_pop_free(sk, &ASN1_TYPE_free);
                 OPENSSL_free(name);
-                OPENSSL_free(aType);
-                OPENSSL_free(aString);
-                OPENSSL_free(temp);
-                OPENSSL_free(templen);
+                oqsx_arena_free(aType, 0);
+                oqsx_arena_free(aString, 0);
+                oqsx_arena_free(temp, 0);
+                oqsx_arena_free(templen, 0);
                 OPENSSL_cleanse(buf,
                                 buflen); // buf is part of p8inf_internal so we
                                          // cant free now, we cleanse it to
                                          // remove pkey from memory
                 PKCS8_PRIV_KEY_INFO_free(p8inf_internal); // this also free buf
+                oqsx_arena_release(arena_mark, 1);
                 return -1;
             }
             OPENSSL_free(name);
@@ -858,10 +879,11 @@ static int oqsx_pki_priv_to_der(const void *vxkey, unsigned char **pder) {
         }
 
         sk_ASN1_TYPE_pop_free(sk, &ASN1_TYPE_free);
-        OPENSSL_free(aType);
-        OPENSSL_free(aString);
-        OPENSSL_free(temp);
-        OPENSSL_free(templen);
+        oqsx_arena_free(aType, 0);
+        oqsx_arena_free(aString, 0);
+        oqsx_arena_free(temp, 0);
+        oqsx_arena_free(templen, 0);
+        oqsx_arena_release(arena_mark, 1);
     }
     return keybloblen;
 }
@@ -1354,8 +1376,15 @@ static int key2any_encode(struct key2any_ctx_st *ctx, OSSL_CORE_BIO *cout,
                           key_to_paramstring_fn *key2paramstring,
                           i2d_of_void *key2der) {
     int ret = 0;
-    int type = OBJ_sn2nid(typestr);
     OQSX_KEY *oqsk = (OQSX_KEY *)key;
+    OQSX_OP_TIMER timer;
+    int type;
+
+    if (oqsk != NULL && oqsk->desc != NULL &&
+        !strcmp(oqsk->desc->tlsname, typestr))
+        type = oqsk->desc->nid;
+    else
+        type = OBJ_sn2nid(typestr);
 
     OQS_ENC_PRINTF3(
         "OQS ENC provider: key2any_encode called with type %d (%s)\n", type,
@@ -1374,8 +1403,14 @@ static int key2any_encode(struct key2any_ctx_st *ctx, OSSL_CORE_BIO *cout,
             ctx->pwcb = pwcb;
             ctx->pwcbarg = pwcbarg;
 
+            oqsx_op_timer_start(&timer);
             ret =
                 writer(out, key, type, pemname, key2paramstring, key2der, ctx);
+            oqsx_op_timer_end(&timer, "encode", oqsk->tls_name, oqsk->keytype,
+                              strstr(pemname, "PRIVATE") != NULL
+                                  ? oqsk->privkeylen
+                                  : oqsk->pubkeylen,
+                              BIO_number_written(out));
         }
 
         BIO_free(out);
@@ -1672,8 +1707,7 @@ static int oqsx_to_text(BIO *out, const void *key, int selection) {
                 int i;
                 uint32_t privlen = 0;
                 for (i = 0; i < okey->numkeys; i++) {
-                    if ((name = get_cmpname(OBJ_sn2nid(okey->tls_name), i)) ==
-                        NULL) {
+                    if ((name = oqsx_key_cmpname(okey, i)) == NULL) {
                         ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_KEY);
                         return 0;
                     }
@@ -1747,8 +1781,7 @@ static int oqsx_to_text(BIO *out, const void *key, int selection) {
                 char label[200];
                 int i;
                 for (i = 0; i < okey->numkeys; i++) {
-                    if ((name = get_cmpname(OBJ_sn2nid(okey->tls_name), i)) ==
-                        NULL) {
+                    if ((name = oqsx_key_cmpname(okey, i)) == NULL) {
                         ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_KEY);
                         return 0;
                     }
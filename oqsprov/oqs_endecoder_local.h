@@ -29,3 +29,5 @@ void *oqs_prov_import_key(const OSSL_DISPATCH *fns, void *provctx,
 void oqs_prov_free_key(const OSSL_DISPATCH *fns, void *key);
 int oqs_read_der(PROV_OQS_CTX *provctx, OSSL_CORE_BIO *cin,
                  unsigned char **data, long *len);
+X509_PUBKEY *oqsx_d2i_X509_PUBKEY_INTERNAL(const unsigned char **pp, long len,
+                                           OSSL_LIB_CTX *libctx);
@@ -28,7 +28,6 @@ static int oqs_evp_kem_encaps_keyslot(void *vpkemctx, unsigned char *ct,
     EVP_PKEY_CTX *ctx = NULL, *kgctx = NULL;
     ;
     EVP_PKEY *pkey = NULL, *peerpk = NULL;
-    unsigned char *ctkex_encoded = NULL;
 
     pubkey_kexlen = evp_ctx->evp_info->length_public_key;
     kexDeriveLen = evp_ctx->evp_info->kex_length_secret;
@@ -72,18 +71,16 @@ static int oqs_evp_kem_encaps_keyslot(void *vpkemctx, unsigned char *ct,
     ret = EVP_PKEY_derive(ctx, secret, &kexDeriveLen);
     ON_ERR_SET_GOTO(ret <= 0, ret, -1, err);
 
-    pkeylen = EVP_PKEY_get1_encoded_public_key(pkey, &ctkex_encoded);
-    ON_ERR_SET_GOTO(pkeylen <= 0 || !ctkex_encoded || pkeylen != pubkey_kexlen,
-                    ret, -1, err);
-
-    memcpy(ct, ctkex_encoded, pkeylen);
+    // encode the ephemeral public key right into ct, without a temporary
+    ret2 = EVP_PKEY_get_octet_string_param(
+        pkey, OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, ct, pubkey_kexlen, &pkeylen);
+    ON_ERR_SET_GOTO(ret2 <= 0 || pkeylen != pubkey_kexlen, ret, -1, err);
 
 err:
     EVP_PKEY_CTX_free(ctx);
     EVP_PKEY_CTX_free(kgctx);
     EVP_PKEY_free(pkey);
     EVP_PKEY_free(peerpk);
-    OPENSSL_free(ctkex_encoded);
     return ret;
 }
 
@@ -156,6 +153,7 @@ static int oqs_hyb_kem_encaps(void *vpkemctx, unsigned char *ct, size_t *ctlen,
     size_t secretLen0 = 0, secretLen1 = 0;
     size_t ctLen0 = 0, ctLen1 = 0;
     unsigned char *ct0, *ct1, *secret0, *secret1;
+    OQSX_OP_TIMER timer;
 
     ret = oqs_evp_kem_encaps_keyslot(vpkemctx, NULL, &ctLen0, NULL, &secretLen0,
                                      0);
@@ -178,14 +176,21 @@ static int oqs_hyb_kem_encaps(void *vpkemctx, unsigned char *ct, size_t *ctlen,
     secret0 = secret;
     secret1 = secret + secretLen0;
 
+    oqsx_op_timer_start(&timer);
     ret = oqs_evp_kem_encaps_keyslot(vpkemctx, ct0, &ctLen0, secret0,
                                      &secretLen0, 0);
-    ON_ERR_SET_GOTO(ret <= 0, ret, OQS_ERROR, err);
+    oqsx_op_timer_lap(&timer, OQSX_LAP_CLASSIC);
+    ON_ERR_SET_GOTO(ret <= 0, ret, OQS_ERROR, end);
 
     ret = oqs_qs_kem_encaps_keyslot(vpkemctx, ct1, &ctLen1, secret1,
                                     &secretLen1, 1);
-    ON_ERR_SET_GOTO(ret <= 0, ret, OQS_ERROR, err);
+    oqsx_op_timer_lap(&timer, OQSX_LAP_PQ);
+    ON_ERR_SET_GOTO(ret <= 0, ret, OQS_ERROR, end);
 
+end:
+    oqsx_op_timer_end(&timer, "encaps", pkemctx->kem->tls_name,
+                      pkemctx->kem->keytype, pkemctx->kem->pubkeylen,
+                      ret > 0 ? *ctlen : 0);
 err:
     return ret;
 }
@@ -202,6 +207,7 @@ static int oqs_hyb_kem_decaps(void *vpkemctx, unsigned char *secret,
     size_t ctLen0 = 0, ctLen1 = 0;
     const unsigned char *ct0, *ct1;
     unsigned char *secret0, *secret1;
+    OQSX_OP_TIMER timer;
 
     ret = oqs_evp_kem_decaps_keyslot(vpkemctx, NULL, &secretLen0, NULL, 0, 0);
     ON_ERR_SET_GOTO(ret <= 0, ret, OQS_ERROR, err);
@@ -223,13 +229,19 @@ static int oqs_hyb_kem_decaps(void *vpkemctx, unsigned char *secret,
     secret0 = secret;
     secret1 = secret + secretLen0;
 
+    oqsx_op_timer_start(&timer);
     ret = oqs_evp_kem_decaps_keyslot(vpkemctx, secret0, &secretLen0, ct0,
                                      ctLen0, 0);
-    ON_ERR_SET_GOTO(ret <= 0, ret, OQS_ERROR, err);
+    oqsx_op_timer_lap(&timer, OQSX_LAP_CLASSIC);
+    ON_ERR_SET_GOTO(ret <= 0, ret, OQS_ERROR, end);
     ret = oqs_qs_kem_decaps_keyslot(vpkemctx, secret1, &secretLen1, ct1, ctLen1,
                                     1);
-    ON_ERR_SET_GOTO(ret <= 0, ret, OQS_ERROR, err);
+    oqsx_op_timer_lap(&timer, OQSX_LAP_PQ);
+    ON_ERR_SET_GOTO(ret <= 0, ret, OQS_ERROR, end);
 
+end:
+    oqsx_op_timer_end(&timer, "decaps", pkemctx->kem->tls_name,
+                      pkemctx->kem->keytype, ctlen, ret > 0 ? *secretlen : 0);
 err:
     return ret;
 }
@@ -88,12 +88,19 @@ static int oqs_kem_decapsencaps_init(void *vpkemctx, void *vkem,
 static int oqs_kem_encaps_init(void *vpkemctx, void *vkem,
                                const OSSL_PARAM params[]) {
     OQS_KEM_PRINTF("OQS KEM provider called: encaps_init\n");
+    if (vkem == NULL || !oqsx_key_encaps_check(vkem))
+        return 0;
     return oqs_kem_decapsencaps_init(vpkemctx, vkem, EVP_PKEY_OP_ENCAPSULATE);
 }
 
 static int oqs_kem_decaps_init(void *vpkemctx, void *vkem,
                                const OSSL_PARAM params[]) {
     OQS_KEM_PRINTF("OQS KEM provider called: decaps_init\n");
+    // also refuses keys without key material, see oqsx_genkey
+    if (vkem == NULL || ((OQSX_KEY *)vkem)->privkey == NULL) {
+        ERR_raise(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS);
+        return 0;
+    }
     return oqs_kem_decapsencaps_init(vpkemctx, vkem, EVP_PKEY_OP_DECAPSULATE);
 }
 
@@ -198,13 +205,36 @@ static int oqs_qs_kem_decaps_keyslot(void *vpkemctx, unsigned char *out,
 
 static int oqs_qs_kem_encaps(void *vpkemctx, unsigned char *out, size_t *outlen,
                              unsigned char *secret, size_t *secretlen) {
-    return oqs_qs_kem_encaps_keyslot(vpkemctx, out, outlen, secret, secretlen,
-                                     0);
+    const OQSX_KEY *kem = ((PROV_OQSKEM_CTX *)vpkemctx)->kem;
+    OQSX_OP_TIMER timer;
+    int ret;
+
+    if (out == NULL || secret == NULL)
+        return oqs_qs_kem_encaps_keyslot(vpkemctx, out, outlen, secret,
+                                         secretlen, 0);
+    oqsx_op_timer_start(&timer);
+    ret = oqs_qs_kem_encaps_keyslot(vpkemctx, out, outlen, secret, secretlen,
+                                    0);
+    oqsx_op_timer_lap(&timer, OQSX_LAP_PQ);
+    oqsx_op_timer_end(&timer, "encaps", kem->tls_name, kem->keytype,
+                      kem->pubkeylen, ret > 0 ? *outlen : 0);
+    return ret;
 }
 
 static int oqs_qs_kem_decaps(void *vpkemctx, unsigned char *out, size_t *outlen,
                              const unsigned char *in, size_t inlen) {
-    return oqs_qs_kem_decaps_keyslot(vpkemctx, out, outlen, in, inlen, 0);
+    const OQSX_KEY *kem = ((PROV_OQSKEM_CTX *)vpkemctx)->kem;
+    OQSX_OP_TIMER timer;
+    int ret;
+
+    if (out == NULL)
+        return oqs_qs_kem_decaps_keyslot(vpkemctx, out, outlen, in, inlen, 0);
+    oqsx_op_timer_start(&timer);
+    ret = oqs_qs_kem_decaps_keyslot(vpkemctx, out, outlen, in, inlen, 0);
+    oqsx_op_timer_lap(&timer, OQSX_LAP_PQ);
+    oqsx_op_timer_end(&timer, "decaps", kem->tls_name, kem->keytype, inlen,
+                      ret > 0 ? *outlen : 0);
+    return ret;
 }
 
 #include "oqs_hyb_kem.c"
@@ -63,6 +63,7 @@ static OSSL_FUNC_keymgmt_set_params_fn oqsx_set_params;
 static OSSL_FUNC_keymgmt_settable_params_fn oqsx_settable_params;
 static OSSL_FUNC_keymgmt_has_fn oqsx_has;
 static OSSL_FUNC_keymgmt_match_fn oqsx_match;
+static OSSL_FUNC_keymgmt_validate_fn oqsx_validate;
 static OSSL_FUNC_keymgmt_import_fn oqsx_import;
 static OSSL_FUNC_keymgmt_import_types_fn oqs_imexport_types;
 static OSSL_FUNC_keymgmt_export_fn oqsx_export;
@@ -78,6 +79,7 @@ struct oqsx_gen_ctx {
     int selection;
     int bit_security;
     int alg_idx;
+    int tls_group; /* group name set, as libssl does for key shares */
 };
 
 static int oqsx_has(const void *keydata, int selection) {
@@ -168,6 +170,7 @@ static int oqsx_match(const void *keydata1, const void *keydata2,
         } else {
             ok = ((key1->privkey == NULL && key2->privkey == NULL) ||
                   ((key1->privkey != NULL) &&
+                   key1->privkeylen == key2->privkeylen &&
                    CRYPTO_memcmp(key1->privkey, key2->privkey,
                                  key1->privkeylen) == 0));
         }
@@ -182,11 +185,13 @@ static int oqsx_match(const void *keydata1, const void *keydata2,
             // requested, consider private key match sufficient:
             ok = ((selection & OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) != 0) &&
                  (key1->privkey != NULL && key2->privkey != NULL) &&
+                 key1->privkeylen == key2->privkeylen &&
                  (CRYPTO_memcmp(key1->privkey, key2->privkey,
                                 key1->privkeylen) == 0);
         } else {
             ok = ok && ((key1->pubkey == NULL && key2->pubkey == NULL) ||
                         ((key1->pubkey != NULL) &&
+                         key1->pubkeylen == key2->pubkeylen &&
                          CRYPTO_memcmp(key1->pubkey, key2->pubkey,
                                        key1->pubkeylen) == 0));
         }
@@ -196,6 +201,21 @@ static int oqsx_match(const void *keydata1, const void *keydata2,
     return ok;
 }
 
+/*
+ * Validation results are recorded in the key, so only the first check of a
+ * given selection does any work; this also keeps the input checks done on
+ * every encapsulation cheap.
+ */
+static int oqsx_validate(const void *keydata, int selection, int checktype) {
+    OQSX_KEY *key = (OQSX_KEY *)keydata;
+
+    OQS_KM_PRINTF3("OQSKEYMGMT: validate called with selection %2x, type %d\n",
+                   selection, checktype);
+    if (key == NULL)
+        return 0;
+    return oqsx_key_validate(key, selection, checktype);
+}
+
 static int oqsx_import(void *keydata, int selection,
                        const OSSL_PARAM params[]) {
     OQSX_KEY *key = keydata;
@@ -376,11 +396,11 @@ static int oqsx_get_hybrid_params(OQSX_KEY *key, OSSL_PARAM params[]) {
         DECODE_UINT32(classical_privkey_len, key->privkey);
     }
 
-    if (key->comp_pubkey[1] != NULL) {
+    if (key->comp_pubkey != NULL && key->pubkey != NULL) {
         pq_pubkey = key->comp_pubkey[1];
         pq_pubkey_len = key->pubkeylen - classical_pubkey_len - SIZE_OF_UINT32;
     }
-    if (key->comp_privkey != NULL) {
+    if (key->comp_privkey != NULL && key->privkey != NULL) {
         pq_privkey = key->comp_privkey[1];
         pq_privkey_len =
             key->privkeylen - classical_privkey_len - SIZE_OF_UINT32;
@@ -440,8 +460,10 @@ static int oqsx_get_params(void *key, OSSL_PARAM params[]) {
         return 0;
     /* end workaround */
 
+    // keys without key material (see oqsx_genkey) leave these unanswered
     if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY)) !=
-        NULL) {
+            NULL &&
+        oqsxk->pubkey != NULL) {
         // hybrid KEMs are special in that the classic length information
         // shall not be passed out:
         if (oqsxk->keytype == KEY_TYPE_ECP_HYB_KEM ||
@@ -456,11 +478,13 @@ static int oqsx_get_params(void *key, OSSL_PARAM params[]) {
                 return 0;
         }
     }
-    if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_PUB_KEY)) != NULL) {
+    if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_PUB_KEY)) != NULL &&
+        oqsxk->pubkey != NULL) {
         if (!OSSL_PARAM_set_octet_string(p, oqsxk->pubkey, oqsxk->pubkeylen))
             return 0;
     }
-    if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_PRIV_KEY)) != NULL) {
+    if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_PRIV_KEY)) != NULL &&
+        oqsxk->privkey != NULL) {
         if (!OSSL_PARAM_set_octet_string(p, oqsxk->privkey, oqsxk->privkeylen))
             return 0;
     }
@@ -502,6 +526,7 @@ static int set_property_query(OQSX_KEY *oqsxkey, const char *propq) {
 static int oqsx_set_params(void *key, const OSSL_PARAM params[]) {
     OQSX_KEY *oqsxkey = key;
     const OSSL_PARAM *p;
+    size_t i;
 
     OQS_KM_PRINTF("OQSKEYMGMT: set_params called\n");
     if (oqsxkey == NULL) {
@@ -512,8 +537,16 @@ static int oqsx_set_params(void *key, const OSSL_PARAM params[]) {
     if (p != NULL) {
         size_t used_len;
         int classic_pubkey_len;
-        if (oqsxkey->keytype == KEY_TYPE_ECP_HYB_KEM ||
-            oqsxkey->keytype == KEY_TYPE_ECX_HYB_KEM) {
+        int hybrid = oqsxkey->keytype == KEY_TYPE_ECP_HYB_KEM ||
+                     oqsxkey->keytype == KEY_TYPE_ECX_HYB_KEM;
+
+        // keys without key material (see oqsx_genkey) get their public key
+        // buffer here; the key share is copied in once
+        if (oqsxkey->pubkey == NULL &&
+            (p->data_size != oqsxkey->pubkeylen - hybrid * SIZE_OF_UINT32 ||
+             !oqsx_key_allocate_pubkey(oqsxkey)))
+            return 0;
+        if (hybrid) {
             // classic key len already stored by key setup; only data
             // needs to be filled in
             if (p->data_size != oqsxkey->pubkeylen - SIZE_OF_UINT32 ||
@@ -531,6 +564,9 @@ static int oqsx_set_params(void *key, const OSSL_PARAM params[]) {
         }
         OPENSSL_clear_free(oqsxkey->privkey, oqsxkey->privkeylen);
         oqsxkey->privkey = NULL;
+        for (i = 0; i < oqsxkey->numkeys; i++)
+            oqsxkey->comp_privkey[i] = NULL;
+        oqsxkey->validated = 0;
     }
     p = OSSL_PARAM_locate_const(params, OSSL_PKEY_PARAM_PROPERTIES);
     if (p != NULL) {
@@ -590,6 +626,16 @@ static void *oqsx_genkey(struct oqsx_gen_ctx *gctx) {
         return NULL;
     }
 
+    // TLS servers create the key for a received key share by parameter
+    // generation for the group and then set its encoded public key, so a
+    // KEM key pair generated here would be thrown away right after. Other
+    // parameter generation still returns complete keys.
+    if ((gctx->selection & OSSL_KEYMGMT_SELECT_KEYPAIR) == 0 &&
+        gctx->tls_group &&
+        (key->keytype == KEY_TYPE_KEM || key->keytype == KEY_TYPE_ECP_HYB_KEM ||
+         key->keytype == KEY_TYPE_ECX_HYB_KEM))
+        return key;
+
     if (oqsx_key_gen(key)) {
         ERR_raise(ERR_LIB_USER, OQSPROV_UNEXPECTED_NULL);
         return NULL;
@@ -651,6 +697,7 @@ static int oqsx_gen_set_params(void *genctx, const OSSL_PARAM params[]) {
 
         OPENSSL_free(gctx->tls_name);
         gctx->tls_name = OPENSSL_strdup(algname);
+        gctx->tls_group = 1;
     }
     p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_PROPERTIES);
     if (p != NULL) {
@@ -1223,6 +1270,7 @@ static void *p521_mayo5_gen_init(void *provctx, int selection) {
         {OSSL_FUNC_KEYMGMT_SET_PARAMS, (void (*)(void))oqsx_set_params},       \
         {OSSL_FUNC_KEYMGMT_HAS, (void (*)(void))oqsx_has},                     \
         {OSSL_FUNC_KEYMGMT_MATCH, (void (*)(void))oqsx_match},                 \
+        {OSSL_FUNC_KEYMGMT_VALIDATE, (void (*)(void))oqsx_validate},           \
         {OSSL_FUNC_KEYMGMT_IMPORT, (void (*)(void))oqsx_import},               \
         {OSSL_FUNC_KEYMGMT_IMPORT_TYPES, (void (*)(void))oqs_imexport_types},  \
         {OSSL_FUNC_KEYMGMT_EXPORT, (void (*)(void))oqsx_export},               \
@@ -1261,6 +1309,7 @@ static void *p521_mayo5_gen_init(void *provctx, int selection) {
         {OSSL_FUNC_KEYMGMT_SET_PARAMS, (void (*)(void))oqsx_set_params},       \
         {OSSL_FUNC_KEYMGMT_HAS, (void (*)(void))oqsx_has},                     \
         {OSSL_FUNC_KEYMGMT_MATCH, (void (*)(void))oqsx_match},                 \
+        {OSSL_FUNC_KEYMGMT_VALIDATE, (void (*)(void))oqsx_validate},           \
         {OSSL_FUNC_KEYMGMT_IMPORT, (void (*)(void))oqsx_import},               \
         {OSSL_FUNC_KEYMGMT_IMPORT_TYPES, (void (*)(void))oqs_imexport_types},  \
         {OSSL_FUNC_KEYMGMT_EXPORT, (void (*)(void))oqsx_export},               \
@@ -1299,6 +1348,7 @@ static void *p521_mayo5_gen_init(void *provctx, int selection) {
         {OSSL_FUNC_KEYMGMT_SET_PARAMS, (void (*)(void))oqsx_set_params},       \
         {OSSL_FUNC_KEYMGMT_HAS, (void (*)(void))oqsx_has},                     \
         {OSSL_FUNC_KEYMGMT_MATCH, (void (*)(void))oqsx_match},                 \
+        {OSSL_FUNC_KEYMGMT_VALIDATE, (void (*)(void))oqsx_validate},           \
         {OSSL_FUNC_KEYMGMT_IMPORT, (void (*)(void))oqsx_import},               \
         {OSSL_FUNC_KEYMGMT_IMPORT_TYPES, (void (*)(void))oqs_imexport_types},  \
         {OSSL_FUNC_KEYMGMT_EXPORT, (void (*)(void))oqsx_export},               \
@@ -1336,6 +1386,7 @@ static void *p521_mayo5_gen_init(void *provctx, int selection) {
         {OSSL_FUNC_KEYMGMT_SET_PARAMS, (void (*)(void))oqsx_set_params},       \
         {OSSL_FUNC_KEYMGMT_HAS, (void (*)(void))oqsx_has},                     \
         {OSSL_FUNC_KEYMGMT_MATCH, (void (*)(void))oqsx_match},                 \
+        {OSSL_FUNC_KEYMGMT_VALIDATE, (void (*)(void))oqsx_validate},           \
         {OSSL_FUNC_KEYMGMT_IMPORT, (void (*)(void))oqsx_import},               \
         {OSSL_FUNC_KEYMGMT_IMPORT_TYPES, (void (*)(void))oqs_imexport_types},  \
         {OSSL_FUNC_KEYMGMT_EXPORT, (void (*)(void))oqsx_export},               \
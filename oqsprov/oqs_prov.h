@@ -17,6 +17,7 @@
 
 #include <openssl/bio.h>
 #include <openssl/core.h>
+#include <openssl/core_dispatch.h>
 #include <openssl/core_names.h>
 #include <openssl/e_os2.h>
 #include <openssl/opensslconf.h>
@@ -57,6 +58,25 @@
 #define OQS_HYBRID_PKEY_PARAM_PQ_PUB_KEY "hybrid_pq_" OSSL_PKEY_PARAM_PUB_KEY
 #define OQS_HYBRID_PKEY_PARAM_PQ_PRIV_KEY "hybrid_pq_" OSSL_PKEY_PARAM_PRIV_KEY
 
+/* Provider parameters on liboqs implementation selection */
+#define OQS_PROV_PARAM_CPU_FEATURES "oqs-cpu-features"
+#define OQS_PROV_PARAM_IMPLEMENTATIONS "oqs-implementations"
+#define OQS_PROV_PARAM_IMPLEMENTATION_PIN "oqs-implementation-pin"
+/* Provider configuration option pinning the implementation variant */
+#define OQS_PROV_CONF_IMPLEMENTATION "implementation"
+/* Provider parameters on the slow operation log */
+#define OQS_PROV_PARAM_SLOW_OPS "oqs-slow-ops"
+#define OQS_PROV_PARAM_SLOW_OP_COUNT "oqs-slow-op-count"
+/* Provider configuration options of the slow operation log */
+#define OQS_PROV_CONF_SLOW_OP_THRESHOLD "slow-op-threshold-us"
+#define OQS_PROV_CONF_SLOW_OP_LOG_SIZE "slow-op-log-size"
+/* Bytes on the wire published with the TLS-GROUP and TLS-SIGALG
+ * capabilities; 0 if not known */
+#define OQS_CAPABILITY_TLS_GROUP_KEYSHARE_LEN "oqs-keyshare-len"
+#define OQS_CAPABILITY_TLS_GROUP_CIPHERTEXT_LEN "oqs-ciphertext-len"
+#define OQS_CAPABILITY_TLS_SIGALG_PUBKEY_LEN "oqs-pubkey-len"
+#define OQS_CAPABILITY_TLS_SIGALG_SIG_LEN "oqs-sig-len"
+
 /* Extras for OQS extension */
 
 // clang-format off
@@ -89,6 +109,12 @@ typedef struct prov_oqs_ctx_st {
     const OSSL_CORE_HANDLE *handle;
     OSSL_LIB_CTX *libctx; /* For all provider modules */
     BIO_METHOD *corebiometh;
+    /* registers the arena thread stop handler with this instance */
+    OSSL_FUNC_core_thread_start_fn *core_thread_start;
+    struct prov_oqs_ctx_st *arena_next; /* list of instances using arenas */
+    /* liboqs implementation variant pinned, NULL if none */
+    const char *impl_pin;
+    struct prov_oqs_ctx_st *impl_next; /* list of instances with a pin */
 } PROV_OQS_CTX;
 
 PROV_OQS_CTX *oqsx_newprovctx(OSSL_LIB_CTX *libctx,
@@ -145,6 +171,26 @@ enum oqsx_key_type_en {
 
 typedef enum oqsx_key_type_en OQSX_KEY_TYPE;
 
+#define OQSX_CMP_NAME_LEN 32
+
+/* Per-algorithm descriptor; the table lives in oqsprov_keys.c. NID, object
+ * and component names are filled in once per process by the first provider
+ * init and only read afterwards.
+ */
+typedef struct {
+    int nid;
+    char *tlsname;
+    char *oqsname;
+    int keytype;
+    int secbits;
+    const ASN1_OBJECT *obj;
+    /* hybrid and composite keys: component names split at the first '_'
+     * and their NIDs (NID_undef for classic components)
+     */
+    char cmp_name[2][OQSX_CMP_NAME_LEN];
+    int cmp_nid[2];
+} oqs_nid_name_t;
+
 struct oqsx_key_st {
     OSSL_LIB_CTX *libctx;
 #ifdef OQS_PROVIDER_NOATOMIC
@@ -166,11 +212,21 @@ struct oqsx_key_st {
     size_t *pubkeylen_cmp;
     size_t bit_security;
     char *tls_name;
+    const oqs_nid_name_t *desc; // NULL if tls_name has no table entry
 #ifndef OQS_PROVIDER_NOATOMIC
     _Atomic
 #endif
         int references;
 
+    /* OQSX_VALIDATED_* bits of the checks this key material already passed;
+     * cleared whenever key material is replaced
+     */
+#ifndef OQS_PROVIDER_NOATOMIC
+    _Atomic unsigned int validated;
+#else
+    uint64_t validated;
+#endif
+
     /* point to actual priv key material -- if is a hydrid, the classic key
      * will be present first, i.e., OQS key always at comp_*key[numkeys-1] - if
      * is a composite, the classic key will be presented second, i.e., OQS key
@@ -207,8 +263,21 @@ int get_composite_idx(int idx);
  */
 EVP_PKEY *setECParams(EVP_PKEY *eck, int nid);
 
-/* Register given NID with tlsname in OSSL3 registry */
-int oqs_set_nid(char *tlsname, int nid);
+/* Resolve NIDs, objects and component names of all algorithms; called at
+ * provider init after all OIDs are registered. Resolution happens once per
+ * process; the table is read-only afterwards.
+ */
+int oqsx_resolve_alg_descs(void);
+
+/* Lock-free lookups of the resolved descriptors */
+const oqs_nid_name_t *oqsx_alg_desc(const char *tlsname);
+/* Key share and ciphertext length of a KEM resp. public key and maximum
+ * signature length of a signature algorithm as sent in TLS
+ */
+int oqsx_alg_tls_sizes(const char *tlsname, size_t *publen, size_t *outlen);
+int oqsx_key_nid(const OQSX_KEY *key);
+/* component name `index` of a hybrid/composite key; caller frees */
+char *oqsx_key_cmpname(const OQSX_KEY *key, int index);
 
 /* Create OQSX_KEY data structure based on parameters; key material allocated
  * separately */
@@ -218,6 +287,9 @@ OQSX_KEY *oqsx_key_new(OSSL_LIB_CTX *libctx, char *oqs_name, char *tls_name,
 
 /* allocate key material; component pointers need to be set separately */
 int oqsx_key_allocate_keymaterial(OQSX_KEY *key, int include_private);
+/* allocate the public key of a key without key material for its encoded
+ * public key to be copied in; sets the component pointers */
+int oqsx_key_allocate_pubkey(OQSX_KEY *key);
 
 /* free all data structures, incl. key material */
 void oqsx_key_free(OQSX_KEY *key);
@@ -240,6 +312,16 @@ OQSX_KEY *oqsx_key_from_x509pubkey(const X509_PUBKEY *xpk, OSSL_LIB_CTX *libctx,
 /* populate key material from parameters */
 int oqsx_key_fromdata(OQSX_KEY *oqsxk, const OSSL_PARAM params[],
                       int include_private);
+/* check key material for the given OSSL_KEYMGMT_SELECT_* selection and
+ * OSSL_KEYMGMT_VALIDATE_* check type; successful checks are recorded in the
+ * key and not repeated */
+#define OQSX_VALIDATED_PUBLIC 0x01
+#define OQSX_VALIDATED_PRIVATE 0x02
+#define OQSX_VALIDATED_PAIRWISE 0x04
+#define OQSX_VALIDATED_QUICK_SHIFT 3
+int oqsx_key_validate(OQSX_KEY *key, int selection, int checktype);
+/* input check required before encapsulating to a peer key (FIPS 203) */
+int oqsx_key_encaps_check(OQSX_KEY *key);
 /* retrieve security bit count for key */
 int oqsx_key_secbits(OQSX_KEY *k);
 /* retrieve pure OQS key len */
@@ -255,6 +337,7 @@ int oqs_patch_codepoints(void);
 extern const OSSL_DISPATCH oqs_generic_kem_functions[];
 extern const OSSL_DISPATCH oqs_hybrid_kem_functions[];
 extern const OSSL_DISPATCH oqs_signature_functions[];
+extern const OSSL_DISPATCH oqs_bundle_store_functions[];
 
 ///// OQS_TEMPLATE_FRAGMENT_ENDECODER_FUNCTIONS_START
 #ifdef OQS_KEM_ENCODERS
@@ -2304,4 +2387,59 @@ int oqs_prov_bio_printf(OSSL_CORE_BIO *bio, const char *format, ...);
 BIO_METHOD *oqs_bio_prov_init_bio_method(void);
 BIO *oqs_bio_new_from_core_bio(PROV_OQS_CTX *provctx, OSSL_CORE_BIO *corebio);
 
+/* liboqs implementation variants and the pin configured per instance */
+const char *oqsx_impl_of(const char *oqs_name);
+/* NULL, "" or "auto" pin no variant; returns 0 for unknown variants */
+int oqsx_impl_parse_pin(const char *pin, const char **variant);
+int oqsx_impl_init(PROV_OQS_CTX *provctx, const char *variant);
+void oqsx_impl_cleanup(PROV_OQS_CTX *provctx);
+const char *oqsx_impl_get_pin(const PROV_OQS_CTX *provctx);
+/* returns 0 and raises an error if "oqs_name" runs a variant other than the
+ * one pinned by the instance owning "libctx" */
+int oqsx_impl_check(OSSL_LIB_CTX *libctx, const char *oqs_name);
+/* return the string lengths incl. the terminating NUL; "buf" may be NULL */
+size_t oqsx_impl_cpu_features(char *buf, size_t len);
+size_t oqsx_impl_list(char *buf, size_t len);
+
+/* Per-thread arena for buffers transient to one operation; arenas are
+ * shared by all instances, each instance registers with oqsx_arena_init */
+int oqsx_arena_init(PROV_OQS_CTX *provctx, const OSSL_DISPATCH *fns);
+void oqsx_arena_cleanup(PROV_OQS_CTX *provctx);
+/* returns the arena position to pass to oqsx_arena_release at operation end */
+size_t oqsx_arena_mark(void);
+/* falls back to the heap if the arena is exhausted */
+void *oqsx_arena_alloc(size_t len);
+/* frees (and wipes) heap fallbacks; arena memory is kept until release */
+void oqsx_arena_free(void *ptr, size_t len);
+/* frees all arena memory allocated after |mark|, wiping it if |wipe| */
+void oqsx_arena_release(size_t mark, int wipe);
+
+/* Slow operation log; NULL arguments fall back to the environment. Returns
+ * 0 for invalid settings. A threshold of 0 (default) disables the log.
+ */
+int oqsx_slowlog_init(const char *threshold_us, const char *size);
+void oqsx_slowlog_cleanup(void);
+/* returns the formatted ring, "" if disabled; "count" is set to the number
+ * of entries ever recorded. To be freed with OPENSSL_free.
+ */
+char *oqsx_slowlog_dump(uint64_t *count);
+
+#define OQSX_LAP_OTHER 0
+#define OQSX_LAP_PQ 1
+#define OQSX_LAP_CLASSIC 2
+
+typedef struct {
+    double start; // 0 if the log is disabled
+    double mark;
+    double pq_us;
+    double classic_us;
+} OQSX_OP_TIMER;
+
+void oqsx_op_timer_start(OQSX_OP_TIMER *t);
+/* accounts the time since the previous lap (or start) to "share" */
+void oqsx_op_timer_lap(OQSX_OP_TIMER *t, int share);
+/* records the operation if it took longer than the threshold */
+void oqsx_op_timer_end(OQSX_OP_TIMER *t, const char *op, const char *alg,
+                       int keytype, size_t inlen, size_t outlen);
+
 #endif
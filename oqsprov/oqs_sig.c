@@ -57,6 +57,13 @@ static OSSL_FUNC_signature_digest_verify_init_fn oqs_sig_digest_verify_init;
 static OSSL_FUNC_signature_digest_verify_update_fn
     oqs_sig_digest_signverify_update;
 static OSSL_FUNC_signature_digest_verify_final_fn oqs_sig_digest_verify_final;
+#ifdef OSSL_FUNC_SIGNATURE_SIGN_MESSAGE_INIT
+static OSSL_FUNC_signature_sign_message_init_fn oqs_sig_sign_message_init;
+static OSSL_FUNC_signature_sign_message_final_fn oqs_sig_sign_message_final;
+static OSSL_FUNC_signature_verify_message_init_fn oqs_sig_verify_message_init;
+static OSSL_FUNC_signature_verify_message_final_fn
+    oqs_sig_verify_message_final;
+#endif
 static OSSL_FUNC_signature_freectx_fn oqs_sig_freectx;
 static OSSL_FUNC_signature_dupctx_fn oqs_sig_dupctx;
 static OSSL_FUNC_signature_get_ctx_params_fn oqs_sig_get_ctx_params;
@@ -71,11 +78,16 @@ static OSSL_FUNC_signature_settable_ctx_md_params_fn
     oqs_sig_settable_ctx_md_params;
 
 // OIDS:
-static int get_aid(unsigned char **oidbuf, const char *tls_name) {
+static int get_aid(unsigned char **oidbuf, const OQSX_KEY *key) {
     X509_ALGOR *algor = X509_ALGOR_new();
+    ASN1_OBJECT *obj;
     int aidlen = 0;
 
-    X509_ALGOR_set0(algor, OBJ_txt2obj(tls_name, 0), V_ASN1_UNDEF, NULL);
+    if (key->desc != NULL)
+        obj = (ASN1_OBJECT *)key->desc->obj;
+    else
+        obj = OBJ_txt2obj(key->tls_name, 0);
+    X509_ALGOR_set0(algor, obj, V_ASN1_UNDEF, NULL);
 
     aidlen = i2d_X509_ALGOR(algor, oidbuf);
     X509_ALGOR_free(algor);
@@ -121,7 +133,11 @@ ASN1_NDEF_SEQUENCE(CompositeSignature) =
     size_t mdsize;
     // for collecting data if no MD is active:
     unsigned char *mddata;
+    size_t mdcap;
     int operation;
+    // signature to check in verify_message_final:
+    unsigned char *verify_sig;
+    size_t verify_siglen;
 } PROV_OQSSIG_CTX;
 
 static void *oqs_sig_newctx(void *provctx, const char *propq) {
@@ -168,7 +184,7 @@ static int oqs_sig_setup_md(PROV_OQSSIG_CTX *ctx, const char *mdname,
         if (ctx->aid)
             OPENSSL_free(ctx->aid);
         ctx->aid = NULL; // ensure next function allocates memory
-        ctx->aid_len = get_aid(&(ctx->aid), ctx->sig->tls_name);
+        ctx->aid_len = get_aid(&(ctx->aid), ctx->sig);
 
         ctx->md = md;
         OPENSSL_strlcpy(ctx->mdname, mdname, sizeof(ctx->mdname));
@@ -278,6 +294,8 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
     size_t classical_sig_len = 0, oqs_sig_len = 0;
     size_t actual_classical_sig_len = 0;
     size_t index = 0;
+    size_t arena_mark = oqsx_arena_mark();
+    OQSX_OP_TIMER timer;
     int rv = 0;
 
     if (!oqsxkey || !(oqs_key || oqs_key_classic) || !oqsxkey->privkey) {
@@ -307,6 +325,7 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
         return rv;
     }
 
+    oqsx_op_timer_start(&timer);
     if (is_hybrid) {
         if ((classical_ctx_sign = EVP_PKEY_CTX_new(evpkey, NULL)) == NULL ||
             EVP_PKEY_sign_init(classical_ctx_sign) <= 0) {
@@ -378,12 +397,13 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
         ENCODE_UINT32(sig, actual_classical_sig_len);
         classical_sig_len = SIZE_OF_UINT32 + actual_classical_sig_len;
         index += classical_sig_len;
+        oqsx_op_timer_lap(&timer, OQSX_LAP_CLASSIC);
     }
 
     if (is_composite) {
         unsigned char *buf;
         int i;
-        int nid = OBJ_sn2nid(oqsxkey->tls_name);
+        int nid = oqsx_key_nid(oqsxkey);
         int comp_idx = get_composite_idx(get_oqsalg_idx(nid));
         if (comp_idx == -1)
             goto endsign;
@@ -401,7 +421,7 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
         for (i = 0; i < oqsxkey->numkeys; i++) {
             char *name;
             char *upcase_name;
-            if ((name = get_cmpname(nid, i)) == NULL) {
+            if ((name = oqsx_key_cmpname(oqsxkey, i)) == NULL) {
                 ERR_raise(ERR_LIB_USER, ERR_R_FATAL);
                 CompositeSignature_free(compsig);
                 goto endsign;
@@ -420,12 +440,12 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
         }
         switch (aux) {
         case 0:
-            tbs_hash = OPENSSL_malloc(SHA256_DIGEST_LENGTH);
+            tbs_hash = oqsx_arena_alloc(SHA256_DIGEST_LENGTH);
             SHA256(tbs, tbslen, tbs_hash);
             final_tbslen += SHA256_DIGEST_LENGTH;
             break;
         case 1:
-            tbs_hash = OPENSSL_malloc(SHA512_DIGEST_LENGTH);
+            tbs_hash = oqsx_arena_alloc(SHA512_DIGEST_LENGTH);
             SHA512(tbs, tbslen, tbs_hash);
             final_tbslen += SHA512_DIGEST_LENGTH;
             break;
@@ -434,41 +454,42 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
             CompositeSignature_free(compsig);
             goto endsign;
         }
-        final_tbs = OPENSSL_malloc(final_tbslen);
+        final_tbs = oqsx_arena_alloc(final_tbslen);
         composite_prefix_conversion(final_tbs, oid_prefix);
         memcpy(final_tbs + COMPOSITE_OID_PREFIX_LEN / 2, tbs_hash,
                final_tbslen - COMPOSITE_OID_PREFIX_LEN / 2);
-        OPENSSL_free(tbs_hash);
+        oqsx_arena_free(tbs_hash, final_tbslen - COMPOSITE_OID_PREFIX_LEN / 2);
+        oqsx_op_timer_lap(&timer, OQSX_LAP_OTHER);
 
         // sign
         for (i = 0; i < oqsxkey->numkeys; i++) {
             char *name;
-            if ((name = get_cmpname(nid, i)) == NULL) {
+            if ((name = oqsx_key_cmpname(oqsxkey, i)) == NULL) {
                 ERR_raise(ERR_LIB_USER, ERR_R_FATAL);
                 CompositeSignature_free(compsig);
-                OPENSSL_free(final_tbs);
+                oqsx_arena_free(final_tbs, final_tbslen);
                 goto endsign;
             }
 
             if (get_oqsname_fromtls(name)) { // PQC signing
                 oqs_sig_len = oqsxkey->oqsx_provider_ctx.oqsx_qs_ctx.sig
                                   ->length_signature;
-                buf = OPENSSL_malloc(oqs_sig_len);
+                buf = oqsx_arena_alloc(oqs_sig_len);
                 if (OQS_SIG_sign(oqs_key, buf, &oqs_sig_len, final_tbs,
                                  final_tbslen,
                                  oqsxkey->comp_privkey[i]) != OQS_SUCCESS) {
                     ERR_raise(ERR_LIB_USER, OQSPROV_R_SIGNING_FAILED);
                     CompositeSignature_free(compsig);
-                    OPENSSL_free(final_tbs);
+                    oqsx_arena_free(final_tbs, final_tbslen);
                     OPENSSL_free(name);
-                    OPENSSL_free(buf);
+                    oqsx_arena_free(buf, oqs_sig_len);
                     goto endsign;
                 }
             } else { // sign non PQC key on oqs_key
                 oqs_key_classic = oqsxkey->classical_pkey;
                 oqs_sig_len = oqsxkey->oqsx_provider_ctx.oqsx_evp_ctx->evp_info
                                   ->length_signature;
-                buf = OPENSSL_malloc(oqs_sig_len);
+                buf = oqsx_arena_alloc(oqs_sig_len);
                 const EVP_MD *classical_md;
                 int digest_len;
                 unsigned char digest[SHA512_DIGEST_LENGTH]; /* init with max
@@ -482,10 +503,10 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
                                         final_tbslen) <= 0)) {
                         ERR_raise(ERR_LIB_USER, ERR_R_FATAL);
                         CompositeSignature_free(compsig);
-                        OPENSSL_free(final_tbs);
+                        oqsx_arena_free(final_tbs, final_tbslen);
                         OPENSSL_free(name);
                         EVP_MD_CTX_free(evp_ctx);
-                        OPENSSL_free(buf);
+                        oqsx_arena_free(buf, oqs_sig_len);
                         goto endsign;
                     }
                     EVP_MD_CTX_free(evp_ctx);
@@ -495,9 +516,9 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
                         (EVP_PKEY_sign_init(classical_ctx_sign) <= 0)) {
                         ERR_raise(ERR_LIB_USER, ERR_R_FATAL);
                         CompositeSignature_free(compsig);
-                        OPENSSL_free(final_tbs);
+                        oqsx_arena_free(final_tbs, final_tbslen);
                         OPENSSL_free(name);
-                        OPENSSL_free(buf);
+                        oqsx_arena_free(buf, oqs_sig_len);
                         goto endsign;
                     }
 
@@ -514,9 +535,9 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
                             } else {
                                 ERR_raise(ERR_LIB_USER, ERR_R_FATAL);
                                 CompositeSignature_free(compsig);
-                                OPENSSL_free(final_tbs);
+                                oqsx_arena_free(final_tbs, final_tbslen);
                                 OPENSSL_free(name);
-                                OPENSSL_free(buf);
+                                oqsx_arena_free(buf, oqs_sig_len);
                                 goto endsign;
                             }
                         }
@@ -529,9 +550,9 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
                                                           pss_mgf1) <= 0)) {
                             ERR_raise(ERR_LIB_USER, ERR_R_FATAL);
                             CompositeSignature_free(compsig);
-                            OPENSSL_free(final_tbs);
+                            oqsx_arena_free(final_tbs, final_tbslen);
                             OPENSSL_free(name);
-                            OPENSSL_free(buf);
+                            oqsx_arena_free(buf, oqs_sig_len);
                             goto endsign;
                         }
                     } else if (oqsxkey->oqsx_provider_ctx.oqsx_evp_ctx->evp_info
@@ -540,9 +561,9 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
                                 classical_ctx_sign, RSA_PKCS1_PADDING) <= 0) {
                             ERR_raise(ERR_LIB_USER, ERR_R_FATAL);
                             CompositeSignature_free(compsig);
-                            OPENSSL_free(final_tbs);
+                            oqsx_arena_free(final_tbs, final_tbslen);
                             OPENSSL_free(name);
-                            OPENSSL_free(buf);
+                            oqsx_arena_free(buf, oqs_sig_len);
                             goto endsign;
                         }
                     }
@@ -564,9 +585,9 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
                                        digest, digest_len) <= 0)) {
                         ERR_raise(ERR_LIB_USER, ERR_R_FATAL);
                         CompositeSignature_free(compsig);
-                        OPENSSL_free(final_tbs);
+                        oqsx_arena_free(final_tbs, final_tbslen);
                         OPENSSL_free(name);
-                        OPENSSL_free(buf);
+                        oqsx_arena_free(buf, oqs_sig_len);
                         goto endsign;
                     }
 
@@ -575,14 +596,17 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
                         /* sig is bigger than expected */
                         ERR_raise(ERR_LIB_USER, OQSPROV_R_BUFFER_LENGTH_WRONG);
                         CompositeSignature_free(compsig);
-                        OPENSSL_free(final_tbs);
+                        oqsx_arena_free(final_tbs, final_tbslen);
                         OPENSSL_free(name);
-                        OPENSSL_free(buf);
+                        oqsx_arena_free(buf, oqs_sig_len);
                         goto endsign;
                     }
                 }
             }
 
+            oqsx_op_timer_lap(&timer, get_oqsname_fromtls(name)
+                                          ? OQSX_LAP_PQ
+                                          : OQSX_LAP_CLASSIC);
             if (i == 0) {
                 compsig->sig1->data = OPENSSL_memdup(buf, oqs_sig_len);
                 compsig->sig1->length = oqs_sig_len;
@@ -595,19 +619,20 @@ static int oqs_sig_sign(void *vpoqs_sigctx, unsigned char *sig, size_t *siglen,
                     8; // set as 8 to not check for unused bits
             }
 
-            OPENSSL_free(buf);
+            oqsx_arena_free(buf, oqs_sig_len);
             OPENSSL_free(name);
         }
         oqs_sig_len = i2d_CompositeSignature(compsig, &sig);
 
         CompositeSignature_free(compsig);
-        OPENSSL_free(final_tbs);
+        oqsx_arena_free(final_tbs, final_tbslen);
     } else if (OQS_SIG_sign(oqs_key, sig + index, &oqs_sig_len, tbs, tbslen,
                             oqsxkey->comp_privkey[oqsxkey->numkeys - 1]) !=
                OQS_SUCCESS) {
         ERR_raise(ERR_LIB_USER, OQSPROV_R_SIGNING_FAILED);
         goto endsign;
     }
+    oqsx_op_timer_lap(&timer, is_composite ? OQSX_LAP_OTHER : OQSX_LAP_PQ);
 
     *siglen = classical_sig_len + oqs_sig_len;
     OQS_SIG_PRINTF2("OQS SIG provider: signing completes with size %ld\n",
@@ -618,6 +643,9 @@ endsign:
     if (classical_ctx_sign) {
         EVP_PKEY_CTX_free(classical_ctx_sign);
     }
+    oqsx_arena_release(arena_mark, 0);
+    oqsx_op_timer_end(&timer, "sign", oqsxkey->tls_name, oqsxkey->keytype,
+                      tbslen, rv ? *siglen : 0);
     return rv;
 }
 
@@ -634,6 +662,8 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
     int is_composite = (oqsxkey->keytype == KEY_TYPE_CMP_SIG);
     size_t classical_sig_len = 0, oqs_sig_len = 0;
     size_t index = 0;
+    size_t arena_mark = oqsx_arena_mark();
+    OQSX_OP_TIMER timer = {0};
     int rv = 0;
     ASN1_BIT_STRING *comp_sig;
 
@@ -647,6 +677,7 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
         goto endverify;
     }
 
+    oqsx_op_timer_start(&timer);
     if (is_hybrid) {
         const EVP_MD *classical_md;
         uint32_t actual_classical_sig_len = 0;
@@ -730,11 +761,12 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
          */
         classical_sig_len = SIZE_OF_UINT32 + actual_classical_sig_len;
         index += classical_sig_len;
+        oqsx_op_timer_lap(&timer, OQSX_LAP_CLASSIC);
     }
     if (is_composite) {
         CompositeSignature *compsig;
         int i;
-        int nid = OBJ_sn2nid(oqsxkey->tls_name);
+        int nid = oqsx_key_nid(oqsxkey);
         int comp_idx = get_composite_idx(get_oqsalg_idx(nid));
         if (comp_idx == -1)
             goto endverify;
@@ -756,7 +788,7 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
         for (i = 0; i < oqsxkey->numkeys; i++) {
             char *name;
             char *upcase_name;
-            if ((name = get_cmpname(nid, i)) == NULL) {
+            if ((name = oqsx_key_cmpname(oqsxkey, i)) == NULL) {
                 ERR_raise(ERR_LIB_USER, ERR_R_FATAL);
                 CompositeSignature_free(compsig);
                 goto endverify;
@@ -775,12 +807,12 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
         }
         switch (aux) {
         case 0:
-            tbs_hash = OPENSSL_malloc(SHA256_DIGEST_LENGTH);
+            tbs_hash = oqsx_arena_alloc(SHA256_DIGEST_LENGTH);
             SHA256(tbs, tbslen, tbs_hash);
             final_tbslen += SHA256_DIGEST_LENGTH;
             break;
         case 1:
-            tbs_hash = OPENSSL_malloc(SHA512_DIGEST_LENGTH);
+            tbs_hash = oqsx_arena_alloc(SHA512_DIGEST_LENGTH);
             SHA512(tbs, tbslen, tbs_hash);
             final_tbslen += SHA512_DIGEST_LENGTH;
             break;
@@ -789,11 +821,12 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
             CompositeSignature_free(compsig);
             goto endverify;
         }
-        final_tbs = OPENSSL_malloc(final_tbslen);
+        final_tbs = oqsx_arena_alloc(final_tbslen);
         composite_prefix_conversion(final_tbs, oid_prefix);
         memcpy(final_tbs + COMPOSITE_OID_PREFIX_LEN / 2, tbs_hash,
                final_tbslen - COMPOSITE_OID_PREFIX_LEN / 2);
-        OPENSSL_free(tbs_hash);
+        oqsx_arena_free(tbs_hash, final_tbslen - COMPOSITE_OID_PREFIX_LEN / 2);
+        oqsx_op_timer_lap(&timer, OQSX_LAP_OTHER);
 
         // verify
         for (i = 0; i < oqsxkey->numkeys; i++) {
@@ -806,10 +839,10 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
             }
 
             char *name;
-            if ((name = get_cmpname(nid, i)) == NULL) {
+            if ((name = oqsx_key_cmpname(oqsxkey, i)) == NULL) {
                 ERR_raise(ERR_LIB_USER, OQSPROV_R_VERIFY_ERROR);
                 CompositeSignature_free(compsig);
-                OPENSSL_free(final_tbs);
+                oqsx_arena_free(final_tbs, final_tbslen);
                 goto endverify;
             }
 
@@ -820,7 +853,7 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
                     ERR_raise(ERR_LIB_USER, OQSPROV_R_VERIFY_ERROR);
                     OPENSSL_free(name);
                     CompositeSignature_free(compsig);
-                    OPENSSL_free(final_tbs);
+                    oqsx_arena_free(final_tbs, final_tbslen);
                     goto endverify;
                 }
             } else {
@@ -840,7 +873,7 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
                         OPENSSL_free(name);
                         EVP_MD_CTX_free(evp_ctx);
                         CompositeSignature_free(compsig);
-                        OPENSSL_free(final_tbs);
+                        oqsx_arena_free(final_tbs, final_tbslen);
                         goto endverify;
                     }
                     EVP_MD_CTX_free(evp_ctx);
@@ -851,7 +884,7 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
                         ERR_raise(ERR_LIB_USER, OQSPROV_R_VERIFY_ERROR);
                         OPENSSL_free(name);
                         CompositeSignature_free(compsig);
-                        OPENSSL_free(final_tbs);
+                        oqsx_arena_free(final_tbs, final_tbslen);
                         goto endverify;
                     }
                     if (!strncmp(name, "pss", 3)) {
@@ -868,7 +901,7 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
                                 ERR_raise(ERR_LIB_USER, OQSPROV_R_VERIFY_ERROR);
                                 OPENSSL_free(name);
                                 CompositeSignature_free(compsig);
-                                OPENSSL_free(final_tbs);
+                                oqsx_arena_free(final_tbs, final_tbslen);
                                 goto endverify;
                             }
                         }
@@ -881,7 +914,7 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
                             ERR_raise(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS);
                             OPENSSL_free(name);
                             CompositeSignature_free(compsig);
-                            OPENSSL_free(final_tbs);
+                            oqsx_arena_free(final_tbs, final_tbslen);
                             goto endverify;
                         }
                     } else if (oqsxkey->oqsx_provider_ctx.oqsx_evp_ctx->evp_info
@@ -891,7 +924,7 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
                             ERR_raise(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS);
                             OPENSSL_free(name);
                             CompositeSignature_free(compsig);
-                            OPENSSL_free(final_tbs);
+                            oqsx_arena_free(final_tbs, final_tbslen);
                             goto endverify;
                         }
                     }
@@ -914,16 +947,19 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
                         ERR_raise(ERR_LIB_USER, OQSPROV_R_VERIFY_ERROR);
                         OPENSSL_free(name);
                         CompositeSignature_free(compsig);
-                        OPENSSL_free(final_tbs);
+                        oqsx_arena_free(final_tbs, final_tbslen);
                         goto endverify;
                     }
                 }
             }
 
+            oqsx_op_timer_lap(&timer, get_oqsname_fromtls(name)
+                                          ? OQSX_LAP_PQ
+                                          : OQSX_LAP_CLASSIC);
             OPENSSL_free(name);
         }
         CompositeSignature_free(compsig);
-        OPENSSL_free(final_tbs);
+        oqsx_arena_free(final_tbs, final_tbslen);
     } else {
         if (!oqsxkey->comp_pubkey[oqsxkey->numkeys - 1]) {
             ERR_raise(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS);
@@ -935,6 +971,7 @@ static int oqs_sig_verify(void *vpoqs_sigctx, const unsigned char *sig,
             ERR_raise(ERR_LIB_USER, OQSPROV_R_VERIFY_ERROR);
             goto endverify;
         }
+        oqsx_op_timer_lap(&timer, OQSX_LAP_PQ);
     }
     rv = 1;
 
@@ -942,6 +979,10 @@ endverify:
     if (ctx_verify) {
         EVP_PKEY_CTX_free(ctx_verify);
     }
+    oqsx_arena_release(arena_mark, 0);
+    if (oqsxkey != NULL)
+        oqsx_op_timer_end(&timer, "verify", oqsxkey->tls_name,
+                          oqsxkey->keytype, tbslen, siglen);
     OQS_SIG_PRINTF2("OQS SIG provider: verify rv = %d\n", rv);
     return rv;
 }
@@ -1012,22 +1053,28 @@ int oqs_sig_digest_signverify_update(void *vpoqs_sigctx,
     if (poqs_sigctx->mdctx)
         return EVP_DigestUpdate(poqs_sigctx->mdctx, data, datalen);
     else {
-        // unconditionally collect data for passing in full to OQS API
-        if (poqs_sigctx->mddata) {
-            unsigned char *newdata = OPENSSL_realloc(
-                poqs_sigctx->mddata, poqs_sigctx->mdsize + datalen);
+        // unconditionally collect data for passing in full to OQS API;
+        // grow geometrically to keep many small updates linear
+        size_t needed = poqs_sigctx->mdsize + datalen;
+
+        if (needed < datalen)
+            return 0;
+        if (needed > poqs_sigctx->mdcap) {
+            size_t newcap = poqs_sigctx->mdcap ? poqs_sigctx->mdcap : 64;
+            unsigned char *newdata;
+
+            while (newcap < needed && newcap <= SIZE_MAX / 2)
+                newcap *= 2;
+            if (newcap < needed)
+                newcap = needed;
+            newdata = OPENSSL_realloc(poqs_sigctx->mddata, newcap);
             if (newdata == NULL)
                 return 0;
-            memcpy(newdata + poqs_sigctx->mdsize, data, datalen);
             poqs_sigctx->mddata = newdata;
-            poqs_sigctx->mdsize += datalen;
-        } else { // simple alloc and copy
-            poqs_sigctx->mddata = OPENSSL_malloc(datalen);
-            if (poqs_sigctx->mddata == NULL)
-                return 0;
-            poqs_sigctx->mdsize = datalen;
-            memcpy(poqs_sigctx->mddata, data, poqs_sigctx->mdsize);
+            poqs_sigctx->mdcap = newcap;
         }
+        memcpy(poqs_sigctx->mddata + poqs_sigctx->mdsize, data, datalen);
+        poqs_sigctx->mdsize = needed;
         OQS_SIG_PRINTF2("OQS SIG provider: digest_signverify_update collected "
                         "%ld bytes...\n",
                         poqs_sigctx->mdsize);
@@ -1094,6 +1141,74 @@ int oqs_sig_digest_verify_final(void *vpoqs_sigctx, const unsigned char *sig,
                               poqs_sigctx->mdsize);
 }
 
+#ifdef OSSL_FUNC_SIGNATURE_SIGN_MESSAGE_INIT
+/* The message API (OpenSSL 3.4+) hands the message to the signature scheme
+ * as a whole: EVP_PKEY_sign()/EVP_PKEY_verify() after a message init pass it
+ * straight to oqs_sig_sign()/oqs_sig_verify(); streamed updates are collected
+ * once as for DigestSign without a digest. No digest is fetched.
+ */
+static int oqs_sig_signverify_message_init(void *vpoqs_sigctx, void *voqssig,
+                                           const OSSL_PARAM params[],
+                                           int operation) {
+    PROV_OQSSIG_CTX *poqs_sigctx = (PROV_OQSSIG_CTX *)vpoqs_sigctx;
+
+    if (!oqs_sig_signverify_init(vpoqs_sigctx, voqssig, operation))
+        return 0;
+
+    EVP_MD_CTX_free(poqs_sigctx->mdctx);
+    EVP_MD_free(poqs_sigctx->md);
+    poqs_sigctx->mdctx = NULL;
+    poqs_sigctx->md = NULL;
+    poqs_sigctx->mdname[0] = '\0';
+    poqs_sigctx->mdsize = 0; // buffer is kept for reuse
+    OPENSSL_free(poqs_sigctx->verify_sig);
+    poqs_sigctx->verify_sig = NULL;
+    poqs_sigctx->verify_siglen = 0;
+
+    return params == NULL || oqs_sig_set_ctx_params(vpoqs_sigctx, params);
+}
+
+static int oqs_sig_sign_message_init(void *vpoqs_sigctx, void *voqssig,
+                                     const OSSL_PARAM params[]) {
+    OQS_SIG_PRINTF("OQS SIG provider: sign_message_init called\n");
+    return oqs_sig_signverify_message_init(vpoqs_sigctx, voqssig, params,
+                                           EVP_PKEY_OP_SIGN);
+}
+
+static int oqs_sig_verify_message_init(void *vpoqs_sigctx, void *voqssig,
+                                       const OSSL_PARAM params[]) {
+    OQS_SIG_PRINTF("OQS SIG provider: verify_message_init called\n");
+    return oqs_sig_signverify_message_init(vpoqs_sigctx, voqssig, params,
+                                           EVP_PKEY_OP_VERIFY);
+}
+
+static int oqs_sig_sign_message_final(void *vpoqs_sigctx, unsigned char *sig,
+                                      size_t *siglen, size_t sigsize) {
+    PROV_OQSSIG_CTX *poqs_sigctx = (PROV_OQSSIG_CTX *)vpoqs_sigctx;
+
+    OQS_SIG_PRINTF("OQS SIG provider: sign_message_final called\n");
+    if (poqs_sigctx == NULL)
+        return 0;
+    return oqs_sig_sign(vpoqs_sigctx, sig, siglen, sigsize,
+                        poqs_sigctx->mddata, poqs_sigctx->mdsize);
+}
+
+static int oqs_sig_verify_message_final(void *vpoqs_sigctx) {
+    PROV_OQSSIG_CTX *poqs_sigctx = (PROV_OQSSIG_CTX *)vpoqs_sigctx;
+
+    OQS_SIG_PRINTF("OQS SIG provider: verify_message_final called\n");
+    if (poqs_sigctx == NULL)
+        return 0;
+    if (poqs_sigctx->verify_sig == NULL) {
+        ERR_raise(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS);
+        return 0;
+    }
+    return oqs_sig_verify(vpoqs_sigctx, poqs_sigctx->verify_sig,
+                          poqs_sigctx->verify_siglen, poqs_sigctx->mddata,
+                          poqs_sigctx->mdsize);
+}
+#endif /* OSSL_FUNC_SIGNATURE_SIGN_MESSAGE_INIT */
+
 static void oqs_sig_freectx(void *vpoqs_sigctx) {
     PROV_OQSSIG_CTX *ctx = (PROV_OQSSIG_CTX *)vpoqs_sigctx;
 
@@ -1108,6 +1223,9 @@ static void oqs_sig_freectx(void *vpoqs_sigctx) {
     OPENSSL_free(ctx->mddata);
     ctx->mddata = NULL;
     ctx->mdsize = 0;
+    ctx->mdcap = 0;
+    OPENSSL_free(ctx->verify_sig);
+    ctx->verify_sig = NULL;
     OPENSSL_free(ctx->aid);
     ctx->aid = NULL;
     ctx->aid_len = 0;
@@ -1128,6 +1246,11 @@ static void *oqs_sig_dupctx(void *vpoqs_sigctx) {
     dstctx->sig = NULL;
     dstctx->md = NULL;
     dstctx->mdctx = NULL;
+    dstctx->mddata = NULL;
+    dstctx->mdsize = dstctx->mdcap = 0;
+    dstctx->verify_sig = NULL;
+    dstctx->aid = NULL;
+    dstctx->propq = NULL;
 
     if (srcctx->sig != NULL && !oqsx_key_up_ref(srcctx->sig))
         goto err;
@@ -1148,7 +1271,14 @@ static void *oqs_sig_dupctx(void *vpoqs_sigctx) {
         dstctx->mddata = OPENSSL_memdup(srcctx->mddata, srcctx->mdsize);
         if (dstctx->mddata == NULL)
             goto err;
-        dstctx->mdsize = srcctx->mdsize;
+        dstctx->mdsize = dstctx->mdcap = srcctx->mdsize;
+    }
+
+    if (srcctx->verify_sig) {
+        dstctx->verify_sig =
+            OPENSSL_memdup(srcctx->verify_sig, srcctx->verify_siglen);
+        if (dstctx->verify_sig == NULL)
+            goto err;
     }
 
     if (srcctx->aid) {
@@ -1181,8 +1311,7 @@ static int oqs_sig_get_ctx_params(void *vpoqs_sigctx, OSSL_PARAM *params) {
     p = OSSL_PARAM_locate(params, OSSL_SIGNATURE_PARAM_ALGORITHM_ID);
 
     if (poqs_sigctx->aid == NULL) {
-        poqs_sigctx->aid_len =
-            get_aid(&(poqs_sigctx->aid), poqs_sigctx->sig->tls_name);
+        poqs_sigctx->aid_len = get_aid(&(poqs_sigctx->aid), poqs_sigctx->sig);
     }
 
     if (p != NULL &&
@@ -1235,6 +1364,17 @@ static int oqs_sig_set_ctx_params(void *vpoqs_sigctx,
             return 0;
     }
 
+#ifdef OSSL_FUNC_SIGNATURE_SIGN_MESSAGE_INIT
+    p = OSSL_PARAM_locate_const(params, OSSL_SIGNATURE_PARAM_SIGNATURE);
+    if (p != NULL) {
+        OPENSSL_free(poqs_sigctx->verify_sig);
+        poqs_sigctx->verify_sig = NULL;
+        if (!OSSL_PARAM_get_octet_string(p, (void **)&poqs_sigctx->verify_sig,
+                                         0, &poqs_sigctx->verify_siglen))
+            return 0;
+    }
+#endif
+
     // not passing in parameters we can act on is no error
     return 1;
 }
@@ -1242,6 +1382,9 @@ static int oqs_sig_set_ctx_params(void *vpoqs_sigctx,
 static const OSSL_PARAM known_settable_ctx_params[] = {
     OSSL_PARAM_utf8_string(OSSL_SIGNATURE_PARAM_DIGEST, NULL, 0),
     OSSL_PARAM_utf8_string(OSSL_SIGNATURE_PARAM_PROPERTIES, NULL, 0),
+#ifdef OSSL_FUNC_SIGNATURE_SIGN_MESSAGE_INIT
+    OSSL_PARAM_octet_string(OSSL_SIGNATURE_PARAM_SIGNATURE, NULL, 0),
+#endif
     OSSL_PARAM_END};
 
 static const OSSL_PARAM *
@@ -1322,6 +1465,20 @@ const OSSL_DISPATCH oqs_signature_functions[] = {
      (void (*)(void))oqs_sig_digest_signverify_update},
     {OSSL_FUNC_SIGNATURE_DIGEST_VERIFY_FINAL,
      (void (*)(void))oqs_sig_digest_verify_final},
+#ifdef OSSL_FUNC_SIGNATURE_SIGN_MESSAGE_INIT
+    {OSSL_FUNC_SIGNATURE_SIGN_MESSAGE_INIT,
+     (void (*)(void))oqs_sig_sign_message_init},
+    {OSSL_FUNC_SIGNATURE_SIGN_MESSAGE_UPDATE,
+     (void (*)(void))oqs_sig_digest_signverify_update},
+    {OSSL_FUNC_SIGNATURE_SIGN_MESSAGE_FINAL,
+     (void (*)(void))oqs_sig_sign_message_final},
+    {OSSL_FUNC_SIGNATURE_VERIFY_MESSAGE_INIT,
+     (void (*)(void))oqs_sig_verify_message_init},
+    {OSSL_FUNC_SIGNATURE_VERIFY_MESSAGE_UPDATE,
+     (void (*)(void))oqs_sig_digest_signverify_update},
+    {OSSL_FUNC_SIGNATURE_VERIFY_MESSAGE_FINAL,
+     (void (*)(void))oqs_sig_verify_message_final},
+#endif
     {OSSL_FUNC_SIGNATURE_FREECTX, (void (*)(void))oqs_sig_freectx},
     {OSSL_FUNC_SIGNATURE_DUPCTX, (void (*)(void))oqs_sig_dupctx},
     {OSSL_FUNC_SIGNATURE_GET_CTX_PARAMS,
@@ -0,0 +1,473 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/*
+ * OQS OpenSSL 3 provider
+ *
+ * "oqsbundle" store loader for multi-object PEM files and concatenated DER
+ * objects, e.g., keystores and trust stores with many quantum-safe keys:
+ *
+ *   OSSL_STORE_open_ex("oqsbundle:/path/to/bundle.pem", ...)
+ *   OSSL_STORE_attach(bio, "oqsbundle", ...)
+ *
+ * The input is split into its objects when the store is opened. Private
+ * and public keys of algorithms of this provider are then decoded on a pool
+ * of worker threads while the store's load function hands out all objects,
+ * one per call, in their original order. Other objects (certificates,
+ * CRLs, encrypted and classic keys) are passed on as DER for the core to
+ * decode as usual, as are keys the workers fail to decode.
+ *
+ * The pool has one thread per online CPU, at most OQSX_BUNDLE_MAX_THREADS;
+ * the environment variable OQS_BUNDLE_THREADS overrides this, 0 decoding
+ * all keys on the calling thread, which is what happens on Windows.
+ */
+
+#include <openssl/asn1.h>
+#include <openssl/buffer.h>
+#include <openssl/core_dispatch.h>
+#include <openssl/core_names.h>
+#include <openssl/core_object.h>
+#include <openssl/err.h>
+#include <openssl/params.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#define OQSX_BUNDLE_THREADS
+#endif
+
+#include "oqs_endecoder_local.h"
+
+#ifdef NDEBUG
+#define OQS_BUNDLE_PRINTF(a)
+#define OQS_BUNDLE_PRINTF2(a, b)
+#define OQS_BUNDLE_PRINTF3(a, b, c)
+#else
+#define OQS_BUNDLE_PRINTF(a)                                                   \
+    if (getenv("OQSBUNDLE"))                                                   \
+    printf(a)
+#define OQS_BUNDLE_PRINTF2(a, b)                                               \
+    if (getenv("OQSBUNDLE"))                                                   \
+    printf(a, b)
+#define OQS_BUNDLE_PRINTF3(a, b, c)                                            \
+    if (getenv("OQSBUNDLE"))                                                   \
+    printf(a, b, c)
+#endif // NDEBUG
+
+#define OQSX_BUNDLE_MAX_THREADS 64
+
+/* what an object may be decoded as by the workers */
+#define BUNDLE_TRY_PRIVATE 0x01
+#define BUNDLE_TRY_PUBLIC 0x02
+
+typedef enum { OBJ_PENDING, OBJ_CLAIMED, OBJ_DONE } bundle_obj_state_t;
+
+typedef struct {
+    unsigned char *der;
+    long derlen;
+    /* how the object is passed on if no OQS key is decoded from it */
+    int object_type;
+    char *data_type;
+    const char *data_structure;
+    int try_as;
+    bundle_obj_state_t state;
+    OQSX_KEY *key;
+} OQSX_BUNDLE_OBJ;
+
+typedef struct {
+    PROV_OQS_CTX *provctx;
+    OQSX_BUNDLE_OBJ *objs;
+    size_t nobjs;
+    size_t next_load;
+    size_t next_decode;
+#ifdef OQSX_BUNDLE_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t decoded;
+    pthread_t *workers;
+    int nworkers;
+    int stop;
+#endif
+} OQSX_BUNDLE_CTX;
+
+static OSSL_FUNC_store_open_fn oqsx_bundle_open;
+static OSSL_FUNC_store_attach_fn oqsx_bundle_attach;
+static OSSL_FUNC_store_load_fn oqsx_bundle_load;
+static OSSL_FUNC_store_eof_fn oqsx_bundle_eof;
+static OSSL_FUNC_store_close_fn oqsx_bundle_close;
+
+/// Splitting
+
+static OQSX_BUNDLE_OBJ *bundle_add(OQSX_BUNDLE_CTX *ctx, size_t *cap) {
+    OQSX_BUNDLE_OBJ *objs;
+
+    if (ctx->nobjs == *cap) {
+        *cap = *cap == 0 ? 16 : 2 * *cap;
+        objs = OPENSSL_realloc(ctx->objs, *cap * sizeof(*objs));
+        if (objs == NULL)
+            return NULL;
+        ctx->objs = objs;
+    }
+    memset(&ctx->objs[ctx->nobjs], 0, sizeof(*ctx->objs));
+    return &ctx->objs[ctx->nobjs++];
+}
+
+static int bundle_split_pem(OQSX_BUNDLE_CTX *ctx, const char *buf,
+                            long buflen) {
+    BIO *in = BIO_new_mem_buf(buf, (int)buflen);
+    char *name = NULL, *header = NULL;
+    OQSX_BUNDLE_OBJ *obj;
+    size_t cap = 0;
+    int ret = 0;
+
+    if (in == NULL)
+        return 0;
+    for (;;) {
+        unsigned char *data = NULL;
+        long len;
+
+        if (!PEM_read_bio(in, &name, &header, &data, &len)) {
+            if (ERR_GET_REASON(ERR_peek_last_error()) == PEM_R_NO_START_LINE) {
+                ERR_clear_error();
+                ret = 1;
+            }
+            break;
+        }
+        // legacy encrypted PEM cannot be passed on as DER
+        if (header[0] != '\0' || (obj = bundle_add(ctx, &cap)) == NULL) {
+            OQS_BUNDLE_PRINTF2("OQS BUNDLE: skipping PEM object %s\n", name);
+            OPENSSL_clear_free(data, len);
+        } else {
+            obj->der = data;
+            obj->derlen = len;
+            obj->object_type = OSSL_OBJECT_UNKNOWN;
+            if (strcmp(name, PEM_STRING_PKCS8INF) == 0) {
+                obj->object_type = OSSL_OBJECT_PKEY;
+                obj->data_structure = "PrivateKeyInfo";
+                obj->try_as = BUNDLE_TRY_PRIVATE;
+            } else if (strcmp(name, PEM_STRING_PUBLIC) == 0) {
+                obj->object_type = OSSL_OBJECT_PKEY;
+                obj->data_structure = "SubjectPublicKeyInfo";
+                obj->try_as = BUNDLE_TRY_PUBLIC;
+            } else if (strcmp(name, PEM_STRING_PKCS8) == 0) {
+                obj->object_type = OSSL_OBJECT_PKEY;
+                obj->data_structure = "EncryptedPrivateKeyInfo";
+            } else {
+                if (strcmp(name, PEM_STRING_X509) == 0 ||
+                    strcmp(name, PEM_STRING_X509_OLD) == 0 ||
+                    strcmp(name, PEM_STRING_X509_TRUSTED) == 0)
+                    obj->object_type = OSSL_OBJECT_CERT;
+                else if (strcmp(name, PEM_STRING_X509_CRL) == 0)
+                    obj->object_type = OSSL_OBJECT_CRL;
+                // the core tells certificates with trust settings by this
+                obj->data_type = name;
+                name = NULL;
+            }
+            obj->state = obj->try_as != 0 ? OBJ_PENDING : OBJ_DONE;
+        }
+        OPENSSL_free(name);
+        OPENSSL_free(header);
+        name = header = NULL;
+    }
+    BIO_free(in);
+    return ret;
+}
+
+static int bundle_split_der(OQSX_BUNDLE_CTX *ctx, const unsigned char *buf,
+                            long buflen) {
+    const unsigned char *p;
+    OQSX_BUNDLE_OBJ *obj;
+    size_t cap = 0;
+    long off = 0, len;
+    int tag, xclass;
+
+    while (off < buflen) {
+        p = buf + off;
+        // only definite length encodings can be told apart without parsing
+        if (ASN1_get_object(&p, &len, &tag, &xclass, buflen - off) != 0x20) {
+            ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_ENCODING);
+            return 0;
+        }
+        len += (long)(p - (buf + off));
+        if ((obj = bundle_add(ctx, &cap)) == NULL ||
+            (obj->der = OPENSSL_memdup(buf + off, len)) == NULL)
+            return 0;
+        obj->derlen = len;
+        obj->object_type = OSSL_OBJECT_UNKNOWN;
+        obj->try_as = BUNDLE_TRY_PRIVATE | BUNDLE_TRY_PUBLIC;
+        obj->state = OBJ_PENDING;
+        off += len;
+    }
+    return 1;
+}
+
+/* The file may hold plaintext private keys: buffers are wiped when grown
+ * and freed. The secure heap is not used as bundles can be large.
+ */
+static int bundle_split(OQSX_BUNDLE_CTX *ctx, BIO *in) {
+    BUF_MEM *mem = BUF_MEM_new();
+    char chunk[4096];
+    int n, ret = 0;
+
+    if (mem == NULL)
+        return 0;
+    while ((n = BIO_read(in, chunk, sizeof(chunk))) > 0) {
+        if (!BUF_MEM_grow_clean(mem, mem->length + n))
+            goto end;
+        memcpy(mem->data + mem->length - n, chunk, n);
+    }
+    /* DER bundles start with a SEQUENCE; anything else is read as PEM,
+     * which skips comments and other text around the PEM objects.
+     */
+    if (mem->length > 0 && (unsigned char)mem->data[0] == 0x30)
+        ret = bundle_split_der(ctx, (unsigned char *)mem->data,
+                               (long)mem->length);
+    else
+        ret = bundle_split_pem(ctx, mem->data, (long)mem->length);
+    OQS_BUNDLE_PRINTF2("OQS BUNDLE: %zu objects\n", ctx->nobjs);
+
+end:
+    OPENSSL_cleanse(chunk, sizeof(chunk));
+    BUF_MEM_free(mem);
+    return ret;
+}
+
+/// Decoding
+
+static int bundle_is_oqs_alg(const X509_ALGOR *alg) {
+    return alg != NULL && get_oqsname(OBJ_obj2nid(alg->algorithm)) != NULL;
+}
+
+static void bundle_decode(OQSX_BUNDLE_CTX *ctx, OQSX_BUNDLE_OBJ *obj) {
+    OSSL_LIB_CTX *libctx = PROV_OQS_LIBCTX_OF(ctx->provctx);
+    PKCS8_PRIV_KEY_INFO *p8inf;
+    X509_PUBKEY *xpk;
+    const X509_ALGOR *alg = NULL;
+    const unsigned char *p;
+
+    if ((obj->try_as & BUNDLE_TRY_PRIVATE) != 0) {
+        p = obj->der;
+        if ((p8inf = d2i_PKCS8_PRIV_KEY_INFO(NULL, &p, obj->derlen)) !=
+                NULL &&
+            PKCS8_pkey_get0(NULL, NULL, NULL, &alg, p8inf) &&
+            bundle_is_oqs_alg(alg))
+            obj->key = oqsx_key_from_pkcs8(p8inf, libctx, NULL);
+        PKCS8_PRIV_KEY_INFO_free(p8inf);
+    }
+    if (obj->key == NULL && (obj->try_as & BUNDLE_TRY_PUBLIC) != 0) {
+        p = obj->der;
+        if ((xpk = oqsx_d2i_X509_PUBKEY_INTERNAL(&p, obj->derlen, libctx)) !=
+                NULL &&
+            X509_PUBKEY_get0_param(NULL, NULL, NULL, (X509_ALGOR **)&alg,
+                                   xpk) &&
+            bundle_is_oqs_alg(alg))
+            obj->key = oqsx_key_from_x509pubkey(xpk, libctx, NULL);
+        X509_PUBKEY_free(xpk);
+    }
+    if (obj->key != NULL)
+        oqsx_key_set0_libctx(obj->key, libctx);
+    // objects not decoded here are passed on and any errors reported then
+    ERR_clear_error();
+}
+
+#ifdef OQSX_BUNDLE_THREADS
+static void *bundle_worker(void *arg) {
+    OQSX_BUNDLE_CTX *ctx = arg;
+    OQSX_BUNDLE_OBJ *obj;
+
+    pthread_mutex_lock(&ctx->lock);
+    while (!ctx->stop && ctx->next_decode < ctx->nobjs) {
+        obj = &ctx->objs[ctx->next_decode++];
+        if (obj->state != OBJ_PENDING)
+            continue;
+        obj->state = OBJ_CLAIMED;
+        pthread_mutex_unlock(&ctx->lock);
+        bundle_decode(ctx, obj);
+        pthread_mutex_lock(&ctx->lock);
+        obj->state = OBJ_DONE;
+        pthread_cond_broadcast(&ctx->decoded);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+    OPENSSL_thread_stop();
+    return NULL;
+}
+
+static void bundle_start_workers(OQSX_BUNDLE_CTX *ctx) {
+    const char *env = getenv("OQS_BUNDLE_THREADS");
+    long threads = env != NULL ? strtol(env, NULL, 10)
+                               : sysconf(_SC_NPROCESSORS_ONLN);
+    size_t i, pending = 0;
+
+    for (i = 0; i < ctx->nobjs; i++)
+        pending += ctx->objs[i].state == OBJ_PENDING;
+    if (threads > OQSX_BUNDLE_MAX_THREADS)
+        threads = OQSX_BUNDLE_MAX_THREADS;
+    if ((size_t)threads > pending)
+        threads = (long)pending;
+    // a single key is decoded faster on the calling thread
+    if (threads < 1 || pending < 2 ||
+        (ctx->workers = OPENSSL_malloc(threads * sizeof(pthread_t))) == NULL)
+        return;
+    for (; ctx->nworkers < threads; ctx->nworkers++)
+        if (pthread_create(&ctx->workers[ctx->nworkers], NULL, bundle_worker,
+                           ctx) != 0)
+            break;
+    OQS_BUNDLE_PRINTF2("OQS BUNDLE: %d decoding threads\n", ctx->nworkers);
+}
+#endif
+
+/* Returns the next object to hand out, once decoded; objects no worker took
+ * yet are decoded on the calling thread. */
+static OQSX_BUNDLE_OBJ *bundle_next(OQSX_BUNDLE_CTX *ctx) {
+    OQSX_BUNDLE_OBJ *obj = &ctx->objs[ctx->next_load];
+
+#ifdef OQSX_BUNDLE_THREADS
+    pthread_mutex_lock(&ctx->lock);
+    while (obj->state == OBJ_CLAIMED)
+        pthread_cond_wait(&ctx->decoded, &ctx->lock);
+    if (obj->state == OBJ_PENDING)
+        obj->state = OBJ_CLAIMED;
+    pthread_mutex_unlock(&ctx->lock);
+#endif
+    if (obj->state != OBJ_DONE) {
+        bundle_decode(ctx, obj);
+        obj->state = OBJ_DONE;
+    }
+    ctx->next_load++;
+    return obj;
+}
+
+/// Store functions
+
+static void *bundle_new(PROV_OQS_CTX *provctx, BIO *in) {
+    OQSX_BUNDLE_CTX *ctx;
+
+    if (in == NULL || (ctx = OPENSSL_zalloc(sizeof(*ctx))) == NULL)
+        return NULL;
+    ctx->provctx = provctx;
+#ifdef OQSX_BUNDLE_THREADS
+    if (pthread_mutex_init(&ctx->lock, NULL) != 0) {
+        OPENSSL_free(ctx);
+        return NULL;
+    }
+    pthread_cond_init(&ctx->decoded, NULL);
+#endif
+    if (!bundle_split(ctx, in)) {
+        oqsx_bundle_close(ctx);
+        return NULL;
+    }
+#ifdef OQSX_BUNDLE_THREADS
+    bundle_start_workers(ctx);
+#endif
+    return ctx;
+}
+
+static void *oqsx_bundle_open(void *provctx, const char *uri) {
+    void *ctx;
+    BIO *in;
+
+    OQS_BUNDLE_PRINTF2("OQS BUNDLE: open %s\n", uri);
+    // the core only hands over URIs of the "oqsbundle" scheme
+    if ((uri = strchr(uri, ':')) == NULL)
+        return NULL;
+    uri++;
+    // oqsbundle:///path like file:///path
+    if (strncmp(uri, "//", 2) == 0)
+        uri += 2;
+    in = BIO_new_file(uri, "rb");
+    ctx = bundle_new(provctx, in);
+    BIO_free(in);
+    return ctx;
+}
+
+static void *oqsx_bundle_attach(void *provctx, OSSL_CORE_BIO *cin) {
+    BIO *in = oqs_bio_new_from_core_bio(provctx, cin);
+    void *ctx = bundle_new(provctx, in);
+
+    BIO_free(in);
+    return ctx;
+}
+
+static int oqsx_bundle_load(void *vctx, OSSL_CALLBACK *object_cb,
+                            void *object_cbarg, OSSL_PASSPHRASE_CALLBACK *pw_cb,
+                            void *pw_cbarg) {
+    OQSX_BUNDLE_CTX *ctx = vctx;
+    OQSX_BUNDLE_OBJ *obj;
+    OSSL_PARAM params[5], *p = params;
+    int object_type = OSSL_OBJECT_PKEY, ok;
+
+    if (ctx->next_load >= ctx->nobjs)
+        return 0;
+    obj = bundle_next(ctx);
+
+    if (obj->key != NULL) {
+        *p++ = OSSL_PARAM_construct_int(OSSL_OBJECT_PARAM_TYPE, &object_type);
+        *p++ = OSSL_PARAM_construct_utf8_string(OSSL_OBJECT_PARAM_DATA_TYPE,
+                                                obj->key->tls_name, 0);
+        /* The address of the key becomes the octet string */
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_OBJECT_PARAM_REFERENCE,
+                                                 &obj->key, sizeof(obj->key));
+    } else {
+        *p++ = OSSL_PARAM_construct_int(OSSL_OBJECT_PARAM_TYPE,
+                                        &obj->object_type);
+        if (obj->data_type != NULL)
+            *p++ = OSSL_PARAM_construct_utf8_string(
+                OSSL_OBJECT_PARAM_DATA_TYPE, obj->data_type, 0);
+        if (obj->data_structure != NULL)
+            *p++ = OSSL_PARAM_construct_utf8_string(
+                OSSL_OBJECT_PARAM_DATA_STRUCTURE, (char *)obj->data_structure,
+                0);
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_OBJECT_PARAM_DATA,
+                                                 obj->der, obj->derlen);
+    }
+    *p = OSSL_PARAM_construct_end();
+    ok = object_cb(params, object_cbarg);
+
+    // the callback took the key if it wanted it
+    oqsx_key_free(obj->key);
+    obj->key = NULL;
+    OPENSSL_clear_free(obj->der, obj->derlen);
+    obj->der = NULL;
+    return ok;
+}
+
+static int oqsx_bundle_eof(void *vctx) {
+    OQSX_BUNDLE_CTX *ctx = vctx;
+
+    return ctx->next_load >= ctx->nobjs;
+}
+
+static int oqsx_bundle_close(void *vctx) {
+    OQSX_BUNDLE_CTX *ctx = vctx;
+    size_t i;
+
+    if (ctx == NULL)
+        return 1;
+#ifdef OQSX_BUNDLE_THREADS
+    pthread_mutex_lock(&ctx->lock);
+    ctx->stop = 1;
+    pthread_mutex_unlock(&ctx->lock);
+    for (i = 0; i < (size_t)ctx->nworkers; i++)
+        pthread_join(ctx->workers[i], NULL);
+    OPENSSL_free(ctx->workers);
+    pthread_cond_destroy(&ctx->decoded);
+    pthread_mutex_destroy(&ctx->lock);
+#endif
+    for (i = 0; i < ctx->nobjs; i++) {
+        oqsx_key_free(ctx->objs[i].key);
+        OPENSSL_clear_free(ctx->objs[i].der, ctx->objs[i].derlen);
+        OPENSSL_free(ctx->objs[i].data_type);
+    }
+    OPENSSL_free(ctx->objs);
+    OPENSSL_free(ctx);
+    return 1;
+}
+
+const OSSL_DISPATCH oqs_bundle_store_functions[] = {
+    {OSSL_FUNC_STORE_OPEN, (void (*)(void))oqsx_bundle_open},
+    {OSSL_FUNC_STORE_ATTACH, (void (*)(void))oqsx_bundle_attach},
+    {OSSL_FUNC_STORE_LOAD, (void (*)(void))oqsx_bundle_load},
+    {OSSL_FUNC_STORE_EOF, (void (*)(void))oqsx_bundle_eof},
+    {OSSL_FUNC_STORE_CLOSE, (void (*)(void))oqsx_bundle_close},
+    {0, NULL}};
@@ -570,6 +570,15 @@ static const OSSL_PARAM oqsprovider_param_types[] = {
     OSSL_PARAM_DEFN(OSSL_PROV_PARAM_VERSION, OSSL_PARAM_UTF8_PTR, NULL, 0),
     OSSL_PARAM_DEFN(OSSL_PROV_PARAM_BUILDINFO, OSSL_PARAM_UTF8_PTR, NULL, 0),
     OSSL_PARAM_DEFN(OSSL_PROV_PARAM_STATUS, OSSL_PARAM_INTEGER, NULL, 0),
+    OSSL_PARAM_DEFN(OQS_PROV_PARAM_CPU_FEATURES, OSSL_PARAM_UTF8_STRING, NULL,
+                    0),
+    OSSL_PARAM_DEFN(OQS_PROV_PARAM_IMPLEMENTATIONS, OSSL_PARAM_UTF8_STRING,
+                    NULL, 0),
+    OSSL_PARAM_DEFN(OQS_PROV_PARAM_IMPLEMENTATION_PIN, OSSL_PARAM_UTF8_PTR,
+                    NULL, 0),
+    OSSL_PARAM_DEFN(OQS_PROV_PARAM_SLOW_OPS, OSSL_PARAM_UTF8_STRING, NULL, 0),
+    OSSL_PARAM_DEFN(OQS_PROV_PARAM_SLOW_OP_COUNT, OSSL_PARAM_UNSIGNED_INTEGER,
+                    NULL, 0),
     OSSL_PARAM_END};
 
 static const OSSL_ALGORITHM oqsprovider_signatures[] = {
@@ -987,6 +996,10 @@ static const OSSL_ALGORITHM oqsprovider_decoder[] = {
 #undef DECODER_PROVIDER
 };
 
+static const OSSL_ALGORITHM oqsprovider_store[] = {
+    {"oqsbundle", "provider=oqsprovider", oqs_bundle_store_functions},
+    {NULL, NULL, NULL}};
+
 // get the last number on the composite OID
 int get_composite_idx(int idx) {
     char *s;
@@ -1028,6 +1041,39 @@ static const OSSL_PARAM *oqsprovider_gettable_params(void *provctx) {
 #define OQS_PROVIDER_BUILD_INFO_STR OQS_PROVIDER_BASE_BUILD_INFO_STR
 #endif
 
+/* Fills a string parameter with what "fn" builds */
+static int oqsprovider_get_impl_param(OSSL_PARAM *p,
+                                      size_t (*fn)(char *, size_t)) {
+    size_t len = fn(NULL, 0);
+    char *buf = OPENSSL_malloc(len);
+    int ret;
+
+    if (buf == NULL)
+        return 0;
+    fn(buf, len);
+    ret = OSSL_PARAM_set_utf8_string(p, buf);
+    OPENSSL_free(buf);
+    return ret;
+}
+
+/* Fills the slow operation log parameters, both from one snapshot */
+static int oqsprovider_get_slowlog_params(OSSL_PARAM params[]) {
+    OSSL_PARAM *p = OSSL_PARAM_locate(params, OQS_PROV_PARAM_SLOW_OPS);
+    OSSL_PARAM *pc = OSSL_PARAM_locate(params, OQS_PROV_PARAM_SLOW_OP_COUNT);
+    uint64_t count;
+    char *buf;
+    int ret;
+
+    if (p == NULL && pc == NULL)
+        return 1;
+    if ((buf = oqsx_slowlog_dump(&count)) == NULL)
+        return 0;
+    ret = (p == NULL || OSSL_PARAM_set_utf8_string(p, buf)) &&
+          (pc == NULL || OSSL_PARAM_set_uint64(pc, count));
+    OPENSSL_free(buf);
+    return ret;
+}
+
 static int oqsprovider_get_params(void *provctx, OSSL_PARAM params[]) {
     OSSL_PARAM *p;
 
@@ -1043,6 +1089,18 @@ static int oqsprovider_get_params(void *provctx, OSSL_PARAM params[]) {
     p = OSSL_PARAM_locate(params, OSSL_PROV_PARAM_STATUS);
     if (p != NULL && !OSSL_PARAM_set_int(p, 1)) // provider is always running
         return 0;
+    p = OSSL_PARAM_locate(params, OQS_PROV_PARAM_CPU_FEATURES);
+    if (p != NULL && !oqsprovider_get_impl_param(p, oqsx_impl_cpu_features))
+        return 0;
+    p = OSSL_PARAM_locate(params, OQS_PROV_PARAM_IMPLEMENTATIONS);
+    if (p != NULL && !oqsprovider_get_impl_param(p, oqsx_impl_list))
+        return 0;
+    p = OSSL_PARAM_locate(params, OQS_PROV_PARAM_IMPLEMENTATION_PIN);
+    if (p != NULL &&
+        !OSSL_PARAM_set_utf8_ptr(p, oqsx_impl_get_pin(provctx)))
+        return 0;
+    if (!oqsprovider_get_slowlog_params(params))
+        return 0;
     // not passing in params to respond to is no error; response is empty then
     return 1;
 }
@@ -1062,6 +1120,8 @@ static const OSSL_ALGORITHM *oqsprovider_query(void *provctx, int operation_id,
         return oqsprovider_encoder;
     case OSSL_OP_DECODER:
         return oqsprovider_decoder;
+    case OSSL_OP_STORE:
+        return oqsprovider_store;
     default:
         if (getenv("OQSPROV"))
             printf("Unknown operation %d requested from OQS provider\n",
@@ -1071,7 +1131,10 @@ static const OSSL_ALGORITHM *oqsprovider_query(void *provctx, int operation_id,
 }
 
 static void oqsprovider_teardown(void *provctx) {
+    oqsx_impl_cleanup((PROV_OQS_CTX *)provctx);
+    oqsx_arena_cleanup((PROV_OQS_CTX *)provctx);
     oqsx_freeprovctx((PROV_OQS_CTX *)provctx);
+    oqsx_slowlog_cleanup();
     OQS_destroy();
 }
 
@@ -1101,12 +1164,25 @@ int OQS_PROVIDER_ENTRYPOINT_NAME(const OSSL_CORE_HANDLE *handle,
     OSSL_FUNC_core_obj_add_sigid_fn *c_obj_add_sigid = NULL;
     BIO_METHOD *corebiometh;
     OSSL_LIB_CTX *libctx = NULL;
-    int i, rc = 0;
+    int i, rc = 0, slowlog_init = 0;
     char *opensslv;
     const char *ossl_versionp = NULL;
     OSSL_PARAM version_request[] = {{"openssl-version", OSSL_PARAM_UTF8_PTR,
                                      &opensslv, sizeof(&opensslv), 0},
                                     {NULL, 0, NULL, 0, 0}};
+    char *implp = NULL;
+    const char *impl_pin = NULL;
+    OSSL_PARAM impl_request[] = {
+        {OQS_PROV_CONF_IMPLEMENTATION, OSSL_PARAM_UTF8_PTR, &implp,
+         sizeof(&implp), 0},
+        {NULL, 0, NULL, 0, 0}};
+    char *slow_thresholdp = NULL, *slow_sizep = NULL;
+    OSSL_PARAM slowlog_request[] = {
+        {OQS_PROV_CONF_SLOW_OP_THRESHOLD, OSSL_PARAM_UTF8_PTR, &slow_thresholdp,
+         sizeof(&slow_thresholdp), 0},
+        {OQS_PROV_CONF_SLOW_OP_LOG_SIZE, OSSL_PARAM_UTF8_PTR, &slow_sizep,
+         sizeof(&slow_sizep), 0},
+        {NULL, 0, NULL, 0, 0}};
 
     OQS_init();
 
@@ -1149,6 +1225,25 @@ int OQS_PROVIDER_ENTRYPOINT_NAME(const OSSL_CORE_HANDLE *handle,
         ossl_versionp = *(void **)version_request[0].data;
     }
 
+    // liboqs implementation variant pinned in the provider configuration
+    if (c_get_params(handle, impl_request) &&
+        !oqsx_impl_parse_pin(implp, &impl_pin)) {
+        fprintf(stderr, "OQS PROV: unknown implementation %s configured\n",
+                implp);
+        ERR_raise(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS);
+        goto end_init;
+    }
+
+    // slow operation log as configured, else as set in the environment
+    if (!c_get_params(handle, slowlog_request))
+        slow_thresholdp = slow_sizep = NULL;
+    if (!(slowlog_init = oqsx_slowlog_init(slow_thresholdp, slow_sizep))) {
+        fprintf(stderr, "OQS PROV: invalid or conflicting slow operation log "
+                        "settings\n");
+        ERR_raise(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS);
+        goto end_init;
+    }
+
     // insert all OIDs to the global objects list
     for (i = 0; i < OQS_OID_CNT; i += 2) {
         if (!c_obj_create(handle, oqs_oid_alg_list[i], oqs_oid_alg_list[i + 1],
@@ -1171,12 +1266,6 @@ int OQS_PROVIDER_ENTRYPOINT_NAME(const OSSL_CORE_HANDLE *handle,
             ERR_pop_to_mark();
         }
 
-        if (!oqs_set_nid((char *)oqs_oid_alg_list[i + 1],
-                         OBJ_sn2nid(oqs_oid_alg_list[i + 1]))) {
-            ERR_raise(ERR_LIB_USER, OQSPROV_R_OBJ_CREATE_ERR);
-            goto end_init;
-        }
-
         if (!c_obj_add_sigid(handle, oqs_oid_alg_list[i + 1], "",
                              oqs_oid_alg_list[i + 1])) {
             fprintf(stderr, "error registering %s with no hash\n",
@@ -1199,6 +1288,11 @@ int OQS_PROVIDER_ENTRYPOINT_NAME(const OSSL_CORE_HANDLE *handle,
         }
     }
 
+    // components of composites may only be registered late in the loop above;
+    // NIDs are the same for all instances, so only the first init resolves
+    if (!oqsx_resolve_alg_descs())
+        goto end_init;
+
     // if libctx not yet existing, create a new one
     if (((corebiometh = oqs_bio_prov_init_bio_method()) == NULL) ||
         ((libctx = OSSL_LIB_CTX_new_child(handle, orig_in)) == NULL) ||
@@ -1208,6 +1302,10 @@ int OQS_PROVIDER_ENTRYPOINT_NAME(const OSSL_CORE_HANDLE *handle,
         goto end_init;
     }
 
+    if (!oqsx_arena_init(*provctx, orig_in) ||
+        !oqsx_impl_init(*provctx, impl_pin))
+        goto end_init;
+
     *out = oqsprovider_dispatch_table;
 
     // finally, warn if neither default nor fips provider are present:
@@ -1229,11 +1327,15 @@ end_init:
                 ossl_versionp);
         else
             OQS_PROV_PRINTF("oqsprovider init failed for OpenSSL\n");
-        if (libctx)
-            OSSL_LIB_CTX_free(libctx);
+        // the provider context owns libctx once created
         if (provctx && *provctx) {
             oqsprovider_teardown(*provctx);
             *provctx = NULL;
+        } else {
+            if (libctx)
+                OSSL_LIB_CTX_free(libctx);
+            if (slowlog_init)
+                oqsx_slowlog_cleanup();
         }
     }
     return rc;
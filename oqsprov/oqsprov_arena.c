@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/*
+ * OQS OpenSSL 3 provider
+ *
+ * Per-thread bump allocator for buffers that live only during a single
+ * sign, verify, encapsulation, decapsulation or encoding operation.
+ *
+ * Each thread gets one arena of OQSX_ARENA_SIZE bytes on first use.
+ * Operations record the arena top with oqsx_arena_mark() on entry and reset
+ * it with oqsx_arena_release() on exit, optionally wiping what they used.
+ * Requests not fitting into the arena, and all requests if no provider
+ * instance can be notified of thread termination, are served from the heap
+ * instead.
+ *
+ * Arenas are shared by all provider instances of the process. A new arena
+ * registers a thread stop handler with every instance loaded at that time;
+ * the first handler run frees it. The core drops the handlers of an
+ * instance when unloading it without running them, so arenas whose handlers
+ * are all gone stay on the arena list until the last instance is unloaded,
+ * which frees all arenas left.
+ *
+ * Lock order: instance lock, core thread event lock, arena list lock.
+ */
+
+#include <openssl/core_dispatch.h>
+#include <openssl/crypto.h>
+#include <stdint.h>
+
+#include "oqs_prov.h"
+
+#define OQSX_ARENA_SIZE 16384
+#define OQSX_ARENA_ALIGN 16
+
+typedef struct oqsx_arena_st {
+    unsigned char *buf;
+    size_t top;
+    struct oqsx_arena_st *prev, *next; // on arena_list
+} OQSX_ARENA;
+
+static CRYPTO_ONCE arena_once = CRYPTO_ONCE_STATIC_INIT;
+static int arena_once_ok = 0;
+// guards arena_insts and creating resp. deleting arena_key
+static CRYPTO_RWLOCK *arena_inst_lock = NULL;
+// guards arena_list and arena_active
+static CRYPTO_RWLOCK *arena_list_lock = NULL;
+static PROV_OQS_CTX *arena_insts = NULL;
+static OQSX_ARENA *arena_list = NULL;
+static CRYPTO_THREAD_LOCAL arena_key;
+// set while arena_key is valid, i.e. while any instance is loaded
+#ifndef OQS_PROVIDER_NOATOMIC
+static _Atomic int arena_active = 0;
+#else
+static int arena_active = 0;
+#endif
+
+static void oqsx_arena_init_once(void) {
+    arena_inst_lock = CRYPTO_THREAD_lock_new();
+    arena_list_lock = CRYPTO_THREAD_lock_new();
+    arena_once_ok = arena_inst_lock != NULL && arena_list_lock != NULL;
+}
+
+static int oqsx_arena_is_active(void) {
+#ifndef OQS_PROVIDER_NOATOMIC
+    return atomic_load_explicit(&arena_active, memory_order_acquire);
+#else
+    int active = 0;
+
+    if (CRYPTO_THREAD_read_lock(arena_list_lock)) {
+        active = arena_active;
+        CRYPTO_THREAD_unlock(arena_list_lock);
+    }
+    return active;
+#endif
+}
+
+// with arena_list_lock held
+static void oqsx_arena_unlink_free(OQSX_ARENA *arena) {
+    if (arena->prev != NULL)
+        arena->prev->next = arena->next;
+    else
+        arena_list = arena->next;
+    if (arena->next != NULL)
+        arena->next->prev = arena->prev;
+    OPENSSL_clear_free(arena->buf, OQSX_ARENA_SIZE);
+    OPENSSL_free(arena);
+}
+
+/* Thread stop handler registered with every instance; runs in the thread
+ * ending, so the arena is found through the thread local.
+ */
+static void oqsx_arena_thread_stop(void *arg) {
+    OQSX_ARENA *arena;
+
+    if (!CRYPTO_THREAD_write_lock(arena_list_lock))
+        return;
+    // the last instance may just have freed all arenas and arena_key
+    if (arena_active &&
+        (arena = CRYPTO_THREAD_get_local(&arena_key)) != NULL) {
+        CRYPTO_THREAD_set_local(&arena_key, NULL);
+        oqsx_arena_unlink_free(arena);
+    }
+    CRYPTO_THREAD_unlock(arena_list_lock);
+}
+
+int oqsx_arena_init(PROV_OQS_CTX *provctx, const OSSL_DISPATCH *fns) {
+    int ret = 0;
+
+    for (; fns->function_id != 0; fns++) {
+        if (fns->function_id == OSSL_FUNC_CORE_THREAD_START)
+            provctx->core_thread_start = OSSL_FUNC_core_thread_start(fns);
+    }
+    if (!CRYPTO_THREAD_run_once(&arena_once, oqsx_arena_init_once) ||
+        !arena_once_ok || !CRYPTO_THREAD_write_lock(arena_inst_lock))
+        return 0;
+    if (arena_insts == NULL) {
+        if (!CRYPTO_THREAD_init_local(&arena_key, NULL) ||
+            !CRYPTO_THREAD_write_lock(arena_list_lock))
+            goto end;
+        arena_active = 1;
+        CRYPTO_THREAD_unlock(arena_list_lock);
+    }
+    provctx->arena_next = arena_insts;
+    arena_insts = provctx;
+    ret = 1;
+
+end:
+    CRYPTO_THREAD_unlock(arena_inst_lock);
+    return ret;
+}
+
+void oqsx_arena_cleanup(PROV_OQS_CTX *provctx) {
+    PROV_OQS_CTX **pp;
+
+    if (!arena_once_ok || !CRYPTO_THREAD_write_lock(arena_inst_lock))
+        return;
+    for (pp = &arena_insts; *pp != NULL && *pp != provctx;
+         pp = &(*pp)->arena_next)
+        ;
+    // nothing to do for instances failing init before registration
+    if (*pp == NULL)
+        goto end;
+    *pp = provctx->arena_next;
+    provctx->arena_next = NULL;
+    if (arena_insts != NULL || !CRYPTO_THREAD_write_lock(arena_list_lock))
+        goto end;
+    arena_active = 0;
+    while (arena_list != NULL)
+        oqsx_arena_unlink_free(arena_list);
+    CRYPTO_THREAD_unlock(arena_list_lock);
+    CRYPTO_THREAD_cleanup_local(&arena_key);
+
+end:
+    CRYPTO_THREAD_unlock(arena_inst_lock);
+}
+
+static OQSX_ARENA *oqsx_arena_new(void) {
+    OQSX_ARENA *arena = NULL;
+    PROV_OQS_CTX *inst;
+    int registered = 0;
+
+    if (!CRYPTO_THREAD_read_lock(arena_inst_lock))
+        return NULL;
+    if (arena_insts == NULL ||
+        (arena = OPENSSL_zalloc(sizeof(*arena))) == NULL ||
+        (arena->buf = OPENSSL_malloc(OQSX_ARENA_SIZE)) == NULL)
+        goto err;
+    for (inst = arena_insts; inst != NULL; inst = inst->arena_next) {
+        if (inst->core_thread_start != NULL &&
+            inst->core_thread_start(inst->handle, oqsx_arena_thread_stop,
+                                    NULL))
+            registered = 1;
+    }
+    // without a handler the arena would never be freed before unload
+    if (!registered || !CRYPTO_THREAD_write_lock(arena_list_lock))
+        goto err;
+    if (!CRYPTO_THREAD_set_local(&arena_key, arena)) {
+        CRYPTO_THREAD_unlock(arena_list_lock);
+        goto err;
+    }
+    arena->next = arena_list;
+    if (arena_list != NULL)
+        arena_list->prev = arena;
+    arena_list = arena;
+    CRYPTO_THREAD_unlock(arena_list_lock);
+    CRYPTO_THREAD_unlock(arena_inst_lock);
+    return arena;
+
+err:
+    CRYPTO_THREAD_unlock(arena_inst_lock);
+    if (arena != NULL)
+        OPENSSL_free(arena->buf);
+    OPENSSL_free(arena);
+    return NULL;
+}
+
+static OQSX_ARENA *oqsx_arena_get(int create) {
+    OQSX_ARENA *arena;
+
+    if (!arena_once_ok || !oqsx_arena_is_active())
+        return NULL;
+    arena = CRYPTO_THREAD_get_local(&arena_key);
+    if (arena != NULL || !create)
+        return arena;
+    return oqsx_arena_new();
+}
+
+static int oqsx_arena_owns(const OQSX_ARENA *arena, const void *ptr) {
+    uintptr_t p = (uintptr_t)ptr, start = (uintptr_t)arena->buf;
+
+    return p >= start && p < start + OQSX_ARENA_SIZE;
+}
+
+size_t oqsx_arena_mark(void) {
+    OQSX_ARENA *arena = oqsx_arena_get(0);
+
+    return arena != NULL ? arena->top : 0;
+}
+
+void *oqsx_arena_alloc(size_t len) {
+    OQSX_ARENA *arena;
+    size_t alloclen;
+    void *ptr;
+
+    if (len > 0 && len <= OQSX_ARENA_SIZE &&
+        (arena = oqsx_arena_get(1)) != NULL) {
+        alloclen =
+            (len + OQSX_ARENA_ALIGN - 1) & ~(size_t)(OQSX_ARENA_ALIGN - 1);
+        if (alloclen <= OQSX_ARENA_SIZE - arena->top) {
+            ptr = arena->buf + arena->top;
+            arena->top += alloclen;
+            return ptr;
+        }
+    }
+    return OPENSSL_malloc(len);
+}
+
+void oqsx_arena_free(void *ptr, size_t len) {
+    OQSX_ARENA *arena = oqsx_arena_get(0);
+
+    // arena memory is reclaimed by oqsx_arena_release
+    if (ptr == NULL || (arena != NULL && oqsx_arena_owns(arena, ptr)))
+        return;
+    OPENSSL_clear_free(ptr, len);
+}
+
+void oqsx_arena_release(size_t mark, int wipe) {
+    OQSX_ARENA *arena = oqsx_arena_get(0);
+
+    if (arena == NULL || mark > arena->top)
+        return;
+    if (wipe)
+        OPENSSL_cleanse(arena->buf + mark, arena->top - mark);
+    arena->top = mark;
+}
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <openssl/core_dispatch.h>
 #include <openssl/core_names.h>
+#include <openssl/crypto.h>
 #include <string.h>
 
 /* For TLS1_VERSION etc */
@@ -30,6 +31,9 @@ typedef struct oqs_group_constants_st {
     int mindtls;           /* Minimum DTLS version, -1 unsupported */
     int maxdtls;           /* Maximum DTLS version (or 0 for undefined) */
     int is_kem;            /* Always set */
+    /* Filled in on first use, see oqs_capability_sizes() */
+    unsigned int keyshare_len;   /* Client key share */
+    unsigned int ciphertext_len; /* Server key share */
 } OQS_GROUP_CONSTANTS;
 
 static OQS_GROUP_CONSTANTS oqs_group_list[] = {
@@ -132,10 +136,14 @@ static OQS_GROUP_CONSTANTS oqs_group_list[] = {
                            (unsigned int *)&oqs_group_list[idx].maxdtls),      \
             OSSL_PARAM_int(OSSL_CAPABILITY_TLS_GROUP_IS_KEM,                   \
                            (unsigned int *)&oqs_group_list[idx].is_kem),       \
+            OSSL_PARAM_uint(OQS_CAPABILITY_TLS_GROUP_KEYSHARE_LEN,             \
+                            &oqs_group_list[idx].keyshare_len),                \
+            OSSL_PARAM_uint(OQS_CAPABILITY_TLS_GROUP_CIPHERTEXT_LEN,           \
+                            &oqs_group_list[idx].ciphertext_len),              \
             OSSL_PARAM_END                                                     \
     }
 
-static const OSSL_PARAM oqs_param_group_list[][11] = {
+static const OSSL_PARAM oqs_param_group_list[][13] = {
 ///// OQS_TEMPLATE_FRAGMENT_GROUP_NAMES_START
 
 #ifdef OQS_ENABLE_KEM_frodokem_640_aes
@@ -260,6 +268,9 @@ typedef struct oqs_sigalg_constants_st {
     unsigned int secbits;    /* Bits of security */
     int mintls;              /* Minimum TLS version, -1 unsupported */
     int maxtls;              /* Maximum TLS version (or 0 for undefined) */
+    /* Filled in on first use, see oqs_capability_sizes() */
+    unsigned int pubkey_len; /* Public key */
+    unsigned int sig_len;    /* Maximum signature length */
 } OQS_SIGALG_CONSTANTS;
 
 static OQS_SIGALG_CONSTANTS oqs_sigalg_list[] = {
@@ -601,6 +612,26 @@ int oqs_patch_codepoints() {
     return 1;
 }
 
+/* Sets the size parameters "publen" and "outlen" of capability "entry"
+ * for the algorithm named by its "name" parameter; they point into
+ * oqs_group_list resp. oqs_sigalg_list.
+ */
+static void oqs_capability_set_sizes(const OSSL_PARAM *entry, const char *name,
+                                     const char *publen, const char *outlen) {
+    const OSSL_PARAM *p, *q;
+    const char *alg = NULL;
+    size_t pub, out;
+
+    if ((p = OSSL_PARAM_locate_const(entry, publen)) == NULL ||
+        (q = OSSL_PARAM_locate_const(entry, outlen)) == NULL ||
+        (entry = OSSL_PARAM_locate_const(entry, name)) == NULL ||
+        !OSSL_PARAM_get_utf8_string_ptr(entry, &alg) ||
+        !oqsx_alg_tls_sizes(alg, &pub, &out))
+        return;
+    *(unsigned int *)p->data = (unsigned int)pub;
+    *(unsigned int *)q->data = (unsigned int)out;
+}
+
 static int oqs_group_capability(OSSL_CALLBACK *cb, void *arg) {
     size_t i;
 
@@ -629,6 +660,10 @@ static int oqs_group_capability(OSSL_CALLBACK *cb, void *arg) {
                            (unsigned int *)&oqs_sigalg_list[idx].mintls),      \
             OSSL_PARAM_int(OSSL_CAPABILITY_TLS_SIGALG_MAX_TLS,                 \
                            (unsigned int *)&oqs_sigalg_list[idx].maxtls),      \
+            OSSL_PARAM_uint(OQS_CAPABILITY_TLS_SIGALG_PUBKEY_LEN,              \
+                            &oqs_sigalg_list[idx].pubkey_len),                 \
+            OSSL_PARAM_uint(OQS_CAPABILITY_TLS_SIGALG_SIG_LEN,                 \
+                            &oqs_sigalg_list[idx].sig_len),                    \
             OSSL_PARAM_END                                                     \
     }
 
@@ -790,8 +825,33 @@ static int oqs_sigalg_capability(OSSL_CALLBACK *cb, void *arg) {
 }
 #endif /* OSSL_CAPABILITY_TLS_SIGALG_NAME */
 
+/* Sizes only depend on the liboqs and classic parameters, not on any key
+ * or library context, so they are computed once per process.
+ */
+static CRYPTO_ONCE oqs_sizes_once = CRYPTO_ONCE_STATIC_INIT;
+
+static void oqs_capability_sizes(void) {
+    size_t i;
+
+    for (i = 0; i < OSSL_NELEM(oqs_param_group_list); i++)
+        oqs_capability_set_sizes(
+            oqs_param_group_list[i], OSSL_CAPABILITY_TLS_GROUP_NAME_INTERNAL,
+            OQS_CAPABILITY_TLS_GROUP_KEYSHARE_LEN,
+            OQS_CAPABILITY_TLS_GROUP_CIPHERTEXT_LEN);
+#ifdef OSSL_CAPABILITY_TLS_SIGALG_NAME
+    for (i = 0; i < OSSL_NELEM(oqs_param_sigalg_list); i++)
+        oqs_capability_set_sizes(oqs_param_sigalg_list[i],
+                                 OSSL_CAPABILITY_TLS_SIGALG_NAME,
+                                 OQS_CAPABILITY_TLS_SIGALG_PUBKEY_LEN,
+                                 OQS_CAPABILITY_TLS_SIGALG_SIG_LEN);
+#endif
+}
+
 int oqs_provider_get_capabilities(void *provctx, const char *capability,
                                   OSSL_CALLBACK *cb, void *arg) {
+    // sizes stay 0 ("not known") if this fails
+    CRYPTO_THREAD_run_once(&oqs_sizes_once, oqs_capability_sizes);
+
     if (strcasecmp(capability, "TLS-GROUP") == 0)
         return oqs_group_capability(cb, arg);
 
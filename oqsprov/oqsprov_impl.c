@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/*
+ * OQS OpenSSL 3 provider
+ *
+ * Reports which implementation variant liboqs runs for each algorithm and
+ * which CPU extensions it detected, and enforces the variant pinned by the
+ * configuration option "implementation" of each provider instance.
+ *
+ * liboqs selects the variant of an algorithm inside OQS_SIG_new and
+ * OQS_KEM_new: an optimized one is used if it was built and, in
+ * OQS_DIST_BUILD builds, if the CPU has the extensions it needs; otherwise
+ * the portable one. Which optimized variants were built is generated from
+ * liboqs' oqsconfig.h at build time (oqsprov_impl_variants.h, see
+ * oqsprov/CMakeLists.txt); algorithms without one are reported as
+ * "default". liboqs does not expose which CPU extensions a variant checks
+ * for: AVX2 variants are taken to need AVX2, which every one checks, and at
+ * most BMI1, BMI2, POPCNT and PCLMULQDQ in addition, aarch64 variants to
+ * need NEON. On a CPU with AVX2 but without all of these extensions, the
+ * variant run cannot be told and is reported as "unknown". liboqs cannot be
+ * told to use another variant than it selects, so pinning refuses to create
+ * keys for algorithms running any other variant than the pinned one.
+ */
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <string.h>
+
+#include "oqs_prov.h"
+
+#define EXT(e) (1u << OQS_CPU_EXT_##e)
+// the most any AVX2 variant of liboqs checks for besides AVX2
+#define X86_AVX2_EXTRA (EXT(BMI1) | EXT(BMI2) | EXT(POPCNT) | EXT(PCLMULQDQ))
+
+typedef struct {
+    const char *alg;
+    const char *variant; /* "avx2" or "aarch64" */
+} OQSX_IMPL_VARIANT;
+
+static const OQSX_IMPL_VARIANT oqsx_impl_variants[] = {
+#include "oqsprov_impl_variants.h"
+    {NULL, NULL}};
+
+static const struct {
+    OQS_CPU_EXT ext;
+    const char *name;
+} oqsx_cpu_ext_names[] = {
+    {OQS_CPU_EXT_ADX, "adx"},
+    {OQS_CPU_EXT_AES, "aes"},
+    {OQS_CPU_EXT_AVX, "avx"},
+    {OQS_CPU_EXT_AVX2, "avx2"},
+    {OQS_CPU_EXT_AVX512, "avx512"},
+    {OQS_CPU_EXT_BMI1, "bmi1"},
+    {OQS_CPU_EXT_BMI2, "bmi2"},
+    {OQS_CPU_EXT_PCLMULQDQ, "pclmulqdq"},
+    {OQS_CPU_EXT_VPCLMULQDQ, "vpclmulqdq"},
+    {OQS_CPU_EXT_POPCNT, "popcnt"},
+    {OQS_CPU_EXT_SSE, "sse"},
+    {OQS_CPU_EXT_SSE2, "sse2"},
+    {OQS_CPU_EXT_SSE3, "sse3"},
+    {OQS_CPU_EXT_ARM_AES, "arm_aes"},
+    {OQS_CPU_EXT_ARM_SHA2, "arm_sha2"},
+    {OQS_CPU_EXT_ARM_SHA3, "arm_sha3"},
+    {OQS_CPU_EXT_ARM_NEON, "arm_neon"}};
+
+/* Instances with a pin, found by their library context when creating keys.
+ * Keys are only ever created with the library context of the instance whose
+ * key management they belong to, or without one while decoding; decoders
+ * check the key again once they know the instance, see oqs_decode_der2key.c.
+ */
+static CRYPTO_ONCE impl_once = CRYPTO_ONCE_STATIC_INIT;
+static int impl_once_ok = 0;
+// guards impl_pinned and impl_any
+static CRYPTO_RWLOCK *impl_lock = NULL;
+static PROV_OQS_CTX *impl_pinned = NULL;
+// set while impl_pinned is not empty, sparing key creation the lock then
+#ifndef OQS_PROVIDER_NOATOMIC
+static _Atomic int impl_any = 0;
+#else
+static int impl_any = 0;
+#endif
+
+static void oqsx_impl_init_once(void) {
+    impl_lock = CRYPTO_THREAD_lock_new();
+    impl_once_ok = impl_lock != NULL;
+}
+
+static int oqsx_impl_any_pinned(void) {
+#ifndef OQS_PROVIDER_NOATOMIC
+    return atomic_load_explicit(&impl_any, memory_order_acquire);
+#else
+    int any = 0;
+
+    if (CRYPTO_THREAD_read_lock(impl_lock)) {
+        any = impl_any;
+        CRYPTO_THREAD_unlock(impl_lock);
+    }
+    return any;
+#endif
+}
+
+static int oqsx_cpu_has(unsigned int exts) {
+    size_t i;
+
+    for (i = 0; i < OQS_CPU_EXT_COUNT; i++)
+        if ((exts & (1u << i)) != 0 && !OQS_CPU_has_extension((OQS_CPU_EXT)i))
+            return 0;
+    return 1;
+}
+
+/* Returns the variant liboqs runs for an algorithm built with the optimized
+ * "variant": that one, "portable" or "unknown". */
+static const char *oqsx_impl_select(const char *variant) {
+#ifdef OQS_DIST_BUILD
+    if (strcmp(variant, "avx2") == 0) {
+        if (!oqsx_cpu_has(EXT(AVX2)))
+            return "portable";
+        if (!oqsx_cpu_has(X86_AVX2_EXTRA))
+            return "unknown";
+    } else if (!oqsx_cpu_has(EXT(ARM_NEON))) {
+        return "portable";
+    }
+#endif
+    // without runtime dispatch the optimized variant built always runs
+    return variant;
+}
+
+const char *oqsx_impl_of(const char *oqs_name) {
+    const OQSX_IMPL_VARIANT *v;
+    const char *ret = "default", *impl;
+
+    for (v = oqsx_impl_variants; v->alg != NULL; v++) {
+        if (strcmp(v->alg, oqs_name) != 0)
+            continue;
+        impl = oqsx_impl_select(v->variant);
+        if (strcmp(impl, "portable") != 0)
+            return impl;
+        ret = impl;
+    }
+    return ret;
+}
+
+int oqsx_impl_parse_pin(const char *pin, const char **variant) {
+    static const char *const variants[] = {"portable", "avx2", "aarch64"};
+    size_t i;
+
+    *variant = NULL;
+    if (pin == NULL || *pin == '\0' || strcmp(pin, "auto") == 0)
+        return 1;
+    for (i = 0; i < OSSL_NELEM(variants); i++) {
+        if (strcmp(pin, variants[i]) == 0) {
+            *variant = variants[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int oqsx_impl_init(PROV_OQS_CTX *provctx, const char *variant) {
+    provctx->impl_pin = variant;
+    if (variant == NULL)
+        return 1;
+    if (!CRYPTO_THREAD_run_once(&impl_once, oqsx_impl_init_once) ||
+        !impl_once_ok || !CRYPTO_THREAD_write_lock(impl_lock))
+        return 0;
+    provctx->impl_next = impl_pinned;
+    impl_pinned = provctx;
+    impl_any = 1;
+    CRYPTO_THREAD_unlock(impl_lock);
+    return 1;
+}
+
+void oqsx_impl_cleanup(PROV_OQS_CTX *provctx) {
+    PROV_OQS_CTX **pp;
+
+    if (provctx->impl_pin == NULL || !impl_once_ok ||
+        !CRYPTO_THREAD_write_lock(impl_lock))
+        return;
+    for (pp = &impl_pinned; *pp != NULL && *pp != provctx;
+         pp = &(*pp)->impl_next)
+        ;
+    if (*pp != NULL) {
+        *pp = provctx->impl_next;
+        provctx->impl_next = NULL;
+    }
+    impl_any = impl_pinned != NULL;
+    CRYPTO_THREAD_unlock(impl_lock);
+}
+
+const char *oqsx_impl_get_pin(const PROV_OQS_CTX *provctx) {
+    return provctx->impl_pin != NULL ? provctx->impl_pin : "auto";
+}
+
+int oqsx_impl_check(OSSL_LIB_CTX *libctx, const char *oqs_name) {
+    const PROV_OQS_CTX *inst;
+    const char *pin = NULL, *impl;
+
+    if (libctx == NULL || oqs_name == NULL || !oqsx_impl_any_pinned() ||
+        !CRYPTO_THREAD_read_lock(impl_lock))
+        return 1;
+    for (inst = impl_pinned; inst != NULL; inst = inst->impl_next) {
+        if (inst->libctx == libctx) {
+            pin = inst->impl_pin;
+            break;
+        }
+    }
+    CRYPTO_THREAD_unlock(impl_lock);
+    if (pin == NULL)
+        return 1;
+    impl = oqsx_impl_of(oqs_name);
+    // single variant algorithms run the same code whatever is pinned
+    if (strcmp(impl, "default") == 0 || strcmp(impl, pin) == 0)
+        return 1;
+    ERR_raise_data(ERR_LIB_USER, OQSPROV_R_UNSUPPORTED,
+                   "%s runs the %s implementation, %s is pinned", oqs_name,
+                   impl, pin);
+    return 0;
+}
+
+/* Appends "sep" and "str" to the buffer of length "len" at "*pos", or only
+ * counts the space needed if "buf" is NULL. */
+static void oqsx_impl_append(char *buf, size_t *pos, size_t len,
+                             const char *sep, const char *str) {
+    size_t n = strlen(sep) + strlen(str);
+
+    if (buf != NULL && *pos + n < len)
+        BIO_snprintf(buf + *pos, len - *pos, "%s%s", sep, str);
+    *pos += n;
+}
+
+size_t oqsx_impl_cpu_features(char *buf, size_t len) {
+    size_t i, pos = 0;
+
+    for (i = 0; i < OSSL_NELEM(oqsx_cpu_ext_names); i++)
+        if (OQS_CPU_has_extension(oqsx_cpu_ext_names[i].ext))
+            oqsx_impl_append(buf, &pos, len, pos == 0 ? "" : ",",
+                             oqsx_cpu_ext_names[i].name);
+    return pos + 1;
+}
+
+size_t oqsx_impl_list(char *buf, size_t len) {
+    const char *alg;
+    size_t pos = 0;
+    int i;
+
+    for (i = 0; i < OQS_SIG_alg_count(); i++) {
+        alg = OQS_SIG_alg_identifier(i);
+        if (!OQS_SIG_alg_is_enabled(alg))
+            continue;
+        oqsx_impl_append(buf, &pos, len, pos == 0 ? "" : ",", alg);
+        oqsx_impl_append(buf, &pos, len, "=", oqsx_impl_of(alg));
+    }
+    for (i = 0; i < OQS_KEM_alg_count(); i++) {
+        alg = OQS_KEM_alg_identifier(i);
+        if (!OQS_KEM_alg_is_enabled(alg))
+            continue;
+        oqsx_impl_append(buf, &pos, len, pos == 0 ? "" : ",", alg);
+        oqsx_impl_append(buf, &pos, len, "=", oqsx_impl_of(alg));
+    }
+    return pos + 1;
+}
@@ -9,10 +9,13 @@
  */
 
 #include <assert.h>
+#include <openssl/core_dispatch.h>
 #include <openssl/core_names.h>
+#include <openssl/crypto.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
 #include <openssl/params.h>
+#include <openssl/rand.h>
 #include <openssl/rsa.h>
 #include <openssl/x509.h>
 #include <string.h>
@@ -39,14 +42,6 @@ typedef enum { KEY_OP_PUBLIC, KEY_OP_PRIVATE, KEY_OP_KEYGEN } oqsx_key_op_t;
 
 /// NID/name table
 
-typedef struct {
-    int nid;
-    char *tlsname;
-    char *oqsname;
-    int keytype;
-    int secbits;
-} oqs_nid_name_t;
-
 static int oqsx_key_recreate_classickey(OQSX_KEY *key, oqsx_key_op_t op);
 
 ///// OQS_TEMPLATE_FRAGMENT_OQSNAMES_START
@@ -198,17 +193,6 @@ static oqs_nid_name_t nid_names[NID_TABLE_LEN] = {
     ///// OQS_TEMPLATE_FRAGMENT_OQSNAMES_END
 };
 
-int oqs_set_nid(char *tlsname, int nid) {
-    int i;
-    for (i = 0; i < NID_TABLE_LEN; i++) {
-        if (!strcmp(nid_names[i].tlsname, tlsname)) {
-            nid_names[i].nid = nid;
-            return 1;
-        }
-    }
-    return 0;
-}
-
 static int get_secbits(int nid) {
     int i;
     for (i = 0; i < NID_TABLE_LEN; i++) {
@@ -284,6 +268,80 @@ int get_oqsalg_idx(int nid) {
     return -1;
 }
 
+static CRYPTO_ONCE alg_descs_once = CRYPTO_ONCE_STATIC_INIT;
+static int alg_descs_ok = 0;
+
+/* Objects added to the OBJ table are never freed before library cleanup, so
+ * the pointers can be handed out for the lifetime of the provider. NIDs are
+ * the same for every provider instance, as the OBJ table is global.
+ */
+static void oqsx_resolve_alg_descs_once(void) {
+    int i, j, len;
+    oqs_nid_name_t *d;
+    const char *s;
+
+    for (i = 0; i < NID_TABLE_LEN; i++) {
+        d = &nid_names[i];
+        // entries without registered OID stay unresolved
+        if ((d->nid = OBJ_sn2nid(d->tlsname)) == NID_undef)
+            continue;
+        s = d->tlsname;
+        len = strlen(s);
+        for (j = 0; j < len && s[j] != '_'; j++)
+            ;
+        if (j < len) {
+            if (j >= OQSX_CMP_NAME_LEN || len - j - 1 >= OQSX_CMP_NAME_LEN) {
+                ERR_raise_data(ERR_LIB_USER, OQSPROV_R_INTERNAL_ERROR,
+                               "component names of %s too long", s);
+                return;
+            }
+            memcpy(d->cmp_name[0], s, j);
+            memcpy(d->cmp_name[1], s + j + 1, len - j - 1);
+            d->cmp_nid[0] = OBJ_sn2nid(d->cmp_name[0]);
+            d->cmp_nid[1] = OBJ_sn2nid(d->cmp_name[1]);
+        }
+        if ((d->obj = OBJ_nid2obj(d->nid)) == NULL) {
+            ERR_raise(ERR_LIB_USER, OQSPROV_R_OBJ_CREATE_ERR);
+            return;
+        }
+    }
+    alg_descs_ok = 1;
+}
+
+int oqsx_resolve_alg_descs(void) {
+    if (!CRYPTO_THREAD_run_once(&alg_descs_once, oqsx_resolve_alg_descs_once))
+        return 0;
+    if (!alg_descs_ok)
+        ERR_raise(ERR_LIB_USER, OQSPROV_R_INTERNAL_ERROR);
+    return alg_descs_ok;
+}
+
+const oqs_nid_name_t *oqsx_alg_desc(const char *tlsname) {
+    int i;
+
+    if (tlsname == NULL)
+        return NULL;
+    for (i = 0; i < NID_TABLE_LEN; i++) {
+        if (nid_names[i].obj != NULL && !strcmp(nid_names[i].tlsname, tlsname))
+            return &nid_names[i];
+    }
+    return NULL;
+}
+
+int oqsx_key_nid(const OQSX_KEY *key) {
+    if (key->desc != NULL)
+        return key->desc->nid;
+    return OBJ_sn2nid(key->tls_name);
+}
+
+char *oqsx_key_cmpname(const OQSX_KEY *key, int index) {
+    if (index < 0 || index > 1)
+        return NULL;
+    if (key->desc == NULL || key->desc->cmp_name[index][0] == '\0')
+        return get_cmpname(OBJ_sn2nid(key->tls_name), index);
+    return OPENSSL_strdup(key->desc->cmp_name[index]);
+}
+
 /* Prepare composite data structures. RetVal 0 is error. */
 static int oqsx_key_set_composites(OQSX_KEY *key) {
     int ret = 1;
@@ -456,11 +514,12 @@ static const OQSX_EVP_INFO nids_ecx[] = {
     {0, 0, 0, 0, 0, 0, 0}                   // 256 bit
 };
 
-static int oqsx_hybsig_init(int bit_security, OQSX_EVP_CTX *evp_ctx,
-                            char *algname) {
-    int ret = 1;
+/* Classic parameters of hybrid signature component "algname" */
+static const OQSX_EVP_INFO *oqsx_hybsig_info(int bit_security,
+                                             const char *algname) {
     int idx = (bit_security - 128) / 64;
-    ON_ERR_GOTO(idx < 0 || idx > 5, err_init);
+    if (idx < 0 || idx > 5)
+        return NULL;
 
     if (!strncmp(algname, "rsa", 3) || !strncmp(algname, "pss", 3)) {
         idx += 5;
@@ -472,17 +531,42 @@ static int oqsx_hybsig_init(int bit_security, OQSX_EVP_CTX *evp_ctx,
                 idx += 1;
         } else {
             OQS_KEY_PRINTF2("OQS KEY: Incorrect hybrid name: %s\n", algname);
-            ret = 0;
-            goto err_init;
+            return NULL;
         }
     }
 
-    ON_ERR_GOTO(idx < 0 || idx > 6, err_init);
+    if (idx < 0 || idx > 6)
+        return NULL;
+    if (algname[0] == 'e') // ED25519 or ED448
+        return &nids_sig[idx + 7];
+    return &nids_sig[idx];
+}
+
+/* Classic parameters of hybrid KEM "tls_name" of the given key type */
+static const OQSX_EVP_INFO *oqsx_hybkem_info(int primitive,
+                                             const char *tls_name) {
+    const char **names = primitive == KEY_TYPE_ECP_HYB_KEM ? OQSX_ECP_NAMES
+                                                           : OQSX_ECX_NAMES;
+    const OQSX_EVP_INFO *info =
+        primitive == KEY_TYPE_ECP_HYB_KEM ? nids_ecp : nids_ecx;
+    int idx;
+
+    for (idx = 0; names[idx] != NULL; idx++) {
+        if (!strncmp(tls_name, names[idx], 4))
+            return &info[idx];
+    }
+    return NULL;
+}
+
+static int oqsx_hybsig_init(int bit_security, OQSX_EVP_CTX *evp_ctx,
+                            char *algname) {
+    int ret = 1;
+
+    evp_ctx->evp_info = oqsx_hybsig_info(bit_security, algname);
+    ON_ERR_SET_GOTO(!evp_ctx->evp_info, ret, 0, err_init);
 
     if (algname[0] == 'e') // ED25519 or ED448
     {
-        evp_ctx->evp_info = &nids_sig[idx + 7];
-
         evp_ctx->keyParam = EVP_PKEY_new();
         ON_ERR_SET_GOTO(!evp_ctx->keyParam, ret, -1, err_init);
 
@@ -492,12 +576,10 @@ static int oqsx_hybsig_init(int bit_security, OQSX_EVP_CTX *evp_ctx,
         evp_ctx->ctx = EVP_PKEY_CTX_new(evp_ctx->keyParam, NULL);
         ON_ERR_SET_GOTO(!evp_ctx->ctx, ret, -1, err_init);
     } else {
-        evp_ctx->evp_info = &nids_sig[idx];
-
         evp_ctx->ctx = EVP_PKEY_CTX_new_id(evp_ctx->evp_info->keytype, NULL);
         ON_ERR_GOTO(!evp_ctx->ctx, err_init);
 
-        if (idx < 5) { // EC
+        if (evp_ctx->evp_info->keytype == EVP_PKEY_EC) {
             ret = EVP_PKEY_paramgen_init(evp_ctx->ctx);
             ON_ERR_GOTO(ret <= 0, err_init);
 
@@ -522,15 +604,9 @@ err_init:
 
 static const int oqshybkem_init_ecp(char *tls_name, OQSX_EVP_CTX *evp_ctx) {
     int ret = 1;
-    int idx = 0;
-    while (idx < OSSL_NELEM(OQSX_ECP_NAMES)) {
-        if (!strncmp(tls_name, OQSX_ECP_NAMES[idx], 4))
-            break;
-        idx++;
-    }
-    ON_ERR_GOTO(idx < 0 || idx > 2, err_init_ecp);
 
-    evp_ctx->evp_info = &nids_ecp[idx];
+    evp_ctx->evp_info = oqsx_hybkem_info(KEY_TYPE_ECP_HYB_KEM, tls_name);
+    ON_ERR_GOTO(!evp_ctx->evp_info, err_init_ecp);
 
     evp_ctx->ctx = EVP_PKEY_CTX_new_id(evp_ctx->evp_info->keytype, NULL);
     ON_ERR_GOTO(!evp_ctx->ctx, err_init_ecp);
@@ -551,16 +627,9 @@ err_init_ecp:
 
 static const int oqshybkem_init_ecx(char *tls_name, OQSX_EVP_CTX *evp_ctx) {
     int ret = 1;
-    int idx = 0;
-
-    while (idx < OSSL_NELEM(OQSX_ECX_NAMES)) {
-        if (!strncmp(tls_name, OQSX_ECX_NAMES[idx], 4))
-            break;
-        idx++;
-    }
-    ON_ERR_GOTO(idx < 0 || idx > 2, err_init_ecx);
 
-    evp_ctx->evp_info = &nids_ecx[idx];
+    evp_ctx->evp_info = oqsx_hybkem_info(KEY_TYPE_ECX_HYB_KEM, tls_name);
+    ON_ERR_GOTO(!evp_ctx->evp_info, err_init_ecx);
 
     evp_ctx->keyParam = EVP_PKEY_new();
     ON_ERR_SET_GOTO(!evp_ctx->keyParam, ret, -1, err_init_ecx);
@@ -575,6 +644,87 @@ err_init_ecx:
     return ret;
 }
 
+/* Computes the sizes from the liboqs parameters and the classic parameter
+ * tables above, without creating keys, so the result does not depend on any
+ * library context. Hybrid KEM key shares lack the classic length prefix, see
+ * oqsx_get_params; their ciphertext is the classic peer key followed by the
+ * liboqs ciphertext. Signature sizes are the maxima of oqsx_key_maxsize.
+ */
+int oqsx_alg_tls_sizes(const char *tlsname, size_t *publen, size_t *outlen) {
+    const oqs_nid_name_t *desc = oqsx_alg_desc(tlsname);
+    const OQSX_EVP_INFO *info;
+    OQS_KEM *kem;
+    OQS_SIG *sig;
+    int i, ret = 1;
+
+    *publen = *outlen = 0;
+    if (desc == NULL)
+        return 0;
+    switch (desc->keytype) {
+    case KEY_TYPE_KEM:
+    case KEY_TYPE_ECP_HYB_KEM:
+    case KEY_TYPE_ECX_HYB_KEM:
+        if ((kem = OQS_KEM_new(desc->oqsname)) == NULL)
+            return 0;
+        *publen = kem->length_public_key;
+        *outlen = kem->length_ciphertext;
+        OQS_KEM_free(kem);
+        if (desc->keytype == KEY_TYPE_KEM)
+            break;
+        if ((info = oqsx_hybkem_info(desc->keytype, desc->tlsname)) == NULL)
+            return 0;
+        *publen += info->length_public_key;
+        *outlen += info->length_public_key;
+        break;
+    case KEY_TYPE_SIG:
+    case KEY_TYPE_HYB_SIG:
+        if ((sig = OQS_SIG_new(desc->oqsname)) == NULL)
+            return 0;
+        *publen = sig->length_public_key;
+        *outlen = sig->length_signature;
+        OQS_SIG_free(sig);
+        if (desc->keytype == KEY_TYPE_SIG)
+            break;
+        if ((info = oqsx_hybsig_info(desc->secbits, desc->tlsname)) == NULL)
+            return 0;
+        *publen += SIZE_OF_UINT32 + info->length_public_key;
+        *outlen += SIZE_OF_UINT32 + info->length_signature;
+        break;
+    case KEY_TYPE_CMP_SIG:
+        *outlen = sizeof(CompositeSignature);
+        for (i = 0; i < 2 && ret; i++) {
+            char *name = desc->cmp_name[i][0] != '\0'
+                             ? OPENSSL_strdup(desc->cmp_name[i])
+                             : get_cmpname(desc->nid, i);
+
+            if (name == NULL)
+                return 0;
+            if (get_oqsname_fromtls(name) != 0) {
+                if ((sig = OQS_SIG_new(get_oqsname_fromtls(name))) == NULL) {
+                    ret = 0;
+                } else {
+                    *publen += sig->length_public_key;
+                    *outlen += sig->length_signature;
+                    OQS_SIG_free(sig);
+                }
+            } else if ((info = oqsx_hybsig_info(desc->secbits, name)) ==
+                       NULL) {
+                ret = 0;
+            } else {
+                *publen += info->length_public_key;
+                *outlen += info->length_signature;
+            }
+            OPENSSL_free(name);
+        }
+        break;
+    default:
+        ret = 0;
+    }
+    if (!ret)
+        *publen = *outlen = 0;
+    return ret;
+}
+
 /* Re-create OQSX_KEY from encoding(s): Same end-state as after ken-gen */
 static OQSX_KEY *oqsx_key_op(const X509_ALGOR *palg, const unsigned char *p,
                              int plen, oqsx_key_op_t op, OSSL_LIB_CTX *libctx,
@@ -639,8 +789,7 @@ static OQSX_KEY *oqsx_key_op(const X509_ALGOR *palg, const unsigned char *p,
             // check if key is the right size
             for (i = 0; i < key->numkeys; i++) {
                 char *name;
-                if ((name = get_cmpname(OBJ_sn2nid(key->tls_name), i)) ==
-                    NULL) {
+                if ((name = oqsx_key_cmpname(key, i)) == NULL) {
                     ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_ENCODING);
                     goto err_key_op;
                 }
@@ -681,8 +830,7 @@ static OQSX_KEY *oqsx_key_op(const X509_ALGOR *palg, const unsigned char *p,
             for (i = 0; i < key->numkeys; i++) {
                 size_t classic_publen = 0;
                 char *name;
-                if ((name = get_cmpname(OBJ_sn2nid(key->tls_name), i)) ==
-                    NULL) {
+                if ((name = oqsx_key_cmpname(key, i)) == NULL) {
                     ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_ENCODING);
                     OPENSSL_secure_clear_free(temp_priv, temp_priv_len);
                     OPENSSL_secure_clear_free(temp_pub, temp_pub_len);
@@ -841,8 +989,7 @@ static int oqsx_key_recreate_classickey(OQSX_KEY *key, oqsx_key_op_t op) {
         if (op == KEY_OP_PUBLIC) {
             for (i = 0; i < key->numkeys; i++) {
                 char *name;
-                if ((name = get_cmpname(OBJ_sn2nid(key->tls_name), i)) ==
-                    NULL) {
+                if ((name = oqsx_key_cmpname(key, i)) == NULL) {
                     ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_ENCODING);
                     goto rec_err;
                 }
@@ -880,8 +1027,7 @@ static int oqsx_key_recreate_classickey(OQSX_KEY *key, oqsx_key_op_t op) {
         if (op == KEY_OP_PRIVATE) {
             for (i = 0; i < key->numkeys; i++) {
                 char *name;
-                if ((name = get_cmpname(OBJ_sn2nid(key->tls_name), i)) ==
-                    NULL) {
+                if ((name = oqsx_key_cmpname(key, i)) == NULL) {
                     ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_ENCODING);
                     goto rec_err;
                 }
@@ -1028,6 +1174,14 @@ rec_err:
     return 0;
 }
 
+/* Composite key components are read as ASN1_STRINGs; the other members of
+ * the ASN1_TYPE value union must not be accessed that way.
+ */
+static int oqsx_cmp_component_ok(const ASN1_TYPE *aType) {
+    return aType->type != V_ASN1_BOOLEAN && aType->type != V_ASN1_NULL &&
+           aType->type != V_ASN1_OBJECT && aType->value.sequence != NULL;
+}
+
 OQSX_KEY *oqsx_key_from_x509pubkey(const X509_PUBKEY *xpk, OSSL_LIB_CTX *libctx,
                                    const char *propq) {
     const unsigned char *p;
@@ -1061,6 +1215,13 @@ OQSX_KEY *oqsx_key_from_x509pubkey(const X509_PUBKEY *xpk, OSSL_LIB_CTX *libctx,
                 aType =
                     sk_ASN1_TYPE_pop(sk); // this remove in FILO order, but we
                                           // need this in the opposite order
+                if (!oqsx_cmp_component_ok(aType)) {
+                    ASN1_TYPE_free(aType);
+                    OPENSSL_clear_free(concat_key, plen);
+                    sk_ASN1_TYPE_pop_free(sk, &ASN1_TYPE_free);
+                    ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_ENCODING);
+                    return NULL;
+                }
                 buf = aType->value.sequence->data;
                 buflen = aType->value.sequence->length;
                 aux += buflen;
@@ -1126,6 +1287,13 @@ OQSX_KEY *oqsx_key_from_pkcs8(const PKCS8_PRIV_KEY_INFO *p8inf,
                 aType =
                     sk_ASN1_TYPE_pop(sk); // this remove in FILO order, but we
                                           // need this in the opposite order
+                if (!oqsx_cmp_component_ok(aType)) {
+                    ASN1_TYPE_free(aType);
+                    OPENSSL_clear_free(concat_key, plen);
+                    sk_ASN1_TYPE_pop_free(sk, &ASN1_TYPE_free);
+                    ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_ENCODING);
+                    return NULL;
+                }
                 p8inf_internal = PKCS8_PRIV_KEY_INFO_new();
                 nid = 0;
                 char *name;
@@ -1309,11 +1477,19 @@ OQSX_KEY *oqsx_key_new(OSSL_LIB_CTX *libctx, char *oqs_name, char *tls_name,
         goto err;
     }
 
+    // refuse keys that would not run the configured implementation variant
+    if (!oqsx_impl_check(libctx, oqs_name))
+        goto err;
+
+    ret->tls_name = OPENSSL_strdup(tls_name);
+    ON_ERR_GOTO(!ret->tls_name, err);
+    ret->desc = oqsx_alg_desc(tls_name);
+
     switch (primitive) {
     case KEY_TYPE_SIG:
         ret->numkeys = 1;
-        ret->comp_privkey = OPENSSL_malloc(sizeof(void *));
-        ret->comp_pubkey = OPENSSL_malloc(sizeof(void *));
+        ret->comp_privkey = OPENSSL_zalloc(sizeof(void *));
+        ret->comp_pubkey = OPENSSL_zalloc(sizeof(void *));
         ON_ERR_GOTO(!ret->comp_privkey || !ret->comp_pubkey, err);
         ret->oqsx_provider_ctx.oqsx_evp_ctx = NULL;
         ret->oqsx_provider_ctx.oqsx_qs_ctx.sig = OQS_SIG_new(oqs_name);
@@ -1334,8 +1510,8 @@ OQSX_KEY *oqsx_key_new(OSSL_LIB_CTX *libctx, char *oqs_name, char *tls_name,
         break;
     case KEY_TYPE_KEM:
         ret->numkeys = 1;
-        ret->comp_privkey = OPENSSL_malloc(sizeof(void *));
-        ret->comp_pubkey = OPENSSL_malloc(sizeof(void *));
+        ret->comp_privkey = OPENSSL_zalloc(sizeof(void *));
+        ret->comp_pubkey = OPENSSL_zalloc(sizeof(void *));
         ON_ERR_GOTO(!ret->comp_privkey || !ret->comp_pubkey, err);
         ret->oqsx_provider_ctx.oqsx_evp_ctx = NULL;
         ret->oqsx_provider_ctx.oqsx_qs_ctx.kem = OQS_KEM_new(oqs_name);
@@ -1370,8 +1546,8 @@ OQSX_KEY *oqsx_key_new(OSSL_LIB_CTX *libctx, char *oqs_name, char *tls_name,
         ON_ERR_GOTO(ret2 <= 0 || !evp_ctx->keyParam || !evp_ctx->ctx, err);
 
         ret->numkeys = 2;
-        ret->comp_privkey = OPENSSL_malloc(ret->numkeys * sizeof(void *));
-        ret->comp_pubkey = OPENSSL_malloc(ret->numkeys * sizeof(void *));
+        ret->comp_privkey = OPENSSL_zalloc(ret->numkeys * sizeof(void *));
+        ret->comp_pubkey = OPENSSL_zalloc(ret->numkeys * sizeof(void *));
         ON_ERR_GOTO(!ret->comp_privkey || !ret->comp_pubkey, err);
         ret->privkeylen =
             (ret->numkeys - 1) * SIZE_OF_UINT32 +
@@ -1402,8 +1578,8 @@ OQSX_KEY *oqsx_key_new(OSSL_LIB_CTX *libctx, char *oqs_name, char *tls_name,
         ON_ERR_GOTO(ret2 <= 0 || !evp_ctx->ctx, err);
 
         ret->numkeys = 2;
-        ret->comp_privkey = OPENSSL_malloc(ret->numkeys * sizeof(void *));
-        ret->comp_pubkey = OPENSSL_malloc(ret->numkeys * sizeof(void *));
+        ret->comp_privkey = OPENSSL_zalloc(ret->numkeys * sizeof(void *));
+        ret->comp_pubkey = OPENSSL_zalloc(ret->numkeys * sizeof(void *));
         ON_ERR_GOTO(!ret->comp_privkey || !ret->comp_pubkey, err);
         ret->privkeylen =
             (ret->numkeys - 1) * SIZE_OF_UINT32 +
@@ -1423,12 +1599,12 @@ OQSX_KEY *oqsx_key_new(OSSL_LIB_CTX *libctx, char *oqs_name, char *tls_name,
         ret->pubkeylen = 0;
         ret->privkeylen_cmp = OPENSSL_malloc(ret->numkeys * sizeof(size_t));
         ret->pubkeylen_cmp = OPENSSL_malloc(ret->numkeys * sizeof(size_t));
-        ret->comp_privkey = OPENSSL_malloc(ret->numkeys * sizeof(void *));
-        ret->comp_pubkey = OPENSSL_malloc(ret->numkeys * sizeof(void *));
+        ret->comp_privkey = OPENSSL_zalloc(ret->numkeys * sizeof(void *));
+        ret->comp_pubkey = OPENSSL_zalloc(ret->numkeys * sizeof(void *));
 
         for (i = 0; i < ret->numkeys; i++) {
             char *name;
-            if ((name = get_cmpname(OBJ_sn2nid(tls_name), i)) == NULL) {
+            if ((name = oqsx_key_cmpname(ret, i)) == NULL) {
                 ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_ENCODING);
                 goto err;
             }
@@ -1475,8 +1651,6 @@ OQSX_KEY *oqsx_key_new(OSSL_LIB_CTX *libctx, char *oqs_name, char *tls_name,
 
     ret->libctx = libctx;
     ret->references = 1;
-    ret->tls_name = OPENSSL_strdup(tls_name);
-    ON_ERR_GOTO(!ret->tls_name, err);
     ret->bit_security = bit_security;
 
     if (propq != NULL) {
@@ -1590,6 +1764,25 @@ err_alloc:
     return ret;
 }
 
+/* Public keys are not secret, so they go to the normal heap; keeps the
+ * secure heap out of TLS server key share processing. The classic part of
+ * hybrid KEM public keys has a fixed length, which is prefixed here.
+ */
+int oqsx_key_allocate_pubkey(OQSX_KEY *key) {
+    if (key->pubkey != NULL)
+        return 1;
+    if ((key->pubkey = OPENSSL_zalloc(key->pubkeylen)) == NULL) {
+        ERR_raise(ERR_LIB_USER, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    if (key->keytype == KEY_TYPE_ECP_HYB_KEM ||
+        key->keytype == KEY_TYPE_ECX_HYB_KEM) {
+        ENCODE_UINT32((unsigned char *)key->pubkey,
+                      key->evp_info->length_public_key);
+    }
+    return oqsx_key_set_composites(key);
+}
+
 int oqsx_key_fromdata(OQSX_KEY *key, const OSSL_PARAM params[],
                       int include_private) {
     const OSSL_PARAM *pp1, *pp2;
@@ -1636,6 +1829,7 @@ int oqsx_key_fromdata(OQSX_KEY *key, const OSSL_PARAM params[],
         }
         memcpy(key->pubkey, pp2->data, pp2->data_size);
     }
+    key->validated = 0;
     if (!oqsx_key_set_composites(key) ||
         !oqsx_key_recreate_classickey(
             key, key->privkey != NULL ? KEY_OP_PRIVATE : KEY_OP_PUBLIC))
@@ -1757,22 +1951,27 @@ errhyb:
 int oqsx_key_gen(OQSX_KEY *key) {
     int ret = 0;
     EVP_PKEY *pkey = NULL;
+    OQSX_OP_TIMER timer;
 
+    oqsx_op_timer_start(&timer);
     if (key->privkey == NULL || key->pubkey == NULL) {
         ret = oqsx_key_allocate_keymaterial(key, 0) ||
               oqsx_key_allocate_keymaterial(key, 1);
         ON_ERR_GOTO(ret, err_gen);
     }
+    oqsx_op_timer_lap(&timer, OQSX_LAP_OTHER);
 
     if (key->keytype == KEY_TYPE_KEM) {
         ret = !oqsx_key_set_composites(key);
         ON_ERR_GOTO(ret, err_gen);
         ret = oqsx_key_gen_oqs(key, 1);
+        oqsx_op_timer_lap(&timer, OQSX_LAP_PQ);
     } else if (key->keytype == KEY_TYPE_ECP_HYB_KEM ||
                key->keytype == KEY_TYPE_ECX_HYB_KEM ||
                key->keytype == KEY_TYPE_HYB_SIG) {
         pkey = oqsx_key_gen_evp_key(key->oqsx_provider_ctx.oqsx_evp_ctx,
                                     key->pubkey, key->privkey, 1);
+        oqsx_op_timer_lap(&timer, OQSX_LAP_CLASSIC);
         ON_ERR_GOTO(pkey == NULL, err_gen);
         ret = !oqsx_key_set_composites(key);
         ON_ERR_GOTO(ret, err_gen);
@@ -1781,18 +1980,20 @@ int oqsx_key_gen(OQSX_KEY *key) {
 
         key->classical_pkey = pkey;
         ret = oqsx_key_gen_oqs(key, key->keytype != KEY_TYPE_HYB_SIG);
+        oqsx_op_timer_lap(&timer, OQSX_LAP_PQ);
     } else if (key->keytype == KEY_TYPE_CMP_SIG) {
         int i;
         ret = oqsx_key_set_composites(key);
         for (i = 0; i < key->numkeys; i++) {
             char *name;
-            if ((name = get_cmpname(OBJ_sn2nid(key->tls_name), i)) == NULL) {
+            if ((name = oqsx_key_cmpname(key, i)) == NULL) {
                 ON_ERR_GOTO(ret, err_gen);
             }
             if (get_oqsname_fromtls(name) == 0) {
                 pkey = oqsx_key_gen_evp_key(key->oqsx_provider_ctx.oqsx_evp_ctx,
                                             key->comp_pubkey[i],
                                             key->comp_privkey[i], 0);
+                oqsx_op_timer_lap(&timer, OQSX_LAP_CLASSIC);
                 OPENSSL_free(name);
                 ON_ERR_GOTO(pkey == NULL, err_gen);
                 key->classical_pkey = pkey;
@@ -1800,6 +2001,7 @@ int oqsx_key_gen(OQSX_KEY *key) {
                 ret =
                     OQS_SIG_keypair(key->oqsx_provider_ctx.oqsx_qs_ctx.sig,
                                     key->comp_pubkey[i], key->comp_privkey[i]);
+                oqsx_op_timer_lap(&timer, OQSX_LAP_PQ);
                 OPENSSL_free(name);
                 ON_ERR_GOTO(ret, err_gen);
             }
@@ -1808,6 +2010,7 @@ int oqsx_key_gen(OQSX_KEY *key) {
         ret = !oqsx_key_set_composites(key);
         ON_ERR_GOTO(ret, err_gen);
         ret = oqsx_key_gen_oqs(key, 0);
+        oqsx_op_timer_lap(&timer, OQSX_LAP_PQ);
     } else {
         ret = 1;
     }
@@ -1816,6 +2019,8 @@ err_gen:
         EVP_PKEY_free(pkey);
         key->classical_pkey = NULL;
     }
+    oqsx_op_timer_end(&timer, "keygen", key->tls_name, key->keytype, 0,
+                      ret ? 0 : key->pubkeylen);
     return ret;
 }
 
@@ -1863,3 +2068,371 @@ int oqsx_key_get_oqs_public_key_len(OQSX_KEY *k) {
         return -1;
     }
 }
+
+/// Key validation
+
+static unsigned int oqsx_key_get_validated(OQSX_KEY *key) {
+#ifndef OQS_PROVIDER_NOATOMIC
+    return atomic_load_explicit(&key->validated, memory_order_acquire);
+#else
+    uint64_t validated = 0;
+
+    CRYPTO_atomic_load(&key->validated, &validated, key->lock);
+    return (unsigned int)validated;
+#endif
+}
+
+static void oqsx_key_add_validated(OQSX_KEY *key, unsigned int validated) {
+#ifndef OQS_PROVIDER_NOATOMIC
+    atomic_fetch_or_explicit(&key->validated, validated, memory_order_release);
+#else
+    uint64_t ret;
+
+    CRYPTO_atomic_or(&key->validated, validated, &ret, key->lock);
+#endif
+}
+
+/* Locates component |idx| of the key material. Lengths are checked against
+ * the buffers they point into. RetVal 0 is error.
+ */
+static int oqsx_key_get_component(OQSX_KEY *key, int idx, int *is_oqs,
+                                  const unsigned char **pub, size_t *publen,
+                                  const unsigned char **priv,
+                                  size_t *privlen) {
+    int is_kem = key->keytype != KEY_TYPE_SIG &&
+                 key->keytype != KEY_TYPE_HYB_SIG &&
+                 key->keytype != KEY_TYPE_CMP_SIG;
+    size_t oqs_publen = is_kem ? key->oqsx_provider_ctx.oqsx_qs_ctx.kem
+                                     ->length_public_key
+                               : key->oqsx_provider_ctx.oqsx_qs_ctx.sig
+                                     ->length_public_key;
+    size_t oqs_privlen = is_kem ? key->oqsx_provider_ctx.oqsx_qs_ctx.kem
+                                      ->length_secret_key
+                                : key->oqsx_provider_ctx.oqsx_qs_ctx.sig
+                                      ->length_secret_key;
+    uint32_t classic_len;
+
+    *pub = key->pubkey ? key->comp_pubkey[idx] : NULL;
+    *priv = key->privkey ? key->comp_privkey[idx] : NULL;
+    if (key->keytype == KEY_TYPE_CMP_SIG) {
+        char *name;
+
+        if ((name = oqsx_key_cmpname(key, idx)) == NULL)
+            return 0;
+        *is_oqs = get_oqsname_fromtls(name) != 0;
+        OPENSSL_free(name);
+        *publen = key->pubkeylen_cmp[idx];
+        *privlen = key->privkeylen_cmp[idx];
+    } else if (key->numkeys == 1) {
+        *is_oqs = 1;
+        *publen = oqs_publen;
+        *privlen = oqs_privlen;
+    } else {
+        *is_oqs = idx == key->numkeys - 1;
+        if (*pub != NULL) {
+            DECODE_UINT32(classic_len, key->pubkey);
+            if (classic_len > key->evp_info->length_public_key ||
+                SIZE_OF_UINT32 + classic_len + oqs_publen > key->pubkeylen)
+                return 0;
+            *publen = *is_oqs ? oqs_publen : classic_len;
+        }
+        if (*priv != NULL) {
+            DECODE_UINT32(classic_len, key->privkey);
+            if (classic_len > key->evp_info->length_private_key ||
+                SIZE_OF_UINT32 + classic_len + oqs_privlen > key->privkeylen)
+                return 0;
+            *privlen = *is_oqs ? oqs_privlen : classic_len;
+        }
+    }
+    return 1;
+}
+
+static int oqsx_key_digest(OQSX_KEY *key, const char *mdname,
+                           const unsigned char *in, size_t inlen,
+                           unsigned char *out, size_t outlen) {
+    EVP_MD *md = EVP_MD_fetch(key->libctx, mdname, key->propq);
+    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+    int ret = 0;
+
+    if (md == NULL || mdctx == NULL ||
+        !EVP_DigestInit_ex2(mdctx, md, NULL) ||
+        !EVP_DigestUpdate(mdctx, in, inlen))
+        goto err;
+    if (EVP_MD_get_flags(md) & EVP_MD_FLAG_XOF)
+        ret = EVP_DigestFinalXOF(mdctx, out, outlen);
+    else
+        ret = (size_t)EVP_MD_get_size(md) == outlen &&
+              EVP_DigestFinal_ex(mdctx, out, NULL);
+err:
+    EVP_MD_CTX_free(mdctx);
+    EVP_MD_free(md);
+    return ret;
+}
+
+/* FIPS 203, 7.2 and 7.3: the encapsulation key must hold coefficients
+ * reduced mod q, the decapsulation key must carry H(ek) of the ek embedded
+ * in it, and for a key pair that embedded ek must be the public key.
+ */
+static int oqsx_mlkem_check(OQSX_KEY *key, const unsigned char *pub,
+                            const unsigned char *priv, unsigned int checks) {
+    const OQS_KEM *kem = key->oqsx_provider_ctx.oqsx_qs_ctx.kem;
+    size_t k = (kem->length_public_key - 32) / 384, i;
+    unsigned char hash[32];
+
+    if (kem->length_public_key != 384 * k + 32 ||
+        kem->length_secret_key != 768 * k + 96)
+        return 1; // not a layout we know how to check
+    if (checks & OQSX_VALIDATED_PUBLIC) {
+        for (i = 0; i < 384 * k; i += 3) {
+            if ((pub[i] | (pub[i + 1] & 0x0f) << 8) >= 3329 ||
+                (pub[i + 1] >> 4 | pub[i + 2] << 4) >= 3329)
+                return 0;
+        }
+    }
+    if (checks & OQSX_VALIDATED_PRIVATE) {
+        if (!oqsx_key_digest(key, "SHA3-256", priv + 384 * k, 384 * k + 32,
+                             hash, sizeof(hash)) ||
+            CRYPTO_memcmp(hash, priv + 768 * k + 32, sizeof(hash)))
+            return 0;
+    }
+    if (checks & OQSX_VALIDATED_PAIRWISE) {
+        if (CRYPTO_memcmp(priv + 384 * k, pub, 384 * k + 32))
+            return 0;
+    }
+    return 1;
+}
+
+/* FIPS 204, 6.1: the private key starts with rho of the public key, K and
+ * tr = H(pk, 64).
+ */
+static int oqsx_mldsa_check(OQSX_KEY *key, const unsigned char *pub,
+                            const unsigned char *priv) {
+    const OQS_SIG *sig = key->oqsx_provider_ctx.oqsx_qs_ctx.sig;
+    unsigned char tr[64];
+
+    return CRYPTO_memcmp(priv, pub, 32) == 0 &&
+           oqsx_key_digest(key, "SHAKE-256", pub, sig->length_public_key, tr,
+                           sizeof(tr)) &&
+           CRYPTO_memcmp(tr, priv + 64, sizeof(tr)) == 0;
+}
+
+/* Runs a sign/verify resp. encaps/decaps round trip over the component. */
+static int oqsx_oqs_pairwise_check(OQSX_KEY *key, const unsigned char *pub,
+                                   const unsigned char *priv) {
+    unsigned char msg[32];
+    unsigned char *buf = NULL, *ss = NULL;
+    size_t siglen;
+    int ret = 0;
+
+    if (key->keytype == KEY_TYPE_SIG || key->keytype == KEY_TYPE_HYB_SIG ||
+        key->keytype == KEY_TYPE_CMP_SIG) {
+        const OQS_SIG *sig = key->oqsx_provider_ctx.oqsx_qs_ctx.sig;
+
+        siglen = sig->length_signature;
+        buf = OPENSSL_malloc(siglen);
+        ret = buf != NULL && RAND_bytes_ex(key->libctx, msg, sizeof(msg), 0) &&
+              OQS_SIG_sign(sig, buf, &siglen, msg, sizeof(msg), priv) ==
+                  OQS_SUCCESS &&
+              OQS_SIG_verify(sig, msg, sizeof(msg), buf, siglen, pub) ==
+                  OQS_SUCCESS;
+        OPENSSL_free(buf);
+    } else {
+        const OQS_KEM *kem = key->oqsx_provider_ctx.oqsx_qs_ctx.kem;
+
+        buf = OPENSSL_malloc(kem->length_ciphertext);
+        ss = OPENSSL_malloc(2 * kem->length_shared_secret);
+        ret = buf != NULL && ss != NULL &&
+              OQS_KEM_encaps(kem, buf, ss, pub) == OQS_SUCCESS &&
+              OQS_KEM_decaps(kem, ss + kem->length_shared_secret, buf, priv) ==
+                  OQS_SUCCESS &&
+              CRYPTO_memcmp(ss, ss + kem->length_shared_secret,
+                            kem->length_shared_secret) == 0;
+        OPENSSL_free(buf);
+        OPENSSL_clear_free(ss, 2 * kem->length_shared_secret);
+    }
+    return ret;
+}
+
+static int oqsx_oqs_check(OQSX_KEY *key, const unsigned char *pub,
+                          const unsigned char *priv, unsigned int checks,
+                          int quick) {
+    int structural = 0;
+
+    if (key->keytype == KEY_TYPE_KEM || key->keytype == KEY_TYPE_ECP_HYB_KEM ||
+        key->keytype == KEY_TYPE_ECX_HYB_KEM) {
+        if (!strncmp(key->oqsx_provider_ctx.oqsx_qs_ctx.kem->method_name,
+                     "ML-KEM", 6)) {
+            if (!oqsx_mlkem_check(key, pub, priv, checks))
+                return 0;
+            structural = 1;
+        }
+    } else if (!strncmp(key->oqsx_provider_ctx.oqsx_qs_ctx.sig->method_name,
+                        "ML-DSA", 6) &&
+               ((checks & OQSX_VALIDATED_PAIRWISE) ||
+                ((checks & OQSX_VALIDATED_PRIVATE) && pub != NULL))) {
+        // tr ties the private key to its public key, if there is one
+        if (!oqsx_mldsa_check(key, pub, priv))
+            return 0;
+        structural = 1;
+    }
+    // a quick check settles for the structural checks where there are any
+    if ((checks & OQSX_VALIDATED_PAIRWISE) && !(quick && structural))
+        return oqsx_oqs_pairwise_check(key, pub, priv);
+    return 1;
+}
+
+/* Checks a classic component by way of the OpenSSL key management of its
+ * key type; for a key pair, the public key derived from the private key must
+ * also be the one stored.
+ */
+static int oqsx_classic_check(const OQSX_EVP_INFO *evp_info,
+                              const unsigned char *pub, size_t publen,
+                              const unsigned char *priv, size_t privlen,
+                              unsigned int checks, int quick) {
+    EVP_PKEY *pkey = NULL, *npk = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    const unsigned char *enc_key;
+    unsigned char *enc = NULL, *encp;
+    size_t enclen = 0;
+    int ret = 0;
+
+    if (checks & OQSX_VALIDATED_PUBLIC) {
+        if (evp_info->raw_key_support) {
+            pkey = EVP_PKEY_new_raw_public_key(evp_info->keytype, NULL, pub,
+                                               publen);
+        } else {
+            npk = EVP_PKEY_new();
+            ON_ERR_GOTO(npk == NULL, err);
+            if (evp_info->keytype != EVP_PKEY_RSA)
+                ON_ERR_GOTO(setECParams(npk, evp_info->nid) == NULL, err);
+            enc_key = pub;
+            pkey = d2i_PublicKey(evp_info->keytype, &npk, &enc_key, publen);
+        }
+        ON_ERR_GOTO(pkey == NULL, err);
+        ctx = EVP_PKEY_CTX_new(pkey, NULL);
+        ON_ERR_GOTO(ctx == NULL, err);
+        ON_ERR_GOTO((quick ? EVP_PKEY_public_check_quick(ctx)
+                           : EVP_PKEY_public_check(ctx)) != 1,
+                    err);
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(pkey);
+        ctx = NULL;
+        pkey = npk = NULL;
+    }
+    if (checks & (OQSX_VALIDATED_PRIVATE | OQSX_VALIDATED_PAIRWISE)) {
+        enc_key = priv;
+        if (evp_info->raw_key_support)
+            pkey = EVP_PKEY_new_raw_private_key(evp_info->keytype, NULL,
+                                                enc_key, privlen);
+        else
+            pkey = d2i_PrivateKey(evp_info->keytype, NULL, &enc_key, privlen);
+        ON_ERR_GOTO(pkey == NULL, err);
+        ctx = EVP_PKEY_CTX_new(pkey, NULL);
+        ON_ERR_GOTO(ctx == NULL || EVP_PKEY_private_check(ctx) != 1, err);
+    }
+    if (checks & OQSX_VALIDATED_PAIRWISE) {
+        ON_ERR_GOTO(EVP_PKEY_pairwise_check(ctx) != 1, err);
+        if (evp_info->raw_key_support) {
+            ON_ERR_GOTO(
+                EVP_PKEY_get_raw_public_key(pkey, NULL, &enclen) != 1 ||
+                    (enc = OPENSSL_malloc(enclen)) == NULL ||
+                    EVP_PKEY_get_raw_public_key(pkey, enc, &enclen) != 1,
+                err);
+        } else {
+            int len = i2d_PublicKey(pkey, NULL);
+
+            ON_ERR_GOTO(len <= 0 || (enc = OPENSSL_malloc(len)) == NULL, err);
+            encp = enc;
+            enclen = i2d_PublicKey(pkey, &encp);
+        }
+        ON_ERR_GOTO(enclen != publen || CRYPTO_memcmp(enc, pub, publen), err);
+    }
+    ret = 1;
+
+err:
+    OPENSSL_free(enc);
+    EVP_PKEY_CTX_free(ctx);
+    if (pkey == NULL)
+        EVP_PKEY_free(npk);
+    EVP_PKEY_free(pkey);
+    return ret;
+}
+
+int oqsx_key_validate(OQSX_KEY *key, int selection, int checktype) {
+    int quick = checktype == OSSL_KEYMGMT_VALIDATE_QUICK_CHECK;
+    unsigned int checks = 0, wanted;
+    const unsigned char *pub, *priv;
+    size_t publen = 0, privlen = 0;
+    int i, is_oqs;
+
+    if (selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY)
+        checks |= OQSX_VALIDATED_PUBLIC;
+    if (selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY)
+        checks |= OQSX_VALIDATED_PRIVATE;
+    if ((selection & OSSL_KEYMGMT_SELECT_KEYPAIR) ==
+        OSSL_KEYMGMT_SELECT_KEYPAIR)
+        checks |= OQSX_VALIDATED_PAIRWISE;
+    if (checks == 0)
+        return 1;
+    if (((checks & OQSX_VALIDATED_PUBLIC) && key->pubkey == NULL) ||
+        ((checks & OQSX_VALIDATED_PRIVATE) && key->privkey == NULL)) {
+        ERR_raise(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS);
+        return 0;
+    }
+
+    // full checks also satisfy the quick ones
+    wanted = quick ? checks << OQSX_VALIDATED_QUICK_SHIFT : checks;
+    if ((oqsx_key_get_validated(key) & wanted) == wanted)
+        return 1;
+
+    OQS_KEY_PRINTF3("OQSX KEY: validating %s, checks %x\n", key->tls_name,
+                    checks);
+    for (i = 0; i < key->numkeys; i++) {
+        if (!oqsx_key_get_component(key, i, &is_oqs, &pub, &publen, &priv,
+                                    &privlen))
+            goto err;
+        if (is_oqs ? !oqsx_oqs_check(key, pub, priv, checks, quick)
+                   : !oqsx_classic_check(
+                         key->oqsx_provider_ctx.oqsx_evp_ctx->evp_info, pub,
+                         publen, priv, privlen, checks, quick))
+            goto err;
+    }
+
+    oqsx_key_add_validated(key, checks << OQSX_VALIDATED_QUICK_SHIFT |
+                                    (quick ? 0 : checks));
+    return 1;
+
+err:
+    ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_KEY);
+    return 0;
+}
+
+/* FIPS 203, 7.2 requires the modulus check of an ML-KEM encapsulation key
+ * before encapsulating to it. TLS key shares are new keys per handshake, so
+ * this cannot rest on earlier validation; it is a single pass over the
+ * coefficients the encapsulation decodes anyway. The classic part of
+ * hybrid keys is left to the key exchange, which decodes and checks the
+ * peer point itself.
+ */
+int oqsx_key_encaps_check(OQSX_KEY *key) {
+    const unsigned char *pub, *priv;
+    size_t publen = 0, privlen = 0;
+    int is_oqs;
+
+    if (key->pubkey == NULL) {
+        ERR_raise(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS);
+        return 0;
+    }
+    if ((oqsx_key_get_validated(key) &
+         OQSX_VALIDATED_PUBLIC << OQSX_VALIDATED_QUICK_SHIFT) ||
+        strncmp(key->oqsx_provider_ctx.oqsx_qs_ctx.kem->method_name, "ML-KEM",
+                6))
+        return 1;
+    if (!oqsx_key_get_component(key, key->numkeys - 1, &is_oqs, &pub, &publen,
+                                &priv, &privlen) ||
+        !oqsx_mlkem_check(key, pub, NULL, OQSX_VALIDATED_PUBLIC)) {
+        ERR_raise(ERR_LIB_USER, OQSPROV_R_INVALID_KEY);
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/*
+ * OQS OpenSSL 3 provider
+ *
+ * Slow operation log: key generations, encapsulations, decapsulations,
+ * signatures, verifications, encodings and decodings taking longer than a
+ * configured threshold are recorded in a fixed-size in-memory ring.
+ *
+ * Operations time themselves with an OQSX_OP_TIMER on the stack; laps split
+ * the total into time spent in liboqs and in classic (OpenSSL) algorithms.
+ * The ring is only touched for operations exceeding the threshold, so
+ * enabling the log costs two clock reads per operation otherwise. The ring
+ * is read via the OQS_PROV_PARAM_SLOW_OPS provider parameter, oldest entry
+ * first; once full, new entries overwrite the oldest ones.
+ *
+ * There is one log per process, set up by the first provider instance
+ * loaded. Later instances share it and fail to load if they configure a
+ * different threshold or size.
+ */
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "oqs_prov.h"
+
+#define OQSX_SLOWLOG_DEFAULT_SIZE 128
+#define OQSX_SLOWLOG_MAX_SIZE 65536
+#define OQSX_SLOWLOG_ALG_LEN 48
+/* upper bound of one formatted entry incl. the separating newline */
+#define OQSX_SLOWLOG_LINE_LEN 320
+
+typedef struct {
+    uint64_t seq;
+    time_t when;
+    const char *op; // static string
+    char alg[OQSX_SLOWLOG_ALG_LEN];
+    int keytype;
+    size_t inlen;
+    size_t outlen;
+    unsigned long thread;
+    double total_us;
+    double pq_us;
+    double classic_us;
+} OQSX_SLOWLOG_ENTRY;
+
+static CRYPTO_ONCE slowlog_once = CRYPTO_ONCE_STATIC_INIT;
+// guards all of the below; operations read the threshold without the lock
+// where atomics are available
+static CRYPTO_RWLOCK *slowlog_lock = NULL;
+static OQSX_SLOWLOG_ENTRY *slowlog = NULL;
+static size_t slowlog_size = 0;
+static uint64_t slowlog_count = 0; // entries ever recorded
+#ifndef OQS_PROVIDER_NOATOMIC
+static _Atomic double slowlog_threshold_us = 0; // 0: log disabled
+#else
+static double slowlog_threshold_us = 0; // 0: log disabled
+#endif
+static int slowlog_users = 0;
+
+static void oqsx_slowlog_init_once(void) {
+    slowlog_lock = CRYPTO_THREAD_lock_new();
+}
+
+static double oqsx_slowlog_threshold(void) {
+#ifndef OQS_PROVIDER_NOATOMIC
+    return atomic_load_explicit(&slowlog_threshold_us, memory_order_acquire);
+#else
+    double threshold = 0;
+
+    if (slowlog_lock != NULL && CRYPTO_THREAD_read_lock(slowlog_lock)) {
+        threshold = slowlog_threshold_us;
+        CRYPTO_THREAD_unlock(slowlog_lock);
+    }
+    return threshold;
+#endif
+}
+
+/* called with slowlog_lock held for writing */
+static void oqsx_slowlog_set_threshold(double threshold) {
+#ifndef OQS_PROVIDER_NOATOMIC
+    atomic_store_explicit(&slowlog_threshold_us, threshold,
+                          memory_order_release);
+#else
+    slowlog_threshold_us = threshold;
+#endif
+}
+
+static double oqsx_slowlog_now_us(void) {
+    struct timespec ts;
+
+#ifdef _WIN32
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+/* accepts NULL (keeping "*val") and positive decimal numbers up to "max" */
+static int oqsx_slowlog_parse(const char *str, double max, double *val) {
+    char *end;
+    double d;
+
+    if (str == NULL || *str == '\0')
+        return 1;
+    d = strtod(str, &end);
+    if (*end != '\0' || !(d >= 0) || d > max)
+        return 0;
+    *val = d;
+    return 1;
+}
+
+int oqsx_slowlog_init(const char *threshold_us, const char *size) {
+    double threshold = 0, entries = OQSX_SLOWLOG_DEFAULT_SIZE;
+    int ret = 0;
+
+    if (threshold_us == NULL)
+        threshold_us = getenv("OQS_SLOW_OP_THRESHOLD_US");
+    if (size == NULL)
+        size = getenv("OQS_SLOW_OP_LOG_SIZE");
+    if (!oqsx_slowlog_parse(threshold_us, 1e12, &threshold) ||
+        !oqsx_slowlog_parse(size, OQSX_SLOWLOG_MAX_SIZE, &entries) ||
+        entries < 1 || !CRYPTO_THREAD_run_once(&slowlog_once,
+                                               oqsx_slowlog_init_once) ||
+        slowlog_lock == NULL || !CRYPTO_THREAD_write_lock(slowlog_lock))
+        return 0;
+    if (slowlog_users > 0) {
+        // one log serves all instances; settings given must match it
+        if ((threshold_us != NULL && *threshold_us != '\0' &&
+             threshold != slowlog_threshold_us) ||
+            (size != NULL && *size != '\0' && slowlog_threshold_us > 0 &&
+             (size_t)entries != slowlog_size)) {
+            ERR_raise_data(ERR_LIB_USER, OQSPROV_R_WRONG_PARAMETERS,
+                           "slow operation log already set up with "
+                           "threshold %g us and %zu entries",
+                           slowlog_threshold_us, slowlog_size);
+            goto end;
+        }
+    } else if (threshold > 0) {
+        if ((slowlog = OPENSSL_zalloc((size_t)entries * sizeof(*slowlog))) ==
+            NULL)
+            goto end;
+        slowlog_size = (size_t)entries;
+        slowlog_count = 0;
+        oqsx_slowlog_set_threshold(threshold);
+    }
+    slowlog_users++;
+    ret = 1;
+
+end:
+    CRYPTO_THREAD_unlock(slowlog_lock);
+    return ret;
+}
+
+void oqsx_slowlog_cleanup(void) {
+    if (slowlog_lock == NULL || !CRYPTO_THREAD_write_lock(slowlog_lock))
+        return;
+    if (slowlog_users > 0 && --slowlog_users == 0) {
+        oqsx_slowlog_set_threshold(0);
+        OPENSSL_free(slowlog);
+        slowlog = NULL;
+        slowlog_size = 0;
+        slowlog_count = 0;
+    }
+    CRYPTO_THREAD_unlock(slowlog_lock);
+}
+
+void oqsx_op_timer_start(OQSX_OP_TIMER *t) {
+    t->pq_us = t->classic_us = 0;
+    t->start = t->mark =
+        oqsx_slowlog_threshold() > 0 ? oqsx_slowlog_now_us() : 0;
+}
+
+void oqsx_op_timer_lap(OQSX_OP_TIMER *t, int share) {
+    double now;
+
+    if (t->start == 0)
+        return;
+    now = oqsx_slowlog_now_us();
+    if (share == OQSX_LAP_PQ)
+        t->pq_us += now - t->mark;
+    else if (share == OQSX_LAP_CLASSIC)
+        t->classic_us += now - t->mark;
+    t->mark = now;
+}
+
+void oqsx_op_timer_end(OQSX_OP_TIMER *t, const char *op, const char *alg,
+                       int keytype, size_t inlen, size_t outlen) {
+    OQSX_SLOWLOG_ENTRY *e;
+    double total;
+
+    if (t->start == 0)
+        return;
+    total = oqsx_slowlog_now_us() - t->start;
+    if (total < oqsx_slowlog_threshold() ||
+        !CRYPTO_THREAD_write_lock(slowlog_lock))
+        return;
+    if (slowlog == NULL) {
+        CRYPTO_THREAD_unlock(slowlog_lock);
+        return;
+    }
+    e = &slowlog[slowlog_count % slowlog_size];
+    e->seq = slowlog_count++;
+    e->when = time(NULL);
+    e->op = op;
+    OPENSSL_strlcpy(e->alg, alg != NULL ? alg : "", sizeof(e->alg));
+    e->keytype = keytype;
+    e->inlen = inlen;
+    e->outlen = outlen;
+    e->thread = (unsigned long)CRYPTO_THREAD_get_current_id();
+    e->total_us = total;
+    e->pq_us = t->pq_us;
+    e->classic_us = t->classic_us;
+    CRYPTO_THREAD_unlock(slowlog_lock);
+}
+
+static const char *oqsx_slowlog_keytype(int keytype) {
+    switch (keytype) {
+    case KEY_TYPE_SIG:
+        return "sig";
+    case KEY_TYPE_KEM:
+        return "kem";
+    case KEY_TYPE_ECP_HYB_KEM:
+        return "ecp_hyb_kem";
+    case KEY_TYPE_ECX_HYB_KEM:
+        return "ecx_hyb_kem";
+    case KEY_TYPE_HYB_SIG:
+        return "hyb_sig";
+    case KEY_TYPE_CMP_SIG:
+        return "cmp_sig";
+    default:
+        return "unknown";
+    }
+}
+
+char *oqsx_slowlog_dump(uint64_t *count) {
+    const OQSX_SLOWLOG_ENTRY *e;
+    char *buf;
+    size_t n = 0, pos = 0;
+    uint64_t i;
+    int len;
+
+    *count = 0;
+    if (slowlog_lock == NULL)
+        return OPENSSL_zalloc(1);
+    if (!CRYPTO_THREAD_read_lock(slowlog_lock))
+        return NULL;
+    *count = slowlog_count;
+    if (slowlog != NULL && slowlog_count > 0)
+        n = slowlog_count < slowlog_size ? slowlog_count : slowlog_size;
+    if ((buf = OPENSSL_malloc(n * OQSX_SLOWLOG_LINE_LEN + 1)) != NULL) {
+        buf[0] = '\0';
+        for (i = slowlog_count - n; i < slowlog_count; i++) {
+            e = &slowlog[i % slowlog_size];
+            len = BIO_snprintf(
+                buf + pos, OQSX_SLOWLOG_LINE_LEN + 1,
+                "seq=%llu time=%lld op=%s alg=%s keytype=%s in=%zu out=%zu "
+                "thread=%lx total_us=%.1f liboqs_us=%.1f classic_us=%.1f\n",
+                (unsigned long long)e->seq, (long long)e->when, e->op, e->alg,
+                oqsx_slowlog_keytype(e->keytype), e->inlen, e->outlen,
+                e->thread, e->total_us, e->pq_us, e->classic_us);
+            // a truncated entry fails with the text cut at the buffer end;
+            // keep that as a line of its own rather than dropping it
+            if (len < 0 && (len = (int)strlen(buf + pos)) > 0)
+                buf[pos + len - 1] = '\n';
+            if (len > 0)
+                pos += len;
+        }
+    }
+    CRYPTO_THREAD_unlock(slowlog_lock);
+    return buf;
+}
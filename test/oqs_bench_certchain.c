@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Measures certificate chain validation cost with provider keys: DER
+ * decoding of all certificates incl. their public keys, the signature
+ * checks alone and complete X509_verify_cert() runs, once with a store and
+ * chain decoded afresh for every run ("cold") and once reusing them
+ * ("warm").
+ *
+ * Environment:
+ *   OQS_BENCH_DEPTH  number of certificates per chain incl. root (default 3)
+ *   OQS_BENCH_CHAIN  colon-separated signature algorithms from root to leaf;
+ *                    the list is repeated to fill the chain. If unset, one
+ *                    homogeneous chain per provider signature algorithm is
+ *                    measured.
+ *   OQS_BENCH_MS     minimum measurement time per entry in ms (default 200)
+ */
+
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_common.h"
+
+#define MAX_DEPTH 16
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static double bench_us = 200000;
+static int depth = 3;
+
+typedef struct {
+    int len;                       /* certificates in chain, root first */
+    unsigned char *der[MAX_DEPTH]; /* DER encoding of each certificate */
+    int derlen[MAX_DEPTH];
+    X509 *x509[MAX_DEPTH]; /* decoded certificates for the warm runs */
+    X509_STORE *store;     /* store holding x509[0] for the warm runs */
+    STACK_OF(X509) * untrusted;
+} CHAIN;
+
+static X509 *make_cert(EVP_PKEY *pkey, EVP_PKEY *issuer_key,
+                       X509_NAME *issuer, int level, int is_ca) {
+    X509 *x509 = X509_new_ex(libctx, NULL);
+    X509_NAME *name = NULL;
+    BASIC_CONSTRAINTS *bc = BASIC_CONSTRAINTS_new();
+    char cn[20];
+    int ok;
+
+    snprintf(cn, sizeof(cn), "level %d", level);
+    ok = x509 != NULL && bc != NULL && X509_set_version(x509, 2) &&
+         ASN1_INTEGER_set(X509_get_serialNumber(x509), level + 1) &&
+         X509_gmtime_adj(X509_getm_notBefore(x509), 0) &&
+         X509_gmtime_adj(X509_getm_notAfter(x509), 31536000L) &&
+         X509_set_pubkey(x509, pkey) &&
+         (name = X509_get_subject_name(x509)) != NULL &&
+         X509_NAME_add_entry_by_txt(name, "O", MBSTRING_ASC,
+                                    (unsigned char *)"test.org", -1, -1, 0) &&
+         X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                    (unsigned char *)cn, -1, -1, 0) &&
+         X509_set_issuer_name(x509, issuer ? issuer : name);
+    if (ok && is_ca) {
+        bc->ca = 1;
+        ok = X509_add1_ext_i2d(x509, NID_basic_constraints, bc, 1, 0);
+    }
+    ok = ok && X509_sign(x509, issuer_key ? issuer_key : pkey, NULL) > 0;
+
+    BASIC_CONSTRAINTS_free(bc);
+    if (!ok) {
+        X509_free(x509);
+        return NULL;
+    }
+    return x509;
+}
+
+static void chain_free(CHAIN *chain) {
+    int i;
+
+    for (i = 0; i < chain->len; i++) {
+        OPENSSL_free(chain->der[i]);
+        X509_free(chain->x509[i]);
+    }
+    X509_STORE_free(chain->store);
+    sk_X509_free(chain->untrusted);
+    memset(chain, 0, sizeof(*chain));
+}
+
+/* Creates a chain of |depth| certificates where certificate i has a key of
+ * type algs[i % algcnt].
+ */
+static int chain_new(CHAIN *chain, char **algs, int algcnt) {
+    EVP_PKEY_CTX *genctx = NULL;
+    EVP_PKEY *key = NULL, *issuer_key = NULL;
+    X509 *x509 = NULL, *issuer = NULL;
+    int i, ret = 0;
+
+    memset(chain, 0, sizeof(*chain));
+    for (i = 0; i < depth; i++) {
+        EVP_PKEY_CTX_free(genctx);
+        genctx = EVP_PKEY_CTX_new_from_name(libctx, algs[i % algcnt], NULL);
+        if (genctx == NULL || EVP_PKEY_keygen_init(genctx) <= 0 ||
+            EVP_PKEY_generate(genctx, &key) <= 0 ||
+            (x509 = make_cert(key, issuer_key,
+                              issuer ? X509_get_subject_name(issuer) : NULL,
+                              i, i < depth - 1)) == NULL ||
+            (chain->derlen[i] = i2d_X509(x509, &chain->der[i])) <= 0)
+            goto err;
+        chain->len++;
+        EVP_PKEY_free(issuer_key);
+        X509_free(issuer);
+        issuer_key = key;
+        issuer = x509;
+        key = NULL;
+        x509 = NULL;
+    }
+
+    /* decoded copies for the warm runs */
+    if ((chain->store = X509_STORE_new()) == NULL ||
+        (chain->untrusted = sk_X509_new_null()) == NULL)
+        goto err;
+    for (i = 0; i < chain->len; i++) {
+        const unsigned char *p = chain->der[i];
+
+        if ((chain->x509[i] = d2i_X509(NULL, &p, chain->derlen[i])) == NULL)
+            goto err;
+    }
+    if (!X509_STORE_add_cert(chain->store, chain->x509[0]))
+        goto err;
+    for (i = 1; i < chain->len - 1; i++)
+        if (!sk_X509_push(chain->untrusted, chain->x509[i]))
+            goto err;
+    ret = 1;
+
+err:
+    EVP_PKEY_CTX_free(genctx);
+    EVP_PKEY_free(key);
+    EVP_PKEY_free(issuer_key);
+    X509_free(x509);
+    X509_free(issuer);
+    if (!ret)
+        chain_free(chain);
+    return ret;
+}
+
+/* Decodes all certificates in the chain incl. their public keys */
+static int op_decode(void *arg) {
+    CHAIN *chain = arg;
+    int i, ret = 1;
+
+    for (i = 0; i < chain->len && ret; i++) {
+        const unsigned char *p = chain->der[i];
+        X509 *x509 = d2i_X509(NULL, &p, chain->derlen[i]);
+
+        ret = x509 != NULL && X509_get0_pubkey(x509) != NULL;
+        X509_free(x509);
+    }
+    return ret;
+}
+
+/* Checks all signatures in the already decoded chain */
+static int op_verify(void *arg) {
+    CHAIN *chain = arg;
+    int i;
+
+    for (i = 0; i < chain->len; i++)
+        if (X509_verify(chain->x509[i],
+                        X509_get0_pubkey(chain->x509[i ? i - 1 : 0])) != 1)
+            return 0;
+    return 1;
+}
+
+static int verify_cert(X509_STORE *store, X509 *leaf,
+                       STACK_OF(X509) * untrusted) {
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new_ex(libctx, NULL);
+    int ret = ctx != NULL && X509_STORE_CTX_init(ctx, store, leaf, untrusted) &&
+              X509_verify_cert(ctx) == 1;
+
+    if (!ret && ctx != NULL)
+        fprintf(stderr, "X509_verify_cert: %s\n",
+                X509_verify_cert_error_string(X509_STORE_CTX_get_error(ctx)));
+    X509_STORE_CTX_free(ctx);
+    return ret;
+}
+
+/* Full validation with store and chain decoded from scratch */
+static int op_verify_cert_cold(void *arg) {
+    CHAIN *chain = arg;
+    X509_STORE *store = X509_STORE_new();
+    STACK_OF(X509) *untrusted = sk_X509_new_null();
+    X509 *x509[MAX_DEPTH] = {NULL};
+    int i, ret = store != NULL && untrusted != NULL;
+
+    for (i = 0; i < chain->len && ret; i++) {
+        const unsigned char *p = chain->der[i];
+
+        ret = (x509[i] = d2i_X509(NULL, &p, chain->derlen[i])) != NULL;
+    }
+    ret = ret && X509_STORE_add_cert(store, x509[0]);
+    for (i = 1; i < chain->len - 1 && ret; i++)
+        ret = sk_X509_push(untrusted, x509[i]) > 0;
+    ret = ret && verify_cert(store, x509[chain->len - 1], untrusted);
+
+    for (i = 0; i < chain->len; i++)
+        X509_free(x509[i]);
+    sk_X509_free(untrusted);
+    X509_STORE_free(store);
+    return ret;
+}
+
+/* Full validation reusing store and decoded chain */
+static int op_verify_cert_warm(void *arg) {
+    CHAIN *chain = arg;
+
+    return verify_cert(chain->store, chain->x509[chain->len - 1],
+                       chain->untrusted);
+}
+
+static int bench_chain(const char *label, char **algs, int algcnt) {
+    CHAIN chain;
+    double decode, verify, cold, warm;
+    int i, size = 0;
+
+    for (i = 0; i < algcnt; i++)
+        if (!alg_is_enabled(algs[i]))
+            return 1;
+    if (!chain_new(&chain, algs, algcnt)) {
+        fprintf(stderr, cRED "  Creating chain failed for %s" cNORM "\n",
+                label);
+        ERR_print_errors_fp(stderr);
+        return 0;
+    }
+    for (i = 0; i < chain.len; i++)
+        size += chain.derlen[i];
+
+    if ((decode = bench_run(op_decode, &chain, bench_us)) < 0 ||
+        (verify = bench_run(op_verify, &chain, bench_us)) < 0 ||
+        (cold = bench_run(op_verify_cert_cold, &chain, bench_us)) < 0 ||
+        (warm = bench_run(op_verify_cert_warm, &chain, bench_us)) < 0) {
+        fprintf(stderr, cRED "  Validating chain failed for %s" cNORM "\n",
+                label);
+        ERR_print_errors_fp(stderr);
+        chain_free(&chain);
+        return 0;
+    }
+    printf("%-40s %7d %10.1f %10.1f %10.1f %10.1f %9.1f %9.1f\n", label, size,
+           decode, verify, cold, warm, 1000000 / cold, 1000000 / warm);
+    chain_free(&chain);
+    return 1;
+}
+
+static int bench_sigalg(const char *alg, void *arg) {
+    char *name = (char *)alg;
+
+    return bench_chain(alg, &name, 1);
+}
+
+int main(int argc, char *argv[]) {
+    char *chainspec, *algs[MAX_DEPTH], *p;
+    const char *env;
+    int algcnt = 0, errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+    bench_us = 1000 * getenv_double("OQS_BENCH_MS", bench_us / 1000);
+    if ((env = getenv("OQS_BENCH_DEPTH")) != NULL)
+        depth = atoi(env);
+    T(depth > 0 && depth <= MAX_DEPTH);
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, "default"));
+
+    printf("chain depth %d; times in us per chain\n", depth);
+    printf("%-40s %7s %10s %10s %10s %10s %9s %9s\n", "algorithms", "bytes",
+           "decode", "sigcheck", "cold", "warm", "cold/s", "warm/s");
+
+    if ((env = getenv("OQS_BENCH_CHAIN")) != NULL) {
+        T((chainspec = OPENSSL_strdup(env)) != NULL);
+        for (p = chainspec; p != NULL && algcnt < MAX_DEPTH;) {
+            algs[algcnt++] = p;
+            if ((p = strchr(p, ':')) != NULL)
+                *p++ = '\0';
+        }
+        if (!bench_chain(env, algs, algcnt))
+            errcnt++;
+        OPENSSL_free(chainspec);
+    } else {
+        errcnt += for_each_oqs_alg(libctx, OSSL_OP_SIGNATURE, bench_sigalg,
+                                   NULL);
+    }
+
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* CMS-signs and verifies payloads streamed from files and reports, per
+ * signature algorithm, payload size and mode:
+ *   MB/s    throughput
+ *   peakRSS growth of the resident set size during the operation (Linux)
+ *   copies  peak OpenSSL heap usage during the operation divided by the
+ *           payload size, i.e. how many copies of the message are held
+ *
+ * Modes:
+ *   detached  signed attributes, content not included (streaming)
+ *   attached  signed attributes, content included
+ *   noattr    no signed attributes, content not included: the signature is
+ *             computed over the content itself
+ *
+ * Environment:
+ *   OQS_BENCH_SIZES  colon-separated payload sizes in bytes
+ *                    (default 1024:1048576:67108864)
+ *   OQS_BENCH_ALGS   colon-separated signature algorithms (default: all)
+ *   OQS_BENCH_MD     digest to use (default SHA512)
+ */
+
+#include <errno.h>
+#include <openssl/cms.h>
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "test_common.h"
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static char *tmpdir = NULL;
+static const char *mdname = "SHA512";
+static unsigned long long sizes[16] = {1024, 1048576, 67108864};
+static int sizecnt = 3;
+
+typedef enum { MODE_DETACHED, MODE_ATTACHED, MODE_NOATTR } CMS_MODE;
+static const char *mode_names[] = {"detached", "attached", "noattr"};
+
+/* Returns the value of field |name| in /proc/self/status in kB, or 0 */
+static long proc_status_kb(const char *name) {
+    FILE *f = fopen("/proc/self/status", "r");
+    char line[128];
+    size_t len = strlen(name);
+    long val = 0;
+
+    if (f == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), f) != NULL)
+        if (!strncmp(line, name, len) && line[len] == ':') {
+            val = atol(line + len + 1);
+            break;
+        }
+    fclose(f);
+    return val;
+}
+
+/* Resets the peak RSS reported as VmHWM (Linux >= 4.0) */
+static void reset_peak_rss(void) {
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+
+    if (f != NULL) {
+        fputs("5", f);
+        fclose(f);
+    }
+}
+
+typedef struct {
+    double us;
+    long rss_kb;
+    size_t heap;
+} OP_STATS;
+
+static void op_start(OP_STATS *st) {
+    MEM_COUNTERS counters;
+
+    reset_peak_rss();
+    mem_counting_reset_peak();
+    mem_counting_get(&counters);
+    st->heap = counters.live;
+    st->rss_kb = proc_status_kb("VmRSS");
+    st->us = get_time_us();
+}
+
+static void op_end(OP_STATS *st) {
+    MEM_COUNTERS counters;
+
+    st->us = get_time_us() - st->us;
+    mem_counting_get(&counters);
+    st->heap = counters.peak - st->heap;
+    st->rss_kb = proc_status_kb("VmHWM") - st->rss_kb;
+}
+
+static int make_payload(const char *path, unsigned long long size) {
+    unsigned char buf[65536];
+    unsigned long long done = 0;
+    size_t chunk, i;
+    FILE *f = fopen(path, "wb");
+
+    if (f == NULL)
+        return 0;
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = (unsigned char)(i * 31 + 7);
+    while (done < size) {
+        chunk = size - done < sizeof(buf) ? (size_t)(size - done)
+                                          : sizeof(buf);
+        if (fwrite(buf, 1, chunk, f) != chunk)
+            break;
+        done += chunk;
+    }
+    return fclose(f) == 0 && done == size;
+}
+
+static int make_signer(const char *alg, EVP_PKEY **pkey, X509 **cert) {
+    EVP_PKEY_CTX *genctx = EVP_PKEY_CTX_new_from_name(libctx, alg, NULL);
+    X509_NAME *name = NULL;
+    int ret;
+
+    *cert = X509_new_ex(libctx, NULL);
+    ret = genctx != NULL && *cert != NULL &&
+          EVP_PKEY_keygen_init(genctx) > 0 &&
+          EVP_PKEY_generate(genctx, pkey) > 0 &&
+          ASN1_INTEGER_set(X509_get_serialNumber(*cert), 1) &&
+          X509_gmtime_adj(X509_getm_notBefore(*cert), 0) &&
+          X509_gmtime_adj(X509_getm_notAfter(*cert), 31536000L) &&
+          X509_set_pubkey(*cert, *pkey) &&
+          (name = X509_get_subject_name(*cert)) != NULL &&
+          X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                     (unsigned char *)"signer", -1, -1, 0) &&
+          X509_set_issuer_name(*cert, name) &&
+          X509_sign(*cert, *pkey, NULL) > 0;
+    EVP_PKEY_CTX_free(genctx);
+    return ret;
+}
+
+static int cms_sign_file(EVP_PKEY *pkey, X509 *cert, CMS_MODE mode,
+                         const char *payload, const char *sigfile) {
+    int flags = CMS_BINARY | CMS_PARTIAL | CMS_STREAM;
+    BIO *in = BIO_new_file(payload, "rb");
+    BIO *out = BIO_new_file(sigfile, "wb");
+    CMS_ContentInfo *cms = NULL;
+    EVP_MD *md = EVP_MD_fetch(libctx, mdname, NULL);
+    int ret;
+
+    if (mode != MODE_ATTACHED)
+        flags |= CMS_DETACHED;
+    if (mode == MODE_NOATTR)
+        flags |= CMS_NOATTR;
+    ret = in != NULL && out != NULL && md != NULL &&
+          (cms = CMS_sign_ex(NULL, NULL, NULL, NULL, flags, libctx, NULL)) !=
+              NULL &&
+          CMS_add1_signer(cms, cert, pkey, md, flags) != NULL;
+    if (ret && mode == MODE_NOATTR)
+        // signature must be computed over the content, so stream it now
+        ret = CMS_final(cms, in, NULL, flags & ~CMS_STREAM) &&
+              i2d_CMS_bio(out, cms);
+    else if (ret)
+        ret = i2d_CMS_bio_stream(out, cms, in, flags);
+
+    CMS_ContentInfo_free(cms);
+    EVP_MD_free(md);
+    BIO_free(in);
+    BIO_free(out);
+    return ret;
+}
+
+static int cms_verify_file(X509 *cert, CMS_MODE mode, const char *payload,
+                           const char *sigfile) {
+    int flags = CMS_BINARY | CMS_NO_SIGNER_CERT_VERIFY;
+    BIO *sig = BIO_new_file(sigfile, "rb");
+    BIO *dcont = mode != MODE_ATTACHED ? BIO_new_file(payload, "rb") : NULL;
+    BIO *out = BIO_new(BIO_s_null());
+    CMS_ContentInfo *cms = NULL;
+    STACK_OF(X509) *certs = sk_X509_new_null();
+    int ret;
+
+    ret = sig != NULL && out != NULL && certs != NULL &&
+          (mode == MODE_ATTACHED || dcont != NULL) &&
+          sk_X509_push(certs, cert) &&
+          (cms = d2i_CMS_bio(sig, NULL)) != NULL &&
+          CMS_verify(cms, certs, NULL, dcont, out, flags) == 1;
+
+    CMS_ContentInfo_free(cms);
+    sk_X509_free(certs);
+    BIO_free(sig);
+    BIO_free(dcont);
+    BIO_free(out);
+    return ret;
+}
+
+static void print_stats(const OP_STATS *st, unsigned long long size) {
+    printf(" %9.1f %8ld %6.2f", size / st->us, st->rss_kb / 1024,
+           (double)st->heap / size);
+}
+
+static int bench_one(const char *alg, EVP_PKEY *pkey, X509 *cert,
+                     CMS_MODE mode, unsigned long long size) {
+    OP_STATS sign, verify;
+    char payload[300], sigfile[300];
+    int ret = 0;
+
+    snprintf(payload, sizeof(payload), "%s/payload_%llu", tmpdir, size);
+    snprintf(sigfile, sizeof(sigfile), "%s/%s.p7s", tmpdir, alg);
+
+    op_start(&sign);
+    if (!cms_sign_file(pkey, cert, mode, payload, sigfile))
+        goto end;
+    op_end(&sign);
+    op_start(&verify);
+    if (!cms_verify_file(cert, mode, payload, sigfile))
+        goto end;
+    op_end(&verify);
+
+    printf("%-28s %-8s %12llu", alg, mode_names[mode], size);
+    print_stats(&sign, size);
+    print_stats(&verify, size);
+    printf("\n");
+    ret = 1;
+
+end:
+    if (!ret) {
+        fprintf(stderr, cRED "  CMS %s of %llu bytes failed for %s" cNORM "\n",
+                mode_names[mode], size, alg);
+        ERR_print_errors_fp(stderr);
+    }
+    remove(sigfile);
+    return ret;
+}
+
+static int bench_alg(const char *alg, void *arg) {
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    int i, mode, errcnt = 0;
+
+    if (!alg_is_enabled(alg))
+        return 1;
+    if (!make_signer(alg, &pkey, &cert)) {
+        fprintf(stderr, cRED "  Creating signer failed for %s" cNORM "\n",
+                alg);
+        ERR_print_errors_fp(stderr);
+        errcnt++;
+    } else {
+        for (i = 0; i < sizecnt; i++)
+            for (mode = MODE_DETACHED; mode <= MODE_NOATTR; mode++)
+                if (!bench_one(alg, pkey, cert, (CMS_MODE)mode, sizes[i]))
+                    errcnt++;
+    }
+
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+    return errcnt == 0;
+}
+
+int main(int argc, char *argv[]) {
+    char payload[300];
+    const char *env;
+    int i, errcnt = 0, test = 0;
+
+    T(mem_counting_init());
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 4);
+    modulename = argv[1];
+    configfile = argv[2];
+    tmpdir = argv[3];
+    if ((env = getenv("OQS_BENCH_MD")) != NULL)
+        mdname = env;
+    if ((env = getenv("OQS_BENCH_SIZES")) != NULL) {
+        for (sizecnt = 0;
+             env != NULL && sizecnt < (int)(sizeof(sizes) / sizeof(sizes[0]));
+             env = strchr(env, ':') ? strchr(env, ':') + 1 : NULL)
+            T((sizes[sizecnt++] = strtoull(env, NULL, 10)) > 0);
+    }
+    if (mkdir(tmpdir, 0700) && errno != EEXIST) {
+        fprintf(stderr, "Couldn't create %s: Err = %d\n", tmpdir, errno);
+        return 1;
+    }
+    for (i = 0; i < sizecnt; i++) {
+        snprintf(payload, sizeof(payload), "%s/payload_%llu", tmpdir,
+                 sizes[i]);
+        T(make_payload(payload, sizes[i]));
+    }
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, "default"));
+
+    printf("%-28s %-8s %12s %9s %8s %6s %9s %8s %6s\n", "", "", "",
+           "sign", "", "", "verify", "", "");
+    printf("%-28s %-8s %12s %9s %8s %6s %9s %8s %6s\n", "algorithm", "mode",
+           "bytes", "MB/s", "peakRSS", "copies", "MB/s", "peakRSS",
+           "copies");
+    if ((env = getenv("OQS_BENCH_ALGS")) != NULL)
+        errcnt += for_each_in_list(env, bench_alg, NULL);
+    else
+        errcnt += for_each_oqs_alg(libctx, OSSL_OP_SIGNATURE, bench_alg, NULL);
+
+    for (i = 0; i < sizecnt; i++) {
+        snprintf(payload, sizeof(payload), "%s/payload_%llu", tmpdir,
+                 sizes[i]);
+        remove(payload);
+    }
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Reports modeled TLS 1.3 handshake completion time per group and sigalg
+ * over the emulated link implemented in tlstest_helpers.c.
+ *
+ * Link parameters are taken from the environment:
+ *   OQS_NETEM_LATENCY_MS     one-way delay (default 50)
+ *   OQS_NETEM_BANDWIDTH_KBPS link rate (default 10000, 0 = unlimited)
+ *   OQS_NETEM_MTU            packet size incl. headers (default 1500)
+ *   OQS_NETEM_INITCWND       initial congestion window (default 10)
+ *   OQS_BENCH_ITERATIONS     handshakes averaged per entry (default 10)
+ *
+ * By default every group is measured with an RSA server certificate
+ * and every sigalg with the first group offered by the client. Setting
+ * OQS_BENCH_GROUPS and/or OQS_BENCH_SIGALGS to colon-separated lists instead
+ * measures exactly the cross product of the given groups and sigalgs.
+ */
+
+#include <errno.h>
+#include <openssl/core_names.h>
+#include <openssl/provider.h>
+#include <openssl/ssl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "test_common.h"
+#include "tlstest_helpers.h"
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static char *certsdir = NULL;
+static OQS_NETEM_PARAMS netem = {50, 10000, 1500, 10};
+static int iterations = 10;
+
+static int make_cert_key(const char *sig_name, char *certpath,
+                         char *privkeypath, size_t len) {
+#ifndef OPENSSL_SYS_VMS
+    const char *sep = "/";
+#else
+    const char *sep = "";
+#endif
+
+    snprintf(certpath, len, "%s%s%s%s", certsdir, sep, sig_name, "_srv.crt");
+    snprintf(privkeypath, len, "%s%s%s%s", certsdir, sep, sig_name,
+             "_srv.key");
+    if (mkdir(certsdir, 0700) && errno != EEXIST) {
+        fprintf(stderr, "Couldn't create certsdir %s: Err = %d\n", certsdir,
+                errno);
+        return 0;
+    }
+    return create_cert_key(libctx, (char *)sig_name, certpath, privkeypath);
+}
+
+/* Measures |iterations| handshakes with the given group (NULL: library
+ * default) and a server certificate of type sig_name (NULL: RSA).
+ */
+static int bench_handshake(const char *group_name, const char *sig_name) {
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    OQS_NETEM_STATS stats, total;
+    char certpath[300];
+    char privkeypath[300];
+    int i, ret = 0;
+
+    if ((group_name != NULL && !alg_is_enabled(group_name)) ||
+        (sig_name != NULL && !alg_is_enabled(sig_name)))
+        return 1;
+
+    memset(&total, 0, sizeof(total));
+    if (!make_cert_key(sig_name ? sig_name : "RSA", certpath, privkeypath,
+                       sizeof(certpath)) ||
+        !create_tls1_3_ctx_pair(libctx, &sctx, &cctx, certpath, privkeypath))
+        goto err;
+    if (group_name != NULL && (!SSL_CTX_set1_groups_list(sctx, group_name) ||
+                               !SSL_CTX_set1_groups_list(cctx, group_name)))
+        goto err;
+
+    for (i = 0; i < iterations; i++) {
+        if (!create_tls_objects(sctx, cctx, &serverssl, &clientssl) ||
+            !create_netem_tls_connection(serverssl, clientssl, &netem,
+                                         &stats))
+            goto err;
+        total.cpu_ms += stats.cpu_ms;
+        total.network_ms += stats.network_ms;
+        total.flights = stats.flights;
+        total.segments = stats.segments;
+        total.bytes = stats.bytes;
+        total.extra_rtts = stats.extra_rtts;
+        SSL_free(serverssl);
+        SSL_free(clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    printf("%-28s %-28s %7zu %7zu %8zu %5zu %9.2f %9.2f %9.2f\n",
+           group_name ? group_name : "(default)",
+           sig_name ? sig_name : "RSA", total.flights, total.bytes,
+           total.segments, total.extra_rtts, total.cpu_ms / iterations,
+           total.network_ms / iterations,
+           (total.cpu_ms + total.network_ms) / iterations);
+    ret = 1;
+
+err:
+    if (!ret) {
+        fprintf(stderr, cRED "  Handshake failed: %s / %s" cNORM "\n",
+                group_name ? group_name : "(default)",
+                sig_name ? sig_name : "RSA");
+        ERR_print_errors_fp(stderr);
+    }
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+static int bench_group(const char *name, void *arg) {
+    return bench_handshake(name, NULL);
+}
+
+static int bench_sigalg(const char *name, void *arg) {
+    return bench_handshake(NULL, name);
+}
+
+/* Measures all combinations of the colon-separated lists; a NULL list
+ * stands for the default group resp. an RSA certificate.
+ */
+static void bench_cross_product(const char *groups, const char *sigalgs,
+                                int *errcnt) {
+    char *glist = groups ? OPENSSL_strdup(groups) : NULL;
+    char *slist = sigalgs ? OPENSSL_strdup(sigalgs) : NULL;
+    char *g = glist, *gend, *s, *send;
+
+    do {
+        if (g != NULL && (gend = strchr(g, ':')) != NULL)
+            *gend = '\0';
+        else
+            gend = NULL;
+        s = slist;
+        do {
+            if (s != NULL && (send = strchr(s, ':')) != NULL)
+                *send = '\0';
+            else
+                send = NULL;
+            if (!bench_handshake(g, s))
+                (*errcnt)++;
+            if (send != NULL)
+                *send = ':';
+            s = send ? send + 1 : NULL;
+        } while (s != NULL);
+        g = gend ? gend + 1 : NULL;
+    } while (g != NULL);
+    OPENSSL_free(glist);
+    OPENSSL_free(slist);
+}
+
+int main(int argc, char *argv[]) {
+    const char *groups, *sigalgs;
+    int errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 4);
+    modulename = argv[1];
+    configfile = argv[2];
+    certsdir = argv[3];
+
+    netem.latency_ms = getenv_double("OQS_NETEM_LATENCY_MS", netem.latency_ms);
+    netem.bandwidth_kbps =
+        getenv_double("OQS_NETEM_BANDWIDTH_KBPS", netem.bandwidth_kbps);
+    netem.mtu = (size_t)getenv_double("OQS_NETEM_MTU", (double)netem.mtu);
+    netem.init_cwnd =
+        (size_t)getenv_double("OQS_NETEM_INITCWND", (double)netem.init_cwnd);
+    iterations = (int)getenv_double("OQS_BENCH_ITERATIONS", iterations);
+    T(iterations > 0);
+    groups = getenv("OQS_BENCH_GROUPS");
+    sigalgs = getenv("OQS_BENCH_SIGALGS");
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, "default"));
+
+    printf("Link: latency %.1f ms, bandwidth %.0f kbps, MTU %zu, initcwnd "
+           "%zu; %d iterations\n",
+           netem.latency_ms, netem.bandwidth_kbps, netem.mtu, netem.init_cwnd,
+           iterations);
+    printf("%-28s %-28s %7s %7s %8s %5s %9s %9s %9s\n", "group", "sigalg",
+           "flights", "bytes", "segments", "+RTTs", "cpu ms", "net ms",
+           "total ms");
+
+    if (groups != NULL || sigalgs != NULL)
+        bench_cross_product(groups, sigalgs, &errcnt);
+    else
+        errcnt +=
+            for_each_oqs_tls_alg(libctx, "TLS-GROUP", bench_group, NULL) +
+            for_each_oqs_tls_alg(libctx, "TLS-SIGALG", bench_sigalg, NULL);
+
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
@@ -0,0 +1,419 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Reports the user space instructions retired and cache misses per provider
+ * operation: key generation (oqsx_key_new and friends), signing (oqs_sig_sign),
+ * verification, encapsulation, decapsulation and decoding of
+ * SubjectPublicKeyInfo and PrivateKeyInfo structures.
+ *
+ * Unlike timings, instruction counts are hardly affected by frequency
+ * scaling or other load, so output of different commits can be compared
+ * with diff. To this end, all randomness used by OpenSSL and liboqs is taken
+ * from a seeded generator that is reset before every operation, so every
+ * run of an operation executes the same code path. Per operation, the
+ * minimum over OQS_BENCH_ITERATIONS runs is reported after one warm-up run.
+ *
+ * Counters are read via perf_event_open (Linux; may require lowering
+ * /proc/sys/kernel/perf_event_paranoid). Where this is not available, run
+ * the benchmark under callgrind, which dumps one profile per operation:
+ *
+ *   valgrind --tool=callgrind --collect-atstart=no oqs_bench_icount ...
+ *
+ * Environment:
+ *   OQS_BENCH_ITERATIONS  measured runs per operation (default 5)
+ *   OQS_BENCH_SEED        seed of the random generator (default 1)
+ *   OQS_BENCH_ALGS        colon-separated algorithms (default: all)
+ */
+
+// for RAND_set_rand_method, see rng_install()
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__has_include)
+#if __has_include(<valgrind/callgrind.h>)
+#include <valgrind/callgrind.h>
+#define HAVE_CALLGRIND
+#endif
+#endif
+
+#include "oqs/oqs.h"
+#include "test_common.h"
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static const char *alg_filter = NULL;
+static int iterations = 5;
+
+/// Seeded randomness
+
+static uint64_t rng_seed = 1;
+static uint64_t rng_state = 1;
+
+static void rng_reset(void) { rng_state = rng_seed; }
+
+// splitmix64
+static void rng_fill(unsigned char *buf, size_t len) {
+    uint64_t z = 0;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (i % 8 == 0) {
+            z = (rng_state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+        }
+        buf[i] = (unsigned char)(z >> (8 * (i % 8)));
+    }
+}
+
+static void oqs_seeded_randombytes(uint8_t *buf, size_t len) {
+    rng_fill(buf, len);
+}
+
+#ifndef OPENSSL_NO_DEPRECATED_3_0
+static int seeded_rand_bytes(unsigned char *buf, int num) {
+    rng_fill(buf, (size_t)num);
+    return 1;
+}
+
+static int seeded_rand_status(void) { return 1; }
+
+/* A RAND_METHOD other than the default one is honoured by RAND_bytes_ex and
+ * RAND_priv_bytes_ex in all library contexts, so it also feeds the DRBGs
+ * used by the provider and by the classic parts of hybrid algorithms.
+ */
+static const RAND_METHOD seeded_rand = {
+    NULL, seeded_rand_bytes, NULL, NULL, seeded_rand_bytes, seeded_rand_status};
+#endif
+
+static int rng_install(void) {
+    // effective if the provider shares the liboqs instance of this program
+    OQS_randombytes_custom_algorithm(oqs_seeded_randombytes);
+#ifndef OPENSSL_NO_DEPRECATED_3_0
+    return RAND_set_rand_method(&seeded_rand);
+#else
+    return 1;
+#endif
+}
+
+/// Counters
+
+typedef enum { COUNTER_NONE, COUNTER_PERF, COUNTER_CALLGRIND } COUNTER_MODE;
+
+static COUNTER_MODE counter_mode = COUNTER_NONE;
+static int perf_insns_fd = -1, perf_misses_fd = -1;
+
+typedef struct {
+    uint64_t insns;
+    uint64_t misses;
+} COUNTS;
+
+#ifdef __linux__
+static int perf_open(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = group_fd == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+static int counters_init(void) {
+#ifdef HAVE_CALLGRIND
+    if (RUNNING_ON_VALGRIND) {
+        counter_mode = COUNTER_CALLGRIND;
+        return 1;
+    }
+#endif
+#ifdef __linux__
+    perf_insns_fd = perf_open(PERF_COUNT_HW_INSTRUCTIONS, -1);
+    if (perf_insns_fd >= 0) {
+        // optional: not all (virtual) machines expose cache events
+        perf_misses_fd = perf_open(PERF_COUNT_HW_CACHE_MISSES, perf_insns_fd);
+        counter_mode = COUNTER_PERF;
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+static void counters_free(void) {
+#ifdef __linux__
+    if (perf_misses_fd >= 0)
+        close(perf_misses_fd);
+    if (perf_insns_fd >= 0)
+        close(perf_insns_fd);
+#endif
+}
+
+static void counters_start(void) {
+#ifdef HAVE_CALLGRIND
+    if (counter_mode == COUNTER_CALLGRIND) {
+        CALLGRIND_ZERO_STATS;
+        CALLGRIND_TOGGLE_COLLECT;
+        return;
+    }
+#endif
+#ifdef __linux__
+    ioctl(perf_insns_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(perf_insns_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+static int counters_stop(COUNTS *counts) {
+#ifdef __linux__
+    uint64_t values[3] = {0}; // nr, instructions, cache misses
+#endif
+
+    memset(counts, 0, sizeof(*counts));
+#ifdef HAVE_CALLGRIND
+    if (counter_mode == COUNTER_CALLGRIND) {
+        CALLGRIND_TOGGLE_COLLECT;
+        return 1;
+    }
+#endif
+#ifdef __linux__
+    ioctl(perf_insns_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (read(perf_insns_fd, values, sizeof(values)) < 16)
+        return 0;
+    counts->insns = values[1];
+    counts->misses = values[0] > 1 ? values[2] : 0;
+#endif
+    return 1;
+}
+
+/// Operations
+
+typedef struct {
+    const char *alg;
+    EVP_PKEY *key;
+    EVP_PKEY_CTX *genctx, *ctx;
+    unsigned char *der, *out, *out2;
+    const unsigned char *in;
+    size_t derlen, outlen, out2len, inlen;
+} OP_STATE;
+
+typedef int (*op_fn)(OP_STATE *s);
+
+static int op_keygen(OP_STATE *s) {
+    EVP_PKEY *key = NULL;
+    int ret = EVP_PKEY_generate(s->genctx, &key) > 0;
+
+    EVP_PKEY_free(key);
+    return ret;
+}
+
+static int op_sign(OP_STATE *s) {
+    size_t siglen = s->outlen;
+
+    return EVP_PKEY_sign(s->ctx, s->out, &siglen, s->in, s->inlen) == 1;
+}
+
+static int op_verify(OP_STATE *s) {
+    return EVP_PKEY_verify(s->ctx, s->out, s->outlen, s->in, s->inlen) == 1;
+}
+
+static int op_encaps(OP_STATE *s) {
+    size_t ctlen = s->outlen, sslen = s->out2len;
+
+    return EVP_PKEY_encapsulate(s->ctx, s->out, &ctlen, s->out2, &sslen) ==
+           1;
+}
+
+static int op_decaps(OP_STATE *s) {
+    size_t sslen = s->out2len;
+
+    return EVP_PKEY_decapsulate(s->ctx, s->out2, &sslen, s->out,
+                                s->outlen) == 1;
+}
+
+static int op_decode_spki(OP_STATE *s) {
+    const unsigned char *p = s->der;
+    EVP_PKEY *key = d2i_PUBKEY_ex(NULL, &p, (long)s->derlen, libctx, NULL);
+
+    EVP_PKEY_free(key);
+    return key != NULL;
+}
+
+static int op_decode_pkcs8(OP_STATE *s) {
+    const unsigned char *p = s->der;
+    EVP_PKEY *key =
+        d2i_AutoPrivateKey_ex(NULL, &p, (long)s->derlen, libctx, NULL);
+
+    EVP_PKEY_free(key);
+    return key != NULL;
+}
+
+/* Runs |op| once for warm-up and |iterations| times measured, resetting the
+ * random generator each time, and prints the minimum counts.
+ */
+static int count_op(OP_STATE *s, const char *opname, op_fn op) {
+    COUNTS counts, best = {UINT64_MAX, UINT64_MAX};
+    int i, runs = counter_mode == COUNTER_CALLGRIND ? 1 : iterations;
+
+    rng_reset();
+    if (!op(s))
+        return 0;
+    for (i = 0; i < runs; i++) {
+        rng_reset();
+        counters_start();
+        if (!op(s) || !counters_stop(&counts))
+            return 0;
+        if (counts.insns < best.insns)
+            best.insns = counts.insns;
+        if (counts.misses < best.misses)
+            best.misses = counts.misses;
+    }
+#ifdef HAVE_CALLGRIND
+    if (counter_mode == COUNTER_CALLGRIND) {
+        char dumpname[128];
+
+        snprintf(dumpname, sizeof(dumpname), "%s %s", s->alg, opname);
+        CALLGRIND_DUMP_STATS_AT(dumpname);
+        printf("%-30s %-12s (callgrind)\n", s->alg, opname);
+        return 1;
+    }
+#endif
+    if (perf_misses_fd >= 0)
+        printf("%-30s %-12s %14llu %12llu\n", s->alg, opname,
+               (unsigned long long)best.insns,
+               (unsigned long long)best.misses);
+    else
+        printf("%-30s %-12s %14llu %12s\n", s->alg, opname,
+               (unsigned long long)best.insns, "-");
+    return 1;
+}
+
+static int count_alg(const char *alg, int is_kem) {
+    static const unsigned char msg[32] = {0xa5};
+    OP_STATE s;
+    int derlen, ret = 0;
+
+    memset(&s, 0, sizeof(s));
+    s.alg = alg;
+    rng_reset();
+    if ((s.genctx = EVP_PKEY_CTX_new_from_name(libctx, alg, NULL)) == NULL ||
+        EVP_PKEY_keygen_init(s.genctx) <= 0 ||
+        EVP_PKEY_generate(s.genctx, &s.key) <= 0 ||
+        !count_op(&s, "keygen", op_keygen))
+        goto end;
+
+    if ((s.ctx = EVP_PKEY_CTX_new_from_pkey(libctx, s.key, NULL)) == NULL)
+        goto end;
+    if (!is_kem) {
+        s.in = msg;
+        s.inlen = sizeof(msg);
+        if (EVP_PKEY_sign_init(s.ctx) <= 0 ||
+            EVP_PKEY_sign(s.ctx, NULL, &s.outlen, s.in, s.inlen) <= 0 ||
+            (s.out = OPENSSL_malloc(s.outlen)) == NULL ||
+            EVP_PKEY_sign(s.ctx, s.out, &s.outlen, s.in, s.inlen) <= 0 ||
+            !count_op(&s, "sign", op_sign) ||
+            EVP_PKEY_verify_init(s.ctx) <= 0 ||
+            !count_op(&s, "verify", op_verify))
+            goto end;
+    } else {
+        if (EVP_PKEY_encapsulate_init(s.ctx, NULL) <= 0 ||
+            EVP_PKEY_encapsulate(s.ctx, NULL, &s.outlen, NULL, &s.out2len) <=
+                0 ||
+            (s.out = OPENSSL_malloc(s.outlen)) == NULL ||
+            (s.out2 = OPENSSL_malloc(s.out2len)) == NULL ||
+            !count_op(&s, "encaps", op_encaps) ||
+            EVP_PKEY_decapsulate_init(s.ctx, NULL) <= 0 ||
+            !count_op(&s, "decaps", op_decaps))
+            goto end;
+    }
+
+    // decoders; key types without encoders are skipped
+    if ((derlen = i2d_PUBKEY(s.key, &s.der)) > 0) {
+        s.derlen = (size_t)derlen;
+        if (!count_op(&s, "decode-spki", op_decode_spki))
+            goto end;
+        OPENSSL_free(s.der);
+        s.der = NULL;
+    }
+    if ((derlen = i2d_PrivateKey(s.key, &s.der)) > 0) {
+        s.derlen = (size_t)derlen;
+        if (!count_op(&s, "decode-pkcs8", op_decode_pkcs8))
+            goto end;
+    }
+    ERR_clear_error();
+    ret = 1;
+
+end:
+    if (!ret) {
+        fprintf(stderr, cRED "  Counting failed for %s" cNORM "\n", alg);
+        ERR_print_errors_fp(stderr);
+    }
+    OPENSSL_clear_free(s.der, s.derlen);
+    OPENSSL_free(s.out);
+    OPENSSL_clear_free(s.out2, s.out2len);
+    EVP_PKEY_CTX_free(s.ctx);
+    EVP_PKEY_CTX_free(s.genctx);
+    EVP_PKEY_free(s.key);
+    return ret;
+}
+
+/* "arg" points to 1 for KEMs, 0 for signature algorithms */
+static int count_provider_alg(const char *alg, void *arg) {
+    if (!alg_is_enabled(alg) || !in_list(alg_filter, alg))
+        return 1;
+    return count_alg(alg, *(int *)arg);
+}
+
+int main(int argc, char *argv[]) {
+    static int is_sig_kem[2] = {0, 1};
+    const char *env;
+    int errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+    if ((env = getenv("OQS_BENCH_ITERATIONS")) != NULL)
+        T((iterations = atoi(env)) > 0);
+    if ((env = getenv("OQS_BENCH_SEED")) != NULL)
+        rng_seed = strtoull(env, NULL, 0);
+    alg_filter = getenv("OQS_BENCH_ALGS");
+
+    if (!counters_init()) {
+        fprintf(stderr,
+                cRED "No instruction counter available: perf_event_open "
+                     "failed and not running under callgrind" cNORM "\n");
+        return 1;
+    }
+    T(rng_install());
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, "default"));
+
+    printf("%-30s %-12s %14s %12s\n", "algorithm", "op", "instructions",
+           "cache-misses");
+    errcnt += for_each_oqs_alg(libctx, OSSL_OP_SIGNATURE, count_provider_alg,
+                               &is_sig_kem[0]) +
+              for_each_oqs_alg(libctx, OSSL_OP_KEM, count_provider_alg,
+                               &is_sig_kem[1]);
+
+    counters_free();
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
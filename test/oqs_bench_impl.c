@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Compares the liboqs implementation variants (portable, AVX2, aarch64)
+ * the provider runs. Every configuration file given loads the provider
+ * into a library context of its own, e.g. once as is and once pinned to
+ * the portable variant (option "implementation = portable" in the provider
+ * section) or from a build against a differently configured liboqs (option
+ * "module"). The provider's CPU features, pin and implementation variants
+ * are printed per configuration, then for every algorithm the variant and
+ * time per keygen/sign/verify resp. keygen/encaps/decaps side by side.
+ * Algorithms a pinned provider refuses are shown as "refused".
+ *
+ * Environment:
+ *   OQS_BENCH_CONFIGS colon-separated further configuration files
+ *   OQS_BENCH_ALGS    colon-separated algorithms (default
+ *                     mldsa44:mldsa65:falcon512:mayo1:sphincssha2128fsimple:
+ *                     mlkem768:kyber768:hqc128)
+ *   OQS_BENCH_MS      minimum measurement time per operation in ms
+ *                     (default 200)
+ */
+
+#include <ctype.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/provider.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oqs_prov.h"
+#include "test_common.h"
+
+#define MAX_CONFIGS 8
+#define MSGLEN 32
+
+typedef struct {
+    const char *file;
+    OSSL_LIB_CTX *libctx;
+    char *impls; /* "liboqs name=variant,..." */
+} BENCH_CONFIG;
+
+static BENCH_CONFIG configs[MAX_CONFIGS];
+static int nconfigs = 0;
+static char *modulename = NULL;
+static double bench_us = 200000;
+
+/* Returns whether liboqs name |oqsname| (e.g. "SPHINCS+-SHA2-128f-simple",
+ * terminated by |end|) denotes provider algorithm |provname|. */
+static int oqsname_matches(const char *oqsname, const char *end,
+                           const char *provname) {
+    char norm[100];
+    size_t i = 0;
+
+    for (; oqsname < end && i < sizeof(norm) - 1; oqsname++)
+        if (isalnum((unsigned char)*oqsname))
+            norm[i++] = (char)tolower((unsigned char)*oqsname);
+    norm[i] = '\0';
+    if (!strcmp(norm, provname))
+        return 1;
+    // FrodoKEM is registered without the "kem" infix
+    return !strncmp(norm, "frodokem", 8) && !strncmp(provname, "frodo", 5) &&
+           !strcmp(norm + 8, provname + 5);
+}
+
+/* Writes the variant |c| reports for |alg| to |buf|; hybrids report the
+ * variant of their quantum-safe part. */
+static void impl_of(BENCH_CONFIG *c, const char *alg, char *buf, size_t len) {
+    const char *p = c->impls, *eq, *end, *under = strchr(alg, '_');
+
+    if (under != NULL)
+        alg = under + 1;
+    BIO_snprintf(buf, len, "?");
+    for (; p != NULL && (eq = strchr(p, '=')) != NULL; p = end) {
+        if ((end = strchr(eq, ',')) != NULL)
+            end++;
+        if (oqsname_matches(p, eq, alg)) {
+            BIO_snprintf(buf, len, "%.*s",
+                         (int)(end != NULL ? end - eq - 2 : strlen(eq + 1)),
+                         eq + 1);
+            return;
+        }
+    }
+}
+
+static int load_config(BENCH_CONFIG *c) {
+    OSSL_PROVIDER *prov = NULL;
+    const char *pin = NULL;
+    char features[256];
+    OSSL_PARAM params[4];
+    int ret = 0;
+
+    if ((c->libctx = OSSL_LIB_CTX_new()) == NULL)
+        return 0;
+    load_oqs_provider(c->libctx, modulename, c->file);
+    if ((prov = OSSL_PROVIDER_load(c->libctx, modulename)) == NULL)
+        return 0;
+    params[0] = OSSL_PARAM_construct_utf8_string(OQS_PROV_PARAM_CPU_FEATURES,
+                                                 features, sizeof(features));
+    params[1] = OSSL_PARAM_construct_utf8_ptr(
+        OQS_PROV_PARAM_IMPLEMENTATION_PIN, (char **)&pin, 0);
+    params[2] = OSSL_PARAM_construct_utf8_string(
+        OQS_PROV_PARAM_IMPLEMENTATIONS, NULL, 0);
+    params[3] = OSSL_PARAM_construct_end();
+    // first call returns the size of the implementation list
+    if (!OSSL_PROVIDER_get_params(prov, params) ||
+        (c->impls = OPENSSL_zalloc(params[2].return_size + 1)) == NULL)
+        goto err;
+    params[2].data = c->impls;
+    params[2].data_size = params[2].return_size + 1;
+    if (!OSSL_PROVIDER_get_params(prov, params))
+        goto err;
+    printf("%s:\n  CPU features: %s\n  pin: %s\n  implementations: %s\n",
+           c->file, features, pin, c->impls);
+    ret = 1;
+err:
+    OSSL_PROVIDER_unload(prov);
+    return ret;
+}
+
+typedef struct {
+    OSSL_LIB_CTX *libctx;
+    const char *alg;
+    EVP_PKEY *key;
+    EVP_PKEY_CTX *ctx;
+    unsigned char msg[MSGLEN], *out, *secret;
+    size_t outlen, secretlen, siglen;
+} BENCH_STATE;
+
+static int op_keygen(void *arg) {
+    BENCH_STATE *s = arg;
+    EVP_PKEY *key = EVP_PKEY_Q_keygen(s->libctx, NULL, s->alg);
+
+    EVP_PKEY_free(key);
+    return key != NULL;
+}
+
+static int op_sign(void *arg) {
+    BENCH_STATE *s = arg;
+
+    s->siglen = s->outlen;
+    return EVP_PKEY_sign_init(s->ctx) > 0 &&
+           EVP_PKEY_sign(s->ctx, s->out, &s->siglen, s->msg, MSGLEN) > 0;
+}
+
+static int op_verify(void *arg) {
+    BENCH_STATE *s = arg;
+
+    return EVP_PKEY_verify_init(s->ctx) > 0 &&
+           EVP_PKEY_verify(s->ctx, s->out, s->siglen, s->msg, MSGLEN) == 1;
+}
+
+static int op_encaps(void *arg) {
+    BENCH_STATE *s = arg;
+    size_t outlen = s->outlen, secretlen = s->secretlen;
+
+    return EVP_PKEY_encapsulate_init(s->ctx, NULL) > 0 &&
+           EVP_PKEY_encapsulate(s->ctx, s->out, &outlen, s->secret,
+                                &secretlen) > 0;
+}
+
+static int op_decaps(void *arg) {
+    BENCH_STATE *s = arg;
+    size_t secretlen = s->secretlen;
+
+    return EVP_PKEY_decapsulate_init(s->ctx, NULL) > 0 &&
+           EVP_PKEY_decapsulate(s->ctx, s->secret, &secretlen, s->out,
+                                s->outlen) > 0;
+}
+
+/* Measures keygen and the operations of |alg| in |c|; t[] gets -1 for
+ * failed and -2 for refused measurements. */
+static int bench_config(BENCH_CONFIG *c, const char *alg, double t[3],
+                        int *is_kem) {
+    BENCH_STATE s;
+    int ret = 0;
+
+    memset(&s, 0, sizeof(s));
+    t[0] = t[1] = t[2] = -1;
+    s.libctx = c->libctx;
+    s.alg = alg;
+    memset(s.msg, 0x5a, sizeof(s.msg));
+    if ((s.key = EVP_PKEY_Q_keygen(c->libctx, NULL, alg)) == NULL) {
+        // a pinned provider refuses keys running other variants
+        if (ERR_GET_REASON(ERR_peek_error()) != OQSPROV_R_UNSUPPORTED)
+            return 0;
+        t[0] = t[1] = t[2] = -2;
+        ERR_clear_error();
+        return 1;
+    }
+    if ((s.ctx = EVP_PKEY_CTX_new_from_pkey(c->libctx, s.key, NULL)) == NULL)
+        goto err;
+    *is_kem = !EVP_PKEY_can_sign(s.key);
+    if (*is_kem) {
+        if (EVP_PKEY_encapsulate_init(s.ctx, NULL) <= 0 ||
+            EVP_PKEY_encapsulate(s.ctx, NULL, &s.outlen, NULL, &s.secretlen) <=
+                0)
+            goto err;
+    } else if (EVP_PKEY_sign_init(s.ctx) <= 0 ||
+               EVP_PKEY_sign(s.ctx, NULL, &s.outlen, s.msg, MSGLEN) <= 0) {
+        goto err;
+    }
+    if ((s.out = OPENSSL_malloc(s.outlen)) == NULL ||
+        (s.secret = OPENSSL_malloc(s.secretlen + 1)) == NULL)
+        goto err;
+    t[0] = bench_run(op_keygen, &s, bench_us);
+    // decaps and verify use the output of the last encaps resp. sign
+    t[1] = bench_run(*is_kem ? op_encaps : op_sign, &s, bench_us);
+    t[2] = bench_run(*is_kem ? op_decaps : op_verify, &s, bench_us);
+    ret = t[0] >= 0 && t[1] >= 0 && t[2] >= 0;
+err:
+    OPENSSL_free(s.out);
+    OPENSSL_free(s.secret);
+    EVP_PKEY_CTX_free(s.ctx);
+    EVP_PKEY_free(s.key);
+    return ret;
+}
+
+static void print_time(double t) {
+    if (t == -2)
+        printf(" %10s", "refused");
+    else if (t < 0)
+        printf(" %10s", "failed");
+    else
+        printf(" %10.2f", t);
+}
+
+static int bench_alg(const char *alg, void *arg) {
+    double t[MAX_CONFIGS][3];
+    char impl[16];
+    int i, is_kem = 0, ret = 1;
+
+    for (i = 0; i < nconfigs; i++)
+        if (!bench_config(&configs[i], alg, t[i], &is_kem)) {
+            fprintf(stderr, cRED "  Benchmark of %s failed for %s" cNORM "\n",
+                    alg, configs[i].file);
+            ERR_print_errors_fp(stderr);
+            ret = 0;
+        }
+    for (i = 0; i < 3; i++) {
+        static const char *const ops[2][3] = {{"keygen", "sign", "verify"},
+                                              {"keygen", "encaps", "decaps"}};
+        int j;
+
+        printf("%-28s %-7s", alg, ops[is_kem][i]);
+        for (j = 0; j < nconfigs; j++) {
+            impl_of(&configs[j], alg, impl, sizeof(impl));
+            printf(" %9s", impl);
+            print_time(t[j][i]);
+        }
+        printf("\n");
+    }
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    const char *env, *algs = "mldsa44:mldsa65:falcon512:mayo1:"
+                             "sphincssha2128fsimple:mlkem768:kyber768:hqc128";
+    char *files = NULL, *alg, *next;
+    int errcnt = 0, test = 0, i;
+
+    T(argc == 3);
+    modulename = argv[1];
+    configs[nconfigs++].file = argv[2];
+    bench_us = 1000 * getenv_double("OQS_BENCH_MS", bench_us / 1000);
+    if ((env = getenv("OQS_BENCH_ALGS")) != NULL)
+        algs = env;
+    if ((env = getenv("OQS_BENCH_CONFIGS")) != NULL) {
+        T((files = OPENSSL_strdup(env)) != NULL);
+        for (alg = files; alg != NULL && nconfigs < MAX_CONFIGS; alg = next) {
+            if ((next = strchr(alg, ':')) != NULL)
+                *next++ = '\0';
+            configs[nconfigs++].file = alg;
+        }
+    }
+    for (i = 0; i < nconfigs; i++)
+        T(load_config(&configs[i]));
+
+    printf("\n%-28s %-7s", "algorithm", "op");
+    for (i = 0; i < nconfigs; i++)
+        printf(" %9s %10s", "variant", "us");
+    printf("\n");
+    errcnt += for_each_in_list(algs, bench_alg, NULL);
+
+    for (i = 0; i < nconfigs; i++) {
+        OPENSSL_free(configs[i].impls);
+        OSSL_LIB_CTX_free(configs[i].libctx);
+    }
+    OPENSSL_free(files);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
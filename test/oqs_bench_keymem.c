@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Reports the memory held per live key object for each provider key type,
+ * for keys created by key generation, by decoding a SubjectPublicKeyInfo
+ * (as for trust stores) and by decoding a PrivateKeyInfo.
+ *
+ * Per key, the following are reported:
+ *   heap    bytes held in blocks allocated through OPENSSL_malloc & friends
+ *   allocs  number of such allocations made while creating the key,
+ *           including short-lived ones
+ *   secure  bytes taken from the secure heap (only if it is enabled)
+ *   process growth of the process heap incl. allocations made by liboqs
+ *           directly; only available with glibc
+ * and, split by component:
+ *   desc    the OQS_SIG resp. OQS_KEM descriptor liboqs allocates per key,
+ *           measured as process heap growth per OQS_SIG_new()/OQS_KEM_new()
+ *           (its struct size without glibc)
+ *   struct  the OQSX_KEY struct and its small allocations (names, the
+ *           comp_pubkey/comp_privkey pointer arrays, the classic key context
+ *           holder): heap allocated by the provider minus pub and priv
+ *   pub     the public key buffer
+ *   priv    the private key buffer
+ *   classic the classic EVP_PKEY and key context of hybrid and composite
+ *           keys: heap allocated by OpenSSL minus the EVP_PKEY wrapping the
+ *           provider key
+ *   dup     classic public key bytes held twice, in the public key buffer
+ *           and in the classic EVP_PKEY (hybrid keys)
+ * The split needs all key allocations on the counted heap and is thus not
+ * shown with OQS_BENCH_SECHEAP.
+ *
+ * Environment:
+ *   OQS_BENCH_KEYS    colon-separated key counts (default 1000), e.g.
+ *                     1000:10000:100000:1000000
+ *   OQS_BENCH_ALGS    colon-separated key types (default: all)
+ *   OQS_BENCH_SECHEAP size in bytes of the secure heap to enable (default 0)
+ */
+
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__GLIBC__) && defined(__GLIBC_MINOR__) &&                         \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAVE_MALLINFO2
+#endif
+
+#include "oqs/oqs.h"
+#include "oqs_prov.h"
+#include "test_common.h"
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static long keycounts[8] = {1000};
+static int keycountcnt = 1;
+static double wrapper_size;
+static double desc_size[2]; /* signature, KEM */
+
+typedef struct {
+    size_t heap;
+    size_t prov;
+    size_t allocs;
+    size_t secure;
+    size_t process;
+} MEM_SNAPSHOT;
+
+static void mem_snapshot(MEM_SNAPSHOT *snap) {
+    MEM_COUNTERS counters;
+
+    mem_counting_get(&counters);
+    snap->heap = counters.live;
+    snap->prov = counters.live_prov;
+    snap->allocs = counters.allocs;
+    snap->secure = CRYPTO_secure_malloc_initialized() ? CRYPTO_secure_used()
+                                                      : 0;
+#ifdef HAVE_MALLINFO2
+    snap->process = mallinfo2().uordblks;
+#else
+    snap->process = 0;
+#endif
+}
+
+#define REF_COUNT 1000
+
+/* OpenSSL heap bytes of the EVP_PKEY wrapping a provider key */
+static double measure_wrapper(void) {
+    EVP_PKEY *pkeys[REF_COUNT];
+    MEM_SNAPSHOT before, after;
+    int i;
+
+    mem_snapshot(&before);
+    for (i = 0; i < REF_COUNT; i++)
+        pkeys[i] = EVP_PKEY_new();
+    mem_snapshot(&after);
+    for (i = 0; i < REF_COUNT; i++)
+        EVP_PKEY_free(pkeys[i]);
+    return (double)((after.heap - after.prov) - (before.heap - before.prov)) /
+           REF_COUNT;
+}
+
+/* Process heap bytes of a liboqs descriptor; all algorithms of a kind
+ * share the same descriptor struct, so the first enabled one is used.
+ */
+static double measure_desc(int is_kem) {
+    void *descs[REF_COUNT];
+    const char *alg = NULL;
+    MEM_SNAPSHOT before, after;
+    int i;
+
+    for (i = 0; alg == NULL && i < (is_kem ? OQS_KEM_alg_count()
+                                           : OQS_SIG_alg_count());
+         i++) {
+        alg = is_kem ? OQS_KEM_alg_identifier(i) : OQS_SIG_alg_identifier(i);
+        if (!(is_kem ? OQS_KEM_alg_is_enabled(alg)
+                     : OQS_SIG_alg_is_enabled(alg)))
+            alg = NULL;
+    }
+    if (alg == NULL)
+        return 0;
+    mem_snapshot(&before);
+    for (i = 0; i < REF_COUNT; i++)
+        descs[i] = is_kem ? (void *)OQS_KEM_new(alg) : (void *)OQS_SIG_new(alg);
+    mem_snapshot(&after);
+    for (i = 0; i < REF_COUNT; i++)
+        if (is_kem)
+            OQS_KEM_free(descs[i]);
+        else
+            OQS_SIG_free(descs[i]);
+#ifdef HAVE_MALLINFO2
+    return (double)(after.process - before.process) / REF_COUNT;
+#else
+    return is_kem ? sizeof(OQS_KEM) : sizeof(OQS_SIG);
+#endif
+}
+
+/* length of octet string parameter |name| of |key|, 0 if not reported */
+static size_t key_param_len(EVP_PKEY *key, const char *name) {
+    size_t len = 0;
+
+    if (!EVP_PKEY_get_octet_string_param(key, name, NULL, 0, &len)) {
+        ERR_clear_error();
+        len = 0;
+    }
+    return len;
+}
+
+typedef enum { FROM_KEYGEN, FROM_SPKI, FROM_PKCS8 } KEY_SOURCE;
+static const char *source_names[] = {"keygen", "spki", "pkcs8"};
+
+/* Creates |count| live keys of type |alg| from |source| and prints the
+ * memory held per key. Returns 0 on error, -1 if not applicable.
+ */
+static int bench_keys(const char *alg, KEY_SOURCE source, long count) {
+    EVP_PKEY_CTX *genctx = NULL;
+    EVP_PKEY *tmpl = NULL, **keys = NULL;
+    unsigned char *der = NULL;
+    const unsigned char *p;
+    MEM_SNAPSHOT before, after;
+    int derlen = 0, ret = 0;
+    long i, created = 0;
+
+    if ((genctx = EVP_PKEY_CTX_new_from_name(libctx, alg, NULL)) == NULL ||
+        EVP_PKEY_keygen_init(genctx) <= 0 ||
+        (source != FROM_KEYGEN && EVP_PKEY_generate(genctx, &tmpl) <= 0))
+        goto end;
+    if (source == FROM_SPKI)
+        derlen = i2d_PUBKEY(tmpl, &der);
+    else if (source == FROM_PKCS8)
+        derlen = i2d_PrivateKey(tmpl, &der);
+    if (source != FROM_KEYGEN && derlen <= 0) {
+        // no encoder for this key type (e.g. KEMs without OQS_KEM_ENCODERS)
+        ERR_clear_error();
+        ret = -1;
+        goto end;
+    }
+    if ((keys = OPENSSL_zalloc(count * sizeof(*keys))) == NULL)
+        goto end;
+
+    mem_snapshot(&before);
+    for (; created < count; created++) {
+        p = der;
+        if (source == FROM_KEYGEN)
+            EVP_PKEY_generate(genctx, &keys[created]);
+        else if (source == FROM_SPKI)
+            keys[created] = d2i_PUBKEY_ex(NULL, &p, derlen, libctx, NULL);
+        else
+            keys[created] =
+                d2i_AutoPrivateKey_ex(NULL, &p, derlen, libctx, NULL);
+        if (keys[created] == NULL)
+            goto end;
+    }
+    mem_snapshot(&after);
+
+    printf("%-28s %-6s %8ld %10.1f %8.2f %10.1f %10.1f", alg,
+           source_names[source], count,
+           (double)(after.heap - before.heap) / count,
+           (double)(after.allocs - before.allocs) / count,
+           (double)(after.secure - before.secure) / count,
+           (double)(after.process - before.process) / count);
+    if (CRYPTO_secure_malloc_initialized()) {
+        printf(" %7s %7s %7s %7s %7s %7s\n", "-", "-", "-", "-", "-", "-");
+    } else {
+        double prov = (double)(after.prov - before.prov) / count;
+        double other = (double)((after.heap - after.prov) -
+                                (before.heap - before.prov)) /
+                       count;
+        size_t pub = key_param_len(keys[0], OSSL_PKEY_PARAM_PUB_KEY);
+        size_t priv = key_param_len(keys[0], OSSL_PKEY_PARAM_PRIV_KEY);
+
+        printf(" %7.1f %7.1f %7zu %7zu %7.1f %7zu\n",
+               desc_size[!EVP_PKEY_can_sign(keys[0])], prov - pub - priv,
+               pub, priv, other - wrapper_size,
+               key_param_len(keys[0],
+                             OQS_HYBRID_PKEY_PARAM_CLASSICAL_PUB_KEY));
+    }
+    ret = 1;
+
+end:
+    if (!ret) {
+        fprintf(stderr, cRED "  Creating %s keys from %s failed" cNORM "\n",
+                alg, source_names[source]);
+        ERR_print_errors_fp(stderr);
+    }
+    for (i = 0; i < created; i++)
+        EVP_PKEY_free(keys[i]);
+    OPENSSL_free(keys);
+    OPENSSL_free(der);
+    EVP_PKEY_free(tmpl);
+    EVP_PKEY_CTX_free(genctx);
+    return ret;
+}
+
+static int bench_alg(const char *alg, void *arg) {
+    int i, source, errcnt = 0;
+
+    if (!alg_is_enabled(alg))
+        return 1;
+    for (i = 0; i < keycountcnt; i++)
+        for (source = FROM_KEYGEN; source <= FROM_PKCS8; source++)
+            if (!bench_keys(alg, (KEY_SOURCE)source, keycounts[i]))
+                errcnt++;
+    return errcnt == 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *env;
+    int errcnt = 0, test = 0;
+
+    // must precede any allocation made by OpenSSL
+    T(mem_counting_init());
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+    if ((env = getenv("OQS_BENCH_SECHEAP")) != NULL && atol(env) > 0)
+        T(CRYPTO_secure_malloc_init(atol(env), 32));
+    if ((env = getenv("OQS_BENCH_KEYS")) != NULL) {
+        for (keycountcnt = 0;
+             env != NULL && keycountcnt < (int)(sizeof(keycounts) /
+                                                sizeof(keycounts[0]));
+             env = strchr(env, ':') ? strchr(env, ':') + 1 : NULL)
+            T((keycounts[keycountcnt++] = atol(env)) > 0);
+    }
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, "default"));
+
+    wrapper_size = measure_wrapper();
+    desc_size[0] = measure_desc(0);
+    desc_size[1] = measure_desc(1);
+    printf("%-28s %-6s %8s %10s %8s %10s %10s %7s %7s %7s %7s %7s %7s\n",
+           "key type", "source", "keys", "heap/key", "allocs", "secure/key",
+           "process", "desc", "struct", "pub", "priv", "classic", "dup");
+    if ((env = getenv("OQS_BENCH_ALGS")) != NULL)
+        errcnt += for_each_in_list(env, bench_alg, NULL);
+    else
+        errcnt += for_each_oqs_alg(libctx, OSSL_OP_KEYMGMT, bench_alg, NULL);
+
+    OSSL_LIB_CTX_free(libctx);
+    if (CRYPTO_secure_malloc_initialized())
+        CRYPTO_secure_malloc_done();
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
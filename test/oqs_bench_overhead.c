@@ -0,0 +1,333 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Compares the cost of each plain (non-hybrid) algorithm called directly via
+ * liboqs with the cost of the same operation through the provider's EVP
+ * path, using identical keys and inputs. Algorithms for which the wrapping
+ * costs as much as liboqs itself are marked with '!'.
+ *
+ * Environment:
+ *   OQS_BENCH_MS  minimum measurement time per operation in ms (default 200)
+ */
+
+#include <ctype.h>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oqs/oqs.h"
+#include "test_common.h"
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static double bench_us = 200000;
+
+static const size_t msglens[] = {32, 1024, 65536};
+
+/* Returns whether liboqs name |oqsname| (e.g. "SPHINCS+-SHA2-128f-simple")
+ * denotes provider algorithm |provname| (e.g. "sphincssha2128fsimple").
+ */
+static int oqsname_matches(const char *oqsname, const char *provname) {
+    char norm[100];
+    size_t i = 0;
+
+    for (; *oqsname != '\0' && i < sizeof(norm) - 1; oqsname++)
+        if (isalnum((unsigned char)*oqsname))
+            norm[i++] = (char)tolower((unsigned char)*oqsname);
+    norm[i] = '\0';
+    if (!strcmp(norm, provname))
+        return 1;
+    // FrodoKEM is registered without the "kem" infix
+    return !strncmp(norm, "frodokem", 8) && !strncmp(provname, "frodo", 5) &&
+           !strcmp(norm + 8, provname + 5);
+}
+
+static void print_result(const char *alg, const char *op, size_t len,
+                         double raw, double evp) {
+    double overhead = evp - raw;
+
+    printf("%-30s %-7s %7zu %11.2f %11.2f %11.2f %7.1f%% %s\n", alg, op, len,
+           raw, evp, overhead, raw > 0 ? 100 * overhead / raw : 0,
+           overhead >= raw ? "!" : "");
+}
+
+typedef struct {
+    OQS_SIG *sig;
+    EVP_PKEY_CTX *genctx;
+    EVP_PKEY_CTX *sctx;
+    EVP_PKEY_CTX *vctx;
+    unsigned char *pk, *sk, *msg, *sigbuf;
+    size_t msglen, siglen;
+} SIG_BENCH;
+
+static int raw_sig_keygen(void *arg) {
+    SIG_BENCH *b = arg;
+    return OQS_SIG_keypair(b->sig, b->pk, b->sk) == OQS_SUCCESS;
+}
+
+static int evp_sig_keygen(void *arg) {
+    SIG_BENCH *b = arg;
+    EVP_PKEY *key = NULL;
+    int ret = EVP_PKEY_generate(b->genctx, &key);
+
+    EVP_PKEY_free(key);
+    return ret;
+}
+
+static int raw_sig_sign(void *arg) {
+    SIG_BENCH *b = arg;
+    return OQS_SIG_sign(b->sig, b->sigbuf, &b->siglen, b->msg, b->msglen,
+                        b->sk) == OQS_SUCCESS;
+}
+
+static int evp_sig_sign(void *arg) {
+    SIG_BENCH *b = arg;
+
+    b->siglen = b->sig->length_signature;
+    return EVP_PKEY_sign(b->sctx, b->sigbuf, &b->siglen, b->msg, b->msglen);
+}
+
+static int raw_sig_verify(void *arg) {
+    SIG_BENCH *b = arg;
+    return OQS_SIG_verify(b->sig, b->msg, b->msglen, b->sigbuf, b->siglen,
+                          b->pk) == OQS_SUCCESS;
+}
+
+static int evp_sig_verify(void *arg) {
+    SIG_BENCH *b = arg;
+    return EVP_PKEY_verify(b->vctx, b->sigbuf, b->siglen, b->msg,
+                           b->msglen) == 1;
+}
+
+static int bench_sig(const char *provname, const char *oqsname) {
+    SIG_BENCH b;
+    EVP_PKEY *key = NULL;
+    size_t i, sklen = 0, pklen = 0;
+    double raw, evp;
+    int ret = 0;
+
+    memset(&b, 0, sizeof(b));
+    if ((b.sig = OQS_SIG_new(oqsname)) == NULL ||
+        (b.genctx = EVP_PKEY_CTX_new_from_name(libctx, provname, NULL)) ==
+            NULL ||
+        EVP_PKEY_keygen_init(b.genctx) <= 0 ||
+        EVP_PKEY_generate(b.genctx, &key) <= 0)
+        goto err;
+
+    /* use the provider's key material for the direct calls, too */
+    b.pk = OPENSSL_malloc(b.sig->length_public_key);
+    b.sk = OPENSSL_malloc(b.sig->length_secret_key);
+    b.sigbuf = OPENSSL_malloc(b.sig->length_signature);
+    b.msg = OPENSSL_malloc(msglens[sizeof(msglens) / sizeof(msglens[0]) - 1]);
+    if (b.pk == NULL || b.sk == NULL || b.sigbuf == NULL || b.msg == NULL ||
+        !EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, b.pk,
+                                         b.sig->length_public_key, &pklen) ||
+        !EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PRIV_KEY, b.sk,
+                                         b.sig->length_secret_key, &sklen) ||
+        pklen != b.sig->length_public_key ||
+        sklen != b.sig->length_secret_key)
+        goto err;
+    memset(b.msg, 0xa5, msglens[sizeof(msglens) / sizeof(msglens[0]) - 1]);
+
+    if ((b.sctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) == NULL ||
+        (b.vctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) == NULL ||
+        EVP_PKEY_sign_init(b.sctx) <= 0 || EVP_PKEY_verify_init(b.vctx) <= 0)
+        goto err;
+
+    // keygen last, as raw keygen overwrites pk/sk
+    for (i = 0; i < sizeof(msglens) / sizeof(msglens[0]); i++) {
+        b.msglen = msglens[i];
+        if ((evp = bench_run(evp_sig_sign, &b, bench_us)) < 0 ||
+            (raw = bench_run(raw_sig_sign, &b, bench_us)) < 0)
+            goto err;
+        print_result(provname, "sign", b.msglen, raw, evp);
+        if ((evp = bench_run(evp_sig_verify, &b, bench_us)) < 0 ||
+            (raw = bench_run(raw_sig_verify, &b, bench_us)) < 0)
+            goto err;
+        print_result(provname, "verify", b.msglen, raw, evp);
+    }
+    if ((evp = bench_run(evp_sig_keygen, &b, bench_us)) < 0 ||
+        (raw = bench_run(raw_sig_keygen, &b, bench_us)) < 0)
+        goto err;
+    print_result(provname, "keygen", 0, raw, evp);
+    ret = 1;
+
+err:
+    if (!ret) {
+        fprintf(stderr, cRED "  Benchmark failed for %s" cNORM "\n",
+                provname);
+        ERR_print_errors_fp(stderr);
+    }
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(b.genctx);
+    EVP_PKEY_CTX_free(b.sctx);
+    EVP_PKEY_CTX_free(b.vctx);
+    OPENSSL_free(b.pk);
+    OPENSSL_clear_free(b.sk, b.sig ? b.sig->length_secret_key : 0);
+    OPENSSL_free(b.sigbuf);
+    OPENSSL_free(b.msg);
+    OQS_SIG_free(b.sig);
+    return ret;
+}
+
+typedef struct {
+    OQS_KEM *kem;
+    EVP_PKEY_CTX *genctx;
+    EVP_PKEY_CTX *ectx;
+    EVP_PKEY_CTX *dctx;
+    unsigned char *pk, *sk, *ct, *ss;
+    size_t ctlen, sslen;
+} KEM_BENCH;
+
+static int raw_kem_keygen(void *arg) {
+    KEM_BENCH *b = arg;
+    return OQS_KEM_keypair(b->kem, b->pk, b->sk) == OQS_SUCCESS;
+}
+
+static int evp_kem_keygen(void *arg) {
+    KEM_BENCH *b = arg;
+    EVP_PKEY *key = NULL;
+    int ret = EVP_PKEY_generate(b->genctx, &key);
+
+    EVP_PKEY_free(key);
+    return ret;
+}
+
+static int raw_kem_encaps(void *arg) {
+    KEM_BENCH *b = arg;
+    return OQS_KEM_encaps(b->kem, b->ct, b->ss, b->pk) == OQS_SUCCESS;
+}
+
+static int evp_kem_encaps(void *arg) {
+    KEM_BENCH *b = arg;
+
+    b->ctlen = b->kem->length_ciphertext;
+    b->sslen = b->kem->length_shared_secret;
+    return EVP_PKEY_encapsulate(b->ectx, b->ct, &b->ctlen, b->ss, &b->sslen);
+}
+
+static int raw_kem_decaps(void *arg) {
+    KEM_BENCH *b = arg;
+    return OQS_KEM_decaps(b->kem, b->ss, b->ct, b->sk) == OQS_SUCCESS;
+}
+
+static int evp_kem_decaps(void *arg) {
+    KEM_BENCH *b = arg;
+
+    b->sslen = b->kem->length_shared_secret;
+    return EVP_PKEY_decapsulate(b->dctx, b->ss, &b->sslen, b->ct,
+                                b->kem->length_ciphertext);
+}
+
+static int bench_kem(const char *provname, const char *oqsname) {
+    KEM_BENCH b;
+    EVP_PKEY *key = NULL;
+    size_t sklen = 0, pklen = 0;
+    double raw, evp;
+    int ret = 0;
+
+    memset(&b, 0, sizeof(b));
+    if ((b.kem = OQS_KEM_new(oqsname)) == NULL ||
+        (b.genctx = EVP_PKEY_CTX_new_from_name(libctx, provname, NULL)) ==
+            NULL ||
+        EVP_PKEY_keygen_init(b.genctx) <= 0 ||
+        EVP_PKEY_generate(b.genctx, &key) <= 0)
+        goto err;
+
+    b.pk = OPENSSL_malloc(b.kem->length_public_key);
+    b.sk = OPENSSL_malloc(b.kem->length_secret_key);
+    b.ct = OPENSSL_malloc(b.kem->length_ciphertext);
+    b.ss = OPENSSL_malloc(b.kem->length_shared_secret);
+    if (b.pk == NULL || b.sk == NULL || b.ct == NULL || b.ss == NULL ||
+        !EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, b.pk,
+                                         b.kem->length_public_key, &pklen) ||
+        !EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PRIV_KEY, b.sk,
+                                         b.kem->length_secret_key, &sklen) ||
+        pklen != b.kem->length_public_key ||
+        sklen != b.kem->length_secret_key)
+        goto err;
+
+    if ((b.ectx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) == NULL ||
+        (b.dctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) == NULL ||
+        EVP_PKEY_encapsulate_init(b.ectx, NULL) <= 0 ||
+        EVP_PKEY_decapsulate_init(b.dctx, NULL) <= 0)
+        goto err;
+
+    if ((evp = bench_run(evp_kem_encaps, &b, bench_us)) < 0 ||
+        (raw = bench_run(raw_kem_encaps, &b, bench_us)) < 0)
+        goto err;
+    print_result(provname, "encaps", b.kem->length_public_key, raw, evp);
+    if ((evp = bench_run(evp_kem_decaps, &b, bench_us)) < 0 ||
+        (raw = bench_run(raw_kem_decaps, &b, bench_us)) < 0)
+        goto err;
+    print_result(provname, "decaps", b.kem->length_ciphertext, raw, evp);
+    if ((evp = bench_run(evp_kem_keygen, &b, bench_us)) < 0 ||
+        (raw = bench_run(raw_kem_keygen, &b, bench_us)) < 0)
+        goto err;
+    print_result(provname, "keygen", 0, raw, evp);
+    ret = 1;
+
+err:
+    if (!ret) {
+        fprintf(stderr, cRED "  Benchmark failed for %s" cNORM "\n",
+                provname);
+        ERR_print_errors_fp(stderr);
+    }
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(b.genctx);
+    EVP_PKEY_CTX_free(b.ectx);
+    EVP_PKEY_CTX_free(b.dctx);
+    OPENSSL_free(b.pk);
+    OPENSSL_clear_free(b.sk, b.kem ? b.kem->length_secret_key : 0);
+    OPENSSL_free(b.ct);
+    OPENSSL_clear_free(b.ss, b.kem ? b.kem->length_shared_secret : 0);
+    OQS_KEM_free(b.kem);
+    return ret;
+}
+
+/* Benchmarks provider algorithm |alg| of the operation |arg| points to if it
+ * has a liboqs counterpart; hybrids and composites have none and are skipped.
+ */
+static int bench_alg(const char *alg, void *arg) {
+    int operation_id = *(int *)arg;
+    const char *oqsname;
+    int i, count;
+
+    if (strchr(alg, '_') != NULL || !alg_is_enabled(alg))
+        return 1;
+    count = operation_id == OSSL_OP_SIGNATURE ? OQS_SIG_alg_count()
+                                              : OQS_KEM_alg_count();
+    for (i = 0; i < count; i++) {
+        oqsname = operation_id == OSSL_OP_SIGNATURE ? OQS_SIG_alg_identifier(i)
+                                                    : OQS_KEM_alg_identifier(i);
+        if (oqsname_matches(oqsname, alg))
+            return operation_id == OSSL_OP_SIGNATURE ? bench_sig(alg, oqsname)
+                                                     : bench_kem(alg, oqsname);
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    static int opids[2] = {OSSL_OP_SIGNATURE, OSSL_OP_KEM};
+    int errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+    bench_us = 1000 * getenv_double("OQS_BENCH_MS", bench_us / 1000);
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, modulename));
+
+    printf("%-30s %-7s %7s %11s %11s %11s %8s\n", "algorithm", "op", "bytes",
+           "liboqs us", "EVP us", "overhead", "rel");
+    errcnt += for_each_oqs_alg(libctx, OSSL_OP_SIGNATURE, bench_alg, &opids[0]);
+    errcnt += for_each_oqs_alg(libctx, OSSL_OP_KEM, bench_alg, &opids[1]);
+
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
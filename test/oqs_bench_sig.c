@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Measures signing and verification per signature algorithm, as a baseline
+ * for MAYO, whose public key liboqs expands again for every verification,
+ * and SPHINCS+, whose tweakable hash liboqs seeds again for every signature
+ * and verification. The same key, message and signature are used for all
+ * runs; signing and verification contexts are set up once per algorithm.
+ *
+ * Environment:
+ *   OQS_BENCH_ALGS  colon-separated signature algorithms (default all MAYO
+ *                   and SPHINCS+ parameter sets)
+ *   OQS_BENCH_MS    minimum measurement time per operation in ms
+ *                   (default 200)
+ */
+
+#include <openssl/core_names.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_common.h"
+
+#define MSGLEN 32
+#define DEFAULT_ALGS                                                           \
+    "mayo1:mayo2:mayo3:mayo5:sphincssha2128fsimple:sphincssha2128ssimple:"     \
+    "sphincssha2192fsimple:sphincsshake128fsimple"
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static double bench_us = 200000;
+
+typedef struct {
+    EVP_PKEY_CTX *sctx;
+    EVP_PKEY_CTX *vctx;
+    unsigned char msg[MSGLEN];
+    unsigned char *sig;
+    size_t siglen, maxsiglen;
+} SIG_BENCH;
+
+static int bench_sign(void *arg) {
+    SIG_BENCH *b = arg;
+
+    b->siglen = b->maxsiglen;
+    return EVP_PKEY_sign(b->sctx, b->sig, &b->siglen, b->msg, MSGLEN) > 0;
+}
+
+static int bench_verify(void *arg) {
+    SIG_BENCH *b = arg;
+
+    return EVP_PKEY_verify(b->vctx, b->sig, b->siglen, b->msg, MSGLEN) == 1;
+}
+
+static int bench_alg(const char *alg, void *arg) {
+    SIG_BENCH b;
+    EVP_PKEY *key = NULL;
+    size_t publen = 0;
+    double sign, verify;
+    int ret = 0;
+
+    memset(&b, 0, sizeof(b));
+    memset(b.msg, 0x5a, MSGLEN);
+    if ((key = EVP_PKEY_Q_keygen(libctx, NULL, alg)) == NULL ||
+        !EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, NULL, 0,
+                                         &publen) ||
+        (b.sctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) == NULL ||
+        (b.vctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) == NULL ||
+        EVP_PKEY_sign_init(b.sctx) <= 0 || EVP_PKEY_verify_init(b.vctx) <= 0 ||
+        EVP_PKEY_sign(b.sctx, NULL, &b.maxsiglen, b.msg, MSGLEN) <= 0 ||
+        (b.sig = OPENSSL_malloc(b.maxsiglen)) == NULL)
+        goto err;
+    // signing first leaves a valid signature for verification
+    if ((sign = bench_run(bench_sign, &b, bench_us)) < 0 ||
+        (verify = bench_run(bench_verify, &b, bench_us)) < 0)
+        goto err;
+    printf("%-28s %8zu %8zu %12.2f %12.2f %10.0f\n", alg, publen, b.siglen,
+           sign, verify, verify > 0 ? 1e6 / verify : 0);
+    ret = 1;
+
+err:
+    if (!ret) {
+        fprintf(stderr, cRED "  Benchmark failed for %s" cNORM "\n", alg);
+        ERR_print_errors_fp(stderr);
+    }
+    OPENSSL_free(b.sig);
+    EVP_PKEY_CTX_free(b.vctx);
+    EVP_PKEY_CTX_free(b.sctx);
+    EVP_PKEY_free(key);
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    const char *algs;
+    int errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+    bench_us = 1000 * getenv_double("OQS_BENCH_MS", bench_us / 1000);
+    if ((algs = getenv("OQS_BENCH_ALGS")) == NULL)
+        algs = DEFAULT_ALGS;
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, modulename));
+
+    printf("%-28s %8s %8s %12s %12s %10s\n", "algorithm", "publen", "siglen",
+           "sign us", "verify us", "verify/s");
+    errcnt = for_each_in_list(algs, bench_alg, NULL);
+
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
@@ -0,0 +1,691 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Feeds malformed and maximal signatures and SubjectPublicKeyInfo structures
+ * of quantum-safe, hybrid and composite signature algorithms to the provider
+ * and measures the CPU time spent on each. Inputs are grouped in classes:
+ *
+ *   sig_truncated   valid signature cut short
+ *   sig_oversized   valid signature with bytes appended, up to 1 MB
+ *   sig_bitflip     valid signature with single bits flipped
+ *   sig_maximal     random signatures of full length (for SPHINCS+ a full
+ *                   tree hash on garbage; hybrid: random PQ half)
+ *   sig_hyb_prefix  hybrid: classic signature length prefix out of range
+ *   sig_cmp_asn1    composite: deeply nested, oversized length fields,
+ *                   swapped, empty, surplus and wrongly typed components
+ *   spki_truncated  valid SubjectPublicKeyInfo cut short
+ *   spki_keylen     public key bytes shortened or extended, up to 1 MB
+ *   spki_nested     deeply nested ASN.1 around and inside the structure
+ *   spki_component  hybrid and composite: mismatched component sizes,
+ *                   swapped, empty and wrongly typed components
+ *
+ * No signature may verify; SubjectPublicKeyInfo inputs that still decode
+ * are reported. Every input runs OQS_ADV_REPS times; for each class the
+ * median CPU time of its slowest input must stay below a ceiling of a class
+ * factor times the median time of the valid signature resp.
+ * SubjectPublicKeyInfo plus a constant slack, the test fails otherwise. Per
+ * class the distribution over all samples is printed.
+ *
+ * Hybrid and composite algorithms are told apart by whether the provider
+ * offers the first component of the name as a key type, so composites are
+ * recognized whatever their quantum-safe algorithm.
+ *
+ * Environment:
+ *   OQS_ADV_ALGS     colon-separated signature algorithms
+ *                    (default see below)
+ *   OQS_ADV_REPS     runs per input (default 5)
+ *   OQS_ADV_SLACK_US constant added to all ceilings (default 2000)
+ *   OQS_ADV_FACTOR   scales all class factors (default 1)
+ */
+
+#include <openssl/asn1.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/provider.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_common.h"
+
+#define MSGLEN 32
+#define MAX_INPUTS 32
+#define MAX_INPUT_LEN (1024 * 1024)
+/* nesting depths tried, below and far above OpenSSL's ASN.1 limits */
+#define NEST_SHALLOW 64
+#define NEST_DEEP 10000
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static int reps = 5;
+static double slack_us = 2000;
+static double factor_scale = 1;
+
+typedef struct {
+    const char *alg;
+    int hybrid;    /* classic_pq: length-prefixed concatenations */
+    int composite; /* pq_classic: ASN.1 SEQUENCEs of components */
+    EVP_PKEY *key;
+    EVP_PKEY_CTX *vctx;
+    unsigned char msg[MSGLEN];
+    unsigned char *sig;
+    size_t siglen, maxsiglen;
+    unsigned char *spki;
+    int spkilen;
+    X509_PUBKEY *xpk;
+    const unsigned char *pub; /* key bytes inside xpk */
+    int publen;
+} adv_ctx;
+
+typedef struct {
+    unsigned char *data[MAX_INPUTS];
+    size_t len[MAX_INPUTS];
+    int n;
+} adv_inputs;
+
+typedef struct {
+    const char *name;
+    int verify; /* 1: inputs are signatures, 0: SubjectPublicKeyInfos */
+    double factor;
+    int (*gen)(const adv_ctx *c, adv_inputs *in);
+} adv_class;
+
+/// Input construction
+
+/* takes ownership of "data" */
+static int add_owned(adv_inputs *in, unsigned char *data, size_t len) {
+    if (data == NULL || in->n == MAX_INPUTS) {
+        OPENSSL_free(data);
+        return 0;
+    }
+    in->data[in->n] = data;
+    in->len[in->n++] = len;
+    return 1;
+}
+
+/* copies "len" bytes of "data", padding with "pad" up to "padlen" */
+static int add_copy(adv_inputs *in, const unsigned char *data, size_t len,
+                    size_t padlen, int pad) {
+    unsigned char *buf = OPENSSL_malloc(padlen > len ? padlen : len + 1);
+
+    if (buf == NULL)
+        return 0;
+    memcpy(buf, data, len);
+    if (padlen > len)
+        memset(buf + len, pad, padlen - len);
+    return add_owned(in, buf, padlen > len ? padlen : len);
+}
+
+static void free_inputs(adv_inputs *in) {
+    while (in->n > 0)
+        OPENSSL_free(in->data[--in->n]);
+}
+
+/* writes a DER header for "tag" and "len" ending at "end"; returns its size
+ */
+static size_t der_header_before(unsigned char *end, int tag, size_t len) {
+    size_t n = 0;
+
+    if (len < 0x80) {
+        *--end = (unsigned char)len;
+        n = 1;
+    } else {
+        for (; len > 0; len >>= 8, n++)
+            *--end = (unsigned char)len;
+        *--end = (unsigned char)(0x80 | n);
+        n++;
+    }
+    *--end = (unsigned char)tag;
+    return n + 1;
+}
+
+/* "content" wrapped in "depth" SEQUENCEs */
+static int add_nested(adv_inputs *in, const unsigned char *content,
+                      size_t len, int depth) {
+    size_t cap = len + 6 * (size_t)depth, pos = cap;
+    unsigned char *buf = OPENSSL_malloc(cap);
+    int i;
+
+    if (buf == NULL)
+        return 0;
+    pos -= len;
+    memcpy(buf + pos, content, len);
+    for (i = 0; i < depth; i++)
+        pos -= der_header_before(buf + pos, V_ASN1_SEQUENCE | 0x20,
+                                 cap - pos);
+    memmove(buf, buf + pos, cap - pos);
+    return add_owned(in, buf, cap - pos);
+}
+
+/* "content" with its outer length field replaced by a 4-byte one of
+ * 0xffffffff */
+static int add_huge_length(adv_inputs *in, const unsigned char *der,
+                           size_t len) {
+    size_t hdr;
+    unsigned char *buf;
+
+    if (len < 2)
+        return 0;
+    hdr = (der[1] & 0x80) ? 2 + (der[1] & 0x7f) : 2;
+    if (len < hdr || (buf = OPENSSL_malloc(len - hdr + 6)) == NULL)
+        return 0;
+    buf[0] = der[0];
+    buf[1] = 0x84;
+    memset(buf + 2, 0xff, 4);
+    memcpy(buf + 6, der + hdr, len - hdr);
+    return add_owned(in, buf, len - hdr + 6);
+}
+
+static int add_sk(adv_inputs *in, const STACK_OF(ASN1_TYPE) *sk) {
+    unsigned char *der = NULL;
+    int len = i2d_ASN1_SEQUENCE_ANY(sk, &der);
+
+    return len > 0 && add_owned(in, der, len);
+}
+
+/* ASN.1 SEQUENCE "der" with two components: swapped, first one empty,
+ * a third one added and the first one replaced by a BOOLEAN, a NULL, an
+ * OBJECT and an INTEGER */
+static int add_component_variants(adv_inputs *in, const unsigned char *der,
+                                  size_t len) {
+    static const int types[] = {V_ASN1_BOOLEAN, V_ASN1_NULL, V_ASN1_OBJECT,
+                                V_ASN1_INTEGER};
+    const unsigned char *p = der;
+    STACK_OF(ASN1_TYPE) *sk = d2i_ASN1_SEQUENCE_ANY(NULL, &p, len);
+    ASN1_TYPE *first = NULL, *t = NULL, *empty = NULL;
+    ASN1_STRING *str = NULL;
+    ASN1_INTEGER *aint = NULL;
+    size_t i;
+    int ok, ret = 0;
+
+    if (sk == NULL || sk_ASN1_TYPE_num(sk) != 2)
+        goto err;
+    first = sk_ASN1_TYPE_value(sk, 0);
+
+    // the stack is restored before bailing out so that it is freed once
+    sk_ASN1_TYPE_set(sk, 0, sk_ASN1_TYPE_value(sk, 1));
+    sk_ASN1_TYPE_set(sk, 1, first);
+    ok = add_sk(in, sk);
+    sk_ASN1_TYPE_set(sk, 1, sk_ASN1_TYPE_value(sk, 0));
+    sk_ASN1_TYPE_set(sk, 0, first);
+    if (!ok || !sk_ASN1_TYPE_push(sk, first))
+        goto err;
+    ok = add_sk(in, sk);
+    sk_ASN1_TYPE_pop(sk);
+    if (!ok)
+        goto err;
+
+    if ((empty = ASN1_TYPE_new()) == NULL ||
+        (str = ASN1_STRING_type_new(first->type)) == NULL)
+        goto err;
+    ASN1_TYPE_set(empty, first->type, str);
+    str = NULL;
+    sk_ASN1_TYPE_set(sk, 0, empty);
+    if (!add_sk(in, sk))
+        goto err;
+
+    for (i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        ASN1_TYPE_free(t);
+        if ((t = ASN1_TYPE_new()) == NULL)
+            goto err;
+        switch (types[i]) {
+        case V_ASN1_BOOLEAN:
+            ASN1_TYPE_set(t, V_ASN1_BOOLEAN, (void *)1);
+            break;
+        case V_ASN1_NULL:
+            ASN1_TYPE_set(t, V_ASN1_NULL, NULL);
+            break;
+        case V_ASN1_OBJECT:
+            ASN1_TYPE_set(t, V_ASN1_OBJECT, OBJ_nid2obj(NID_sha256));
+            break;
+        default:
+            if ((aint = ASN1_INTEGER_new()) == NULL ||
+                !ASN1_INTEGER_set(aint, 0x7fffffff))
+                goto err;
+            ASN1_TYPE_set(t, V_ASN1_INTEGER, aint);
+            aint = NULL;
+        }
+        sk_ASN1_TYPE_set(sk, 0, t);
+        if (!add_sk(in, sk))
+            goto err;
+    }
+    ret = 1;
+
+err:
+    if (first != NULL)
+        sk_ASN1_TYPE_set(sk, 0, first);
+    ASN1_STRING_free(str);
+    ASN1_INTEGER_free(aint);
+    ASN1_TYPE_free(t);
+    ASN1_TYPE_free(empty);
+    sk_ASN1_TYPE_pop_free(sk, ASN1_TYPE_free);
+    return ret;
+}
+
+/* SubjectPublicKeyInfo of the key's algorithm around "key" */
+static int add_spki(adv_inputs *in, const adv_ctx *c, const unsigned char *key,
+                    size_t keylen) {
+    X509_PUBKEY *xpk = X509_PUBKEY_new();
+    ASN1_OBJECT *obj;
+    unsigned char *copy = OPENSSL_malloc(keylen + 1), *der = NULL;
+    int len = 0;
+
+    if (xpk != NULL && copy != NULL &&
+        X509_PUBKEY_get0_param(&obj, NULL, NULL, NULL, c->xpk)) {
+        memcpy(copy, key, keylen);
+        if (X509_PUBKEY_set0_param(xpk, OBJ_dup(obj), V_ASN1_UNDEF, NULL, copy,
+                                   keylen))
+            copy = NULL;
+        len = i2d_X509_PUBKEY(xpk, &der);
+    }
+    OPENSSL_free(copy);
+    X509_PUBKEY_free(xpk);
+    return len > 0 && add_owned(in, der, len);
+}
+
+/* hybrid encodings: 4-byte big endian classic length, classic part, PQ
+ * part; "data" with the length replaced by implausible values */
+static int add_prefix_variants(adv_inputs *in, const adv_ctx *c,
+                               const unsigned char *data, size_t len,
+                               int spki) {
+    const unsigned long classic = ((unsigned long)data[0] << 24) |
+                                  (data[1] << 16) | (data[2] << 8) | data[3];
+    const unsigned long prefixes[] = {
+        0, 1, classic - 1, classic + 1, len - 4, len - 3, 0x7fffffff,
+        0xffffffff};
+    unsigned char *buf;
+    size_t i;
+
+    for (i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+        if ((buf = OPENSSL_memdup(data, len)) == NULL)
+            return 0;
+        buf[0] = (unsigned char)(prefixes[i] >> 24);
+        buf[1] = (unsigned char)(prefixes[i] >> 16);
+        buf[2] = (unsigned char)(prefixes[i] >> 8);
+        buf[3] = (unsigned char)prefixes[i];
+        if (!spki) {
+            if (!add_owned(in, buf, len))
+                return 0;
+        } else {
+            int ok = add_spki(in, c, buf, len);
+
+            OPENSSL_free(buf);
+            if (!ok)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/// Input classes
+
+static int gen_sig_truncated(const adv_ctx *c, adv_inputs *in) {
+    const size_t lens[] = {0, 1, 4, c->siglen / 2, c->siglen - 1};
+    size_t i;
+
+    for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++)
+        if (!add_copy(in, c->sig, lens[i], 0, 0))
+            return 0;
+    return 1;
+}
+
+static int gen_sig_oversized(const adv_ctx *c, adv_inputs *in) {
+    return add_copy(in, c->sig, c->siglen, c->siglen + 1, 0) &&
+           add_copy(in, c->sig, c->siglen, c->maxsiglen + 1, 0xff) &&
+           add_copy(in, c->sig, c->siglen, 2 * c->maxsiglen, 0x5a) &&
+           add_copy(in, c->sig, c->siglen, MAX_INPUT_LEN, 0xff);
+}
+
+static int gen_sig_bitflip(const adv_ctx *c, adv_inputs *in) {
+    unsigned char *buf;
+    size_t i, pos;
+
+    for (i = 0; i < 8; i++) {
+        pos = i * (c->siglen - 1) / 7;
+        if ((buf = OPENSSL_memdup(c->sig, c->siglen)) == NULL)
+            return 0;
+        buf[pos] ^= 1 << (i % 8);
+        if (!add_owned(in, buf, c->siglen))
+            return 0;
+    }
+    return 1;
+}
+
+static int gen_sig_maximal(const adv_ctx *c, adv_inputs *in) {
+    size_t keep = 0;
+    unsigned char *buf;
+    int i;
+
+    // hybrid: keep prefix and classic signature so the PQ half gets checked
+    if (c->hybrid)
+        keep = 4 + (((size_t)c->sig[0] << 24) | (c->sig[1] << 16) |
+                    (c->sig[2] << 8) | c->sig[3]);
+    if (keep > c->siglen)
+        return 0;
+    for (i = 0; i < 4; i++) {
+        if ((buf = OPENSSL_malloc(c->siglen)) == NULL ||
+            RAND_bytes(buf, c->siglen) <= 0) {
+            OPENSSL_free(buf);
+            return 0;
+        }
+        memcpy(buf, c->sig, keep);
+        if (!add_owned(in, buf, c->siglen))
+            return 0;
+    }
+    return 1;
+}
+
+static int gen_sig_hyb_prefix(const adv_ctx *c, adv_inputs *in) {
+    return !c->hybrid || add_prefix_variants(in, c, c->sig, c->siglen, 0);
+}
+
+static int gen_sig_cmp_asn1(const adv_ctx *c, adv_inputs *in) {
+    if (!c->composite)
+        return 1;
+    return add_nested(in, c->sig, c->siglen, NEST_SHALLOW) &&
+           add_nested(in, c->sig, c->siglen, NEST_DEEP) &&
+           add_huge_length(in, c->sig, c->siglen) &&
+           add_component_variants(in, c->sig, c->siglen);
+}
+
+static int gen_spki_truncated(const adv_ctx *c, adv_inputs *in) {
+    const size_t lens[] = {1, 2, 24, c->spkilen / 2, c->spkilen - 1};
+    size_t i;
+
+    for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++)
+        if (!add_copy(in, c->spki, lens[i], 0, 0))
+            return 0;
+    return 1;
+}
+
+static int gen_spki_keylen(const adv_ctx *c, adv_inputs *in) {
+    unsigned char *buf = OPENSSL_zalloc(MAX_INPUT_LEN);
+    int ret;
+
+    if (buf == NULL)
+        return 0;
+    memcpy(buf, c->pub, c->publen);
+    ret = add_spki(in, c, buf, 0) && add_spki(in, c, buf, c->publen - 1) &&
+          add_spki(in, c, buf, c->publen + 1) &&
+          add_spki(in, c, buf, 2 * c->publen) &&
+          add_spki(in, c, buf, MAX_INPUT_LEN);
+    OPENSSL_free(buf);
+    return ret;
+}
+
+static int gen_spki_nested(const adv_ctx *c, adv_inputs *in) {
+    adv_inputs keys = {0};
+    int i, ret;
+
+    ret = add_nested(in, c->spki, c->spkilen, NEST_SHALLOW) &&
+          add_nested(in, c->spki, c->spkilen, NEST_DEEP) &&
+          add_huge_length(in, c->spki, c->spkilen) &&
+          // key bytes consisting of nested SEQUENCEs
+          add_nested(&keys, c->pub, c->publen, NEST_SHALLOW) &&
+          add_nested(&keys, c->pub, c->publen, NEST_DEEP);
+    for (i = 0; ret && i < keys.n; i++)
+        ret = add_spki(in, c, keys.data[i], keys.len[i]);
+    free_inputs(&keys);
+    return ret;
+}
+
+static int gen_spki_component(const adv_ctx *c, adv_inputs *in) {
+    adv_inputs keys = {0};
+    int i, ret = 1;
+
+    if (c->hybrid)
+        return add_prefix_variants(in, c, c->pub, c->publen, 1);
+    if (!c->composite)
+        return 1;
+    ret = add_component_variants(&keys, c->pub, c->publen);
+    for (i = 0; ret && i < keys.n; i++)
+        ret = add_spki(in, c, keys.data[i], keys.len[i]);
+    free_inputs(&keys);
+    return ret;
+}
+
+static const adv_class classes[] = {
+    {"sig_truncated", 1, 2, gen_sig_truncated},
+    {"sig_oversized", 1, 2, gen_sig_oversized},
+    {"sig_bitflip", 1, 2, gen_sig_bitflip},
+    {"sig_maximal", 1, 2, gen_sig_maximal},
+    {"sig_hyb_prefix", 1, 2, gen_sig_hyb_prefix},
+    {"sig_cmp_asn1", 1, 2, gen_sig_cmp_asn1},
+    {"spki_truncated", 0, 4, gen_spki_truncated},
+    {"spki_keylen", 0, 4, gen_spki_keylen},
+    {"spki_nested", 0, 4, gen_spki_nested},
+    {"spki_component", 0, 4, gen_spki_component},
+};
+
+/// Measurement
+
+/* CPU time of one verification resp. decoding; sets "*accepted" if the
+ * input verified resp. decoded */
+static double run_input(const adv_ctx *c, int verify, const unsigned char *in,
+                        size_t len, int *accepted) {
+    const unsigned char *p = in;
+    EVP_PKEY *pub;
+    double start = get_cpu_time_us(), t;
+
+    if (verify) {
+        *accepted = EVP_PKEY_verify(c->vctx, in, len, c->msg, MSGLEN) == 1;
+        t = get_cpu_time_us() - start;
+    } else {
+        pub = d2i_PUBKEY_ex(NULL, &p, len, libctx, NULL);
+        t = get_cpu_time_us() - start;
+        *accepted = pub != NULL;
+        EVP_PKEY_free(pub);
+    }
+    ERR_clear_error();
+    return t;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static double median(double *v, size_t n) {
+    qsort(v, n, sizeof(*v), cmp_double);
+    return v[n / 2];
+}
+
+/* all samples of the class into "samples", the highest per-input median
+ * into "*worst"; returns the number of inputs or -1 on error */
+static int run_class(const adv_ctx *c, const adv_class *cls, double *samples,
+                     double *worst, int *accepted) {
+    adv_inputs in = {0};
+    double *runs = samples, *scratch = samples + MAX_INPUTS * reps, m;
+    int i, n, r, acc;
+
+    *worst = 0;
+    *accepted = 0;
+    if (!cls->gen(c, &in)) {
+        free_inputs(&in);
+        return -1;
+    }
+    for (i = 0; i < in.n; i++, runs += reps) {
+        for (r = 0; r < reps; r++) {
+            runs[r] = run_input(c, cls->verify, in.data[i], in.len[i], &acc);
+            *accepted += acc;
+        }
+        // median() sorts; keep the samples in order for the distribution
+        memcpy(scratch, runs, reps * sizeof(*runs));
+        if ((m = median(scratch, reps)) > *worst)
+            *worst = m;
+    }
+    n = in.n;
+    free_inputs(&in);
+    return n;
+}
+
+/* Returns whether the part of "alg" before "sep" is a key type of the
+ * provider under test: composite names start with the quantum-safe
+ * algorithm, hybrid ones with the classic one. */
+static int starts_quantum_safe(const char *alg, const char *sep) {
+    EVP_KEYMGMT *km;
+    char first[64];
+    int ret;
+
+    if ((size_t)(sep - alg) >= sizeof(first))
+        return 0;
+    memcpy(first, alg, sep - alg);
+    first[sep - alg] = '\0';
+    ERR_set_mark();
+    km = EVP_KEYMGMT_fetch(libctx, first, NULL);
+    ERR_pop_to_mark();
+    ret = km != NULL && !strcmp(OSSL_PROVIDER_get0_name(
+                                    EVP_KEYMGMT_get0_provider(km)),
+                                modulename);
+    EVP_KEYMGMT_free(km);
+    return ret;
+}
+
+static int setup_alg(adv_ctx *c, const char *alg) {
+    EVP_PKEY_CTX *sctx = NULL;
+    const unsigned char *p;
+    const char *sep = strchr(alg, '_');
+    int ret = 0;
+
+    memset(c, 0, sizeof(*c));
+    c->alg = alg;
+    c->composite = sep != NULL && starts_quantum_safe(alg, sep);
+    c->hybrid = sep != NULL && !c->composite;
+    memset(c->msg, 0x5a, MSGLEN);
+    if ((c->key = EVP_PKEY_Q_keygen(libctx, NULL, alg)) == NULL ||
+        !EVP_PKEY_can_sign(c->key) ||
+        (sctx = EVP_PKEY_CTX_new_from_pkey(libctx, c->key, NULL)) == NULL ||
+        EVP_PKEY_sign_init(sctx) <= 0 ||
+        EVP_PKEY_sign(sctx, NULL, &c->maxsiglen, c->msg, MSGLEN) <= 0 ||
+        (c->sig = OPENSSL_malloc(c->maxsiglen)) == NULL)
+        goto err;
+    c->siglen = c->maxsiglen;
+    if (EVP_PKEY_sign(sctx, c->sig, &c->siglen, c->msg, MSGLEN) <= 0 ||
+        (c->vctx = EVP_PKEY_CTX_new_from_pkey(libctx, c->key, NULL)) == NULL ||
+        EVP_PKEY_verify_init(c->vctx) <= 0 ||
+        (c->spkilen = i2d_PUBKEY(c->key, &c->spki)) <= 0)
+        goto err;
+    p = c->spki;
+    if ((c->xpk = d2i_X509_PUBKEY(NULL, &p, c->spkilen)) == NULL ||
+        !X509_PUBKEY_get0_param(NULL, &c->pub, &c->publen, NULL, c->xpk) ||
+        c->publen < 8)
+        goto err;
+    ret = 1;
+err:
+    EVP_PKEY_CTX_free(sctx);
+    return ret;
+}
+
+static void cleanup_alg(adv_ctx *c) {
+    X509_PUBKEY_free(c->xpk);
+    OPENSSL_free(c->spki);
+    OPENSSL_free(c->sig);
+    EVP_PKEY_CTX_free(c->vctx);
+    EVP_PKEY_free(c->key);
+}
+
+static int test_alg(const char *alg, double *samples) {
+    adv_ctx c;
+    double base[2], ceiling, worst;
+    size_t i;
+    int n, accepted, ok = 1, acc;
+
+    if (!setup_alg(&c, alg)) {
+        fprintf(stderr, cRED "  Setup failed for %s" cNORM "\n", alg);
+        ERR_print_errors_fp(stderr);
+        cleanup_alg(&c);
+        return 0;
+    }
+    // valid inputs as reference: base[0] decoding, base[1] verification
+    for (n = 0; n < 2; n++) {
+        for (i = 0; i < (size_t)reps; i++) {
+            samples[i] = run_input(&c, n, n ? c.sig : c.spki,
+                                   n ? c.siglen : (size_t)c.spkilen, &acc);
+            if (!acc) {
+                fprintf(stderr, cRED "  %s: valid input rejected" cNORM "\n",
+                        alg);
+                cleanup_alg(&c);
+                return 0;
+            }
+        }
+        base[n] = median(samples, reps);
+    }
+    printf("%s: valid signature %.1f us, valid SubjectPublicKeyInfo %.1f us\n",
+           alg, base[1], base[0]);
+
+    for (i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+        const adv_class *cls = &classes[i];
+
+        if ((n = run_class(&c, cls, samples, &worst, &accepted)) < 0) {
+            fprintf(stderr, cRED "  %s %s: input generation failed" cNORM "\n",
+                    alg, cls->name);
+            ok = 0;
+            continue;
+        }
+        if (n == 0)
+            continue;
+        ceiling = cls->factor * factor_scale * base[cls->verify] + slack_us;
+        qsort(samples, (size_t)n * reps, sizeof(*samples), cmp_double);
+        printf("  %-16s %3d inputs  p50 %10.1f  p90 %10.1f  max %10.1f  "
+               "worst input %10.1f  ceiling %10.1f%s\n",
+               cls->name, n, samples[n * reps / 2], samples[n * reps * 9 / 10],
+               samples[n * reps - 1], worst, ceiling,
+               worst > ceiling ? "  EXCEEDED" : "");
+        if (worst > ceiling)
+            ok = 0;
+        if (cls->verify && accepted > 0) {
+            fprintf(stderr, cRED "  %s %s: %d runs verified" cNORM "\n", alg,
+                    cls->name, accepted);
+            ok = 0;
+        } else if (accepted > 0) {
+            printf("  %-16s %d runs decoded\n", "", accepted);
+        }
+    }
+    cleanup_alg(&c);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    const char *env, *algs = "mldsa44:p256_mldsa44:mldsa44_p256:"
+                             "mldsa65_pss3072:sphincssha2128ssimple:"
+                             "p256_sphincssha2128ssimple:"
+                             "sphincssha2192fsimple";
+    char *list = NULL, *alg, *next;
+    double *samples = NULL;
+    int errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+    if ((env = getenv("OQS_ADV_ALGS")) != NULL)
+        algs = env;
+    if ((env = getenv("OQS_ADV_REPS")) != NULL)
+        T((reps = atoi(env)) > 0);
+    if ((env = getenv("OQS_ADV_SLACK_US")) != NULL)
+        slack_us = strtod(env, NULL);
+    if ((env = getenv("OQS_ADV_FACTOR")) != NULL)
+        T((factor_scale = strtod(env, NULL)) > 0);
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, modulename));
+
+    // per input "reps" samples plus room for a copy to take medians of
+    T((samples = OPENSSL_malloc(2 * MAX_INPUTS * reps * sizeof(double))) !=
+      NULL);
+    T((list = OPENSSL_strdup(algs)) != NULL);
+    for (alg = list; alg != NULL; alg = next) {
+        if ((next = strchr(alg, ':')) != NULL)
+            *next++ = '\0';
+        if (alg_is_enabled(alg) && !test_alg(alg, samples))
+            errcnt++;
+    }
+    OPENSSL_free(list);
+    OPENSSL_free(samples);
+
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Issues certificates with the bulk issuance routine of examples/ for a mix
+ * of certificate requests, bare public keys and a request with broken
+ * signature, once with worker threads and once inline, and checks order,
+ * serial numbers, subjects and CA signatures of the results.
+ *
+ * Environment:
+ *   OQS_BULK_ALGS  colon-separated CA and subject key algorithms
+ *                  (default mldsa44:p256_mldsa44)
+ *   OQS_BULK_COUNT number of inputs per run (default 24)
+ */
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/provider.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bulk_issuance.h"
+#include "test_common.h"
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static int count = 24;
+
+#define BAD_INPUT 5
+
+static X509 *make_ca(EVP_PKEY *key) {
+    X509 *cert = X509_new_ex(libctx, NULL);
+    X509_NAME *name = X509_get_subject_name(cert);
+
+    if (cert == NULL ||
+        !X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                    (unsigned char *)"bulk CA", -1, -1, 0) ||
+        !X509_set_issuer_name(cert, name) ||
+        !ASN1_INTEGER_set(X509_get_serialNumber(cert), 1) ||
+        !X509_gmtime_adj(X509_getm_notBefore(cert), 0) ||
+        !X509_gmtime_adj(X509_getm_notAfter(cert), 3600) ||
+        !X509_set_pubkey(cert, key) || !X509_sign(cert, key, NULL)) {
+        X509_free(cert);
+        return NULL;
+    }
+    return cert;
+}
+
+/* Every fourth input is a bare public key, the others requests; the
+ * request at index BAD_INPUT gets a broken signature. */
+static int write_inputs(BIO *in, EVP_PKEY *key) {
+    X509_REQ *req = NULL;
+    unsigned char *der = NULL;
+    char cn[16];
+    int i, len, ret = 0;
+
+    for (i = 0; i < count; i++) {
+        if (i % 4 == 3) {
+            if (!PEM_write_bio_PUBKEY(in, key))
+                goto err;
+            continue;
+        }
+        BIO_snprintf(cn, sizeof(cn), "req%d", i);
+        if ((req = X509_REQ_new_ex(libctx, NULL)) == NULL ||
+            !X509_NAME_add_entry_by_txt(X509_REQ_get_subject_name(req), "CN",
+                                        MBSTRING_ASC, (unsigned char *)cn, -1,
+                                        -1, 0) ||
+            !X509_REQ_set_pubkey(req, key) || !X509_REQ_sign(req, key, NULL) ||
+            (len = i2d_X509_REQ(req, &der)) <= 0)
+            goto err;
+        if (i == BAD_INPUT)
+            der[len - 1] ^= 1;
+        if (!PEM_write_bio(in, PEM_STRING_X509_REQ, "", der, len))
+            goto err;
+        OPENSSL_free(der);
+        der = NULL;
+        X509_REQ_free(req);
+        req = NULL;
+    }
+    ret = 1;
+err:
+    OPENSSL_free(der);
+    X509_REQ_free(req);
+    return ret;
+}
+
+static int check_outputs(BIO *out, EVP_PKEY *cakey) {
+    const unsigned char *p;
+    unsigned char *data;
+    long len = BIO_get_mem_data(out, &data);
+    X509 *cert;
+    char cn[32], expected[32];
+    uint64_t serial;
+    int i, n = 0;
+
+    p = data;
+    for (i = 0; i < count; i++) {
+        if (i == BAD_INPUT)
+            continue;
+        if ((cert = d2i_X509(NULL, &p, data + len - p)) == NULL) {
+            fprintf(stderr, cRED "  Certificate %d missing" cNORM "\n", i);
+            return 0;
+        }
+        if (i % 4 == 3)
+            BIO_snprintf(expected, sizeof(expected), "%x", i + 1);
+        else
+            BIO_snprintf(expected, sizeof(expected), "req%d", i);
+        if (X509_NAME_get_text_by_NID(X509_get_subject_name(cert),
+                                      NID_commonName, cn, sizeof(cn)) < 0 ||
+            strcmp(cn, expected) != 0 ||
+            !ASN1_INTEGER_get_uint64(&serial, X509_get0_serialNumber(cert)) ||
+            serial != (uint64_t)i + 1 || X509_verify(cert, cakey) != 1) {
+            fprintf(stderr, cRED "  Certificate %d wrong" cNORM "\n", i);
+            X509_free(cert);
+            return 0;
+        }
+        X509_free(cert);
+        n++;
+    }
+    return p == data + len && n == count - 1;
+}
+
+static int test_alg(const char *alg) {
+    EVP_PKEY *cakey = NULL, *key = NULL;
+    X509 *cacert = NULL;
+    OQS_BULK_ISSUER *issuer = NULL;
+    OQS_BULK_STATS stats;
+    BIO *in = NULL, *out = NULL;
+    int threads, ret = 0;
+
+    if ((cakey = EVP_PKEY_Q_keygen(libctx, NULL, alg)) == NULL ||
+        (key = EVP_PKEY_Q_keygen(libctx, NULL, alg)) == NULL ||
+        (cacert = make_ca(cakey)) == NULL)
+        goto err;
+
+    for (threads = 4; threads >= -1; threads -= 5) {
+        oqs_bulk_issuer_free(issuer);
+        BIO_free(in);
+        BIO_free(out);
+        in = out = NULL;
+        if ((issuer = oqs_bulk_issuer_new(libctx, NULL, cakey, cacert, NULL,
+                                          threads)) == NULL ||
+            (in = BIO_new(BIO_s_mem())) == NULL ||
+            (out = BIO_new(BIO_s_mem())) == NULL ||
+            !write_inputs(in, key) || !oqs_bulk_issue(issuer, in, out, &stats))
+            goto err;
+        if (stats.issued != (uint64_t)count - 1 || stats.failed != 1 ||
+            !check_outputs(out, cakey))
+            goto err;
+        printf("%-28s %d threads: %8.1f certificates/s\n", alg, stats.threads,
+               stats.seconds > 0 ? stats.issued / stats.seconds : 0);
+    }
+    ret = 1;
+
+err:
+    if (!ret) {
+        fprintf(stderr, cRED "  Bulk issuance failed for %s" cNORM "\n", alg);
+        ERR_print_errors_fp(stderr);
+    }
+    oqs_bulk_issuer_free(issuer);
+    BIO_free(in);
+    BIO_free(out);
+    X509_free(cacert);
+    EVP_PKEY_free(key);
+    EVP_PKEY_free(cakey);
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    const char *env, *algs = "mldsa44:p256_mldsa44";
+    char *list = NULL, *alg, *next;
+    int errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+    if ((env = getenv("OQS_BULK_ALGS")) != NULL)
+        algs = env;
+    if ((env = getenv("OQS_BULK_COUNT")) != NULL)
+        T((count = atoi(env)) > BAD_INPUT);
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, "default"));
+
+    T((list = OPENSSL_strdup(algs)) != NULL);
+    for (alg = list; alg != NULL; alg = next) {
+        if ((next = strchr(alg, ':')) != NULL)
+            *next++ = '\0';
+        if (alg_is_enabled(alg) && !test_alg(alg))
+            errcnt++;
+    }
+    OPENSSL_free(list);
+
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Writes a bundle of quantum-safe private and public keys, certificates and
+ * classic keys, PEM and DER encoded, reads it back through the "oqsbundle"
+ * store loader of the provider and checks that all objects come back in
+ * order. The PEM bundle is also read preceded by comment and text lines, as
+ * in distribution CA bundles. On POSIX systems this is done with and without
+ * decoding threads.
+ *
+ * Environment:
+ *   OQS_BUNDLE_ALGS   colon-separated key algorithms
+ *                     (default mldsa44:p256_mldsa44:mlkem768:falcon512)
+ *   OQS_BUNDLE_ROUNDS times all algorithms are put into the bundle
+ *                     (default 3)
+ */
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/provider.h>
+#include <openssl/store.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_common.h"
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static int rounds = 3;
+
+#define MAX_BUNDLE_OBJS 512
+/* Windows builds of the provider always decode on the calling thread */
+#ifdef _WIN32
+#define MAX_TEST_THREADS 0
+#else
+#define MAX_TEST_THREADS 4
+#endif
+
+typedef struct {
+    int type; /* OSSL_STORE_INFO_* */
+    EVP_PKEY *key;
+    X509 *cert;
+} bundle_entry;
+
+static bundle_entry entries[MAX_BUNDLE_OBJS];
+static int nentries = 0;
+
+static X509 *make_cert(EVP_PKEY *key) {
+    X509 *cert = X509_new_ex(libctx, NULL);
+    X509_NAME *name = X509_get_subject_name(cert);
+
+    if (cert == NULL ||
+        !X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                    (unsigned char *)"bundle", -1, -1, 0) ||
+        !X509_set_issuer_name(cert, name) ||
+        !ASN1_INTEGER_set(X509_get_serialNumber(cert), nentries) ||
+        !X509_gmtime_adj(X509_getm_notBefore(cert), 0) ||
+        !X509_gmtime_adj(X509_getm_notAfter(cert), 3600) ||
+        !X509_set_pubkey(cert, key) || !X509_sign(cert, key, NULL)) {
+        X509_free(cert);
+        return NULL;
+    }
+    return cert;
+}
+
+static int add_entry(BIO *pem, BIO *der, int type, EVP_PKEY *key,
+                     X509 *cert) {
+    int ok;
+
+    if (nentries == MAX_BUNDLE_OBJS)
+        return 0;
+    switch (type) {
+    case OSSL_STORE_INFO_PKEY:
+        ok = PEM_write_bio_PrivateKey(pem, key, NULL, NULL, 0, NULL, NULL) &&
+             i2d_PKCS8PrivateKeyInfo_bio(der, key);
+        break;
+    case OSSL_STORE_INFO_PUBKEY:
+        ok = PEM_write_bio_PUBKEY(pem, key) && i2d_PUBKEY_bio(der, key);
+        break;
+    default:
+        ok = PEM_write_bio_X509(pem, cert) && i2d_X509_bio(der, cert);
+    }
+    if (!ok)
+        return 0;
+    entries[nentries].type = type;
+    entries[nentries].key = key;
+    entries[nentries].cert = cert;
+    if ((key != NULL && !EVP_PKEY_up_ref(key)) ||
+        (cert != NULL && !X509_up_ref(cert)))
+        return 0;
+    nentries++;
+    return 1;
+}
+
+/* Per algorithm: private key, public key and, for signature algorithms, a
+ * certificate; per round one classic key in between. */
+static int write_bundle(BIO *pem, BIO *der, char *algs) {
+    EVP_PKEY *key = NULL;
+    X509 *cert = NULL;
+    char *list = NULL, *alg, *next;
+    int i, ret = 0;
+
+    for (i = 0; i < rounds; i++) {
+        if ((list = OPENSSL_strdup(algs)) == NULL)
+            goto err;
+        for (alg = list; alg != NULL; alg = next) {
+            if ((next = strchr(alg, ':')) != NULL)
+                *next++ = '\0';
+            if (!alg_is_enabled(alg))
+                continue;
+            if ((key = EVP_PKEY_Q_keygen(libctx, NULL, alg)) == NULL ||
+                !add_entry(pem, der, OSSL_STORE_INFO_PKEY, key, NULL) ||
+                !add_entry(pem, der, OSSL_STORE_INFO_PUBKEY, key, NULL))
+                goto err;
+            if (EVP_PKEY_can_sign(key) &&
+                ((cert = make_cert(key)) == NULL ||
+                 !add_entry(pem, der, OSSL_STORE_INFO_CERT, NULL, cert)))
+                goto err;
+            EVP_PKEY_free(key);
+            X509_free(cert);
+            key = NULL;
+            cert = NULL;
+        }
+        OPENSSL_free(list);
+        list = NULL;
+        if ((key = EVP_PKEY_Q_keygen(libctx, NULL, "EC", "P-256")) == NULL ||
+            !add_entry(pem, der, OSSL_STORE_INFO_PKEY, key, NULL))
+            goto err;
+        EVP_PKEY_free(key);
+        key = NULL;
+    }
+    ret = 1;
+err:
+    OPENSSL_free(list);
+    EVP_PKEY_free(key);
+    X509_free(cert);
+    return ret;
+}
+
+static int check_entry(int i, OSSL_STORE_INFO *info) {
+    EVP_PKEY *key = NULL;
+
+    if (OSSL_STORE_INFO_get_type(info) != entries[i].type)
+        return 0;
+    switch (entries[i].type) {
+    case OSSL_STORE_INFO_PKEY:
+        key = OSSL_STORE_INFO_get0_PKEY(info);
+        break;
+    case OSSL_STORE_INFO_PUBKEY:
+        key = OSSL_STORE_INFO_get0_PUBKEY(info);
+        break;
+    default:
+        return X509_cmp(OSSL_STORE_INFO_get0_CERT(info), entries[i].cert) == 0;
+    }
+    return key != NULL && EVP_PKEY_eq(key, entries[i].key) == 1;
+}
+
+static int read_bundle(BIO *in, const char *encoding) {
+    OSSL_STORE_CTX *store;
+    OSSL_STORE_INFO *info;
+    int i = 0, ret = 1;
+
+    if ((store = OSSL_STORE_attach(in, "oqsbundle", libctx, NULL, NULL, NULL,
+                                   NULL, NULL, NULL)) == NULL)
+        return 0;
+    while (ret && !OSSL_STORE_eof(store)) {
+        if ((info = OSSL_STORE_load(store)) == NULL)
+            continue;
+        if (i == nentries || !check_entry(i, info)) {
+            fprintf(stderr, cRED "  %s object %d wrong" cNORM "\n", encoding,
+                    i);
+            ret = 0;
+        }
+        OSSL_STORE_INFO_free(info);
+        i++;
+    }
+    if (ret && i != nentries) {
+        fprintf(stderr, cRED "  %s: %d of %d objects read" cNORM "\n",
+                encoding, i, nentries);
+        ret = 0;
+    }
+    OSSL_STORE_close(store);
+    return ret;
+}
+
+/* Comment and text lines as found in front of the objects of CA bundles */
+static const char bundle_preamble[] =
+    "# oqs-provider test bundle\n"
+    "#\n"
+    "Certificate:\n"
+    "    Data:\n"
+    "        Subject: CN = bundle\n";
+
+static int test_bundle(char *algs) {
+    BIO *pem = BIO_new(BIO_s_mem()), *der = BIO_new(BIO_s_mem());
+    BIO *commented = BIO_new(BIO_s_mem());
+    BIO *in = NULL;
+    char *data;
+    long len;
+    int threads, ret = 0;
+
+    if (pem == NULL || der == NULL || commented == NULL ||
+        !write_bundle(pem, der, algs))
+        goto err;
+    len = BIO_get_mem_data(pem, &data);
+    if (BIO_puts(commented, bundle_preamble) <= 0 ||
+        BIO_write(commented, data, (int)len) != (int)len)
+        goto err;
+    for (threads = 0; threads <= MAX_TEST_THREADS; threads += 4) {
+#ifndef _WIN32
+        char env[8];
+
+        BIO_snprintf(env, sizeof(env), "%d", threads);
+        setenv("OQS_BUNDLE_THREADS", env, 1);
+#endif
+        len = BIO_get_mem_data(pem, &data);
+        if ((in = BIO_new_mem_buf(data, len)) == NULL ||
+            !read_bundle(in, "PEM"))
+            goto err;
+        BIO_free(in);
+        in = NULL;
+        len = BIO_get_mem_data(commented, &data);
+        if ((in = BIO_new_mem_buf(data, len)) == NULL ||
+            !read_bundle(in, "commented PEM"))
+            goto err;
+        BIO_free(in);
+        in = NULL;
+        len = BIO_get_mem_data(der, &data);
+        if ((in = BIO_new_mem_buf(data, len)) == NULL ||
+            !read_bundle(in, "DER"))
+            goto err;
+        BIO_free(in);
+        in = NULL;
+        printf("%d objects read with %d decoding threads\n", nentries,
+               threads);
+    }
+    ret = 1;
+
+err:
+    if (!ret) {
+        fprintf(stderr, cRED "  Bundle decoding failed" cNORM "\n");
+        ERR_print_errors_fp(stderr);
+    }
+    BIO_free(in);
+    BIO_free(pem);
+    BIO_free(der);
+    BIO_free(commented);
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    char *algs = "mldsa44:p256_mldsa44:mlkem768:falcon512";
+    const char *env;
+    int errcnt = 0, test = 0, i;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+    if ((env = getenv("OQS_BUNDLE_ALGS")) != NULL)
+        algs = (char *)env;
+    if ((env = getenv("OQS_BUNDLE_ROUNDS")) != NULL)
+        T((rounds = atoi(env)) > 0);
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, "default"));
+
+    if (!test_bundle(algs))
+        errcnt++;
+
+    for (i = 0; i < nentries; i++) {
+        EVP_PKEY_free(entries[i].key);
+        X509_free(entries[i].cert);
+    }
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
@@ -0,0 +1,275 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Checks the liboqs implementation variant reporting and pinning: the
+ * provider parameters oqs-cpu-features and oqs-implementations are present
+ * and consistent with each other, an unpinned provider reports pin "auto",
+ * and a second provider instance pinned to a variant some algorithm does not
+ * run on this CPU refuses generating and decoding keys of that algorithm
+ * while the first instance still accepts them.
+ *
+ * The pinned instance is loaded from a configuration file written to the
+ * current directory; builds linking the provider statically ignore
+ * configuration files and only check the parameters.
+ */
+
+#include <ctype.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/provider.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oqs_prov.h"
+#include "test_common.h"
+
+#define PIN_CONFIG "oqs_test_impl_pin.cnf"
+
+static char *modulename = NULL;
+static char *configfile = NULL;
+
+/* Reads pin, CPU features and implementation list of "modulename" in
+ * "libctx"; "*features" and "*impls" are to be freed by the caller. */
+static int get_impl_params(OSSL_LIB_CTX *libctx, const char **pin,
+                           char **features, char **impls) {
+    OSSL_PROVIDER *prov;
+    OSSL_PARAM params[4];
+    int ret = 0;
+
+    *features = *impls = NULL;
+    if ((prov = OSSL_PROVIDER_load(libctx, modulename)) == NULL)
+        return 0;
+    params[0] = OSSL_PARAM_construct_utf8_ptr(
+        OQS_PROV_PARAM_IMPLEMENTATION_PIN, (char **)pin, 0);
+    params[1] = OSSL_PARAM_construct_utf8_string(OQS_PROV_PARAM_CPU_FEATURES,
+                                                 NULL, 0);
+    params[2] = OSSL_PARAM_construct_utf8_string(
+        OQS_PROV_PARAM_IMPLEMENTATIONS, NULL, 0);
+    params[3] = OSSL_PARAM_construct_end();
+    // first call returns the sizes of the strings
+    if (!OSSL_PROVIDER_get_params(prov, params) ||
+        !OSSL_PARAM_modified(&params[1]) || !OSSL_PARAM_modified(&params[2]) ||
+        (*features = OPENSSL_zalloc(params[1].return_size + 1)) == NULL ||
+        (*impls = OPENSSL_zalloc(params[2].return_size + 1)) == NULL)
+        goto err;
+    params[1].data = *features;
+    params[1].data_size = params[1].return_size + 1;
+    params[2].data = *impls;
+    params[2].data_size = params[2].return_size + 1;
+    ret = OSSL_PROVIDER_get_params(prov, params);
+
+err:
+    OSSL_PROVIDER_unload(prov);
+    return ret;
+}
+
+/* Returns whether the comma-separated "list" holds "name". */
+static int has_entry(const char *list, const char *name) {
+    size_t len = strlen(name);
+    const char *p = list;
+
+    for (;;) {
+        if (!strncmp(p, name, len) && (p[len] == ',' || p[len] == '\0'))
+            return 1;
+        if ((p = strchr(p, ',')) == NULL)
+            return 0;
+        p++;
+    }
+}
+
+/* Checks that every entry of "impls" names a known variant the CPU has the
+ * extensions for; returns the number of problems. */
+static int check_impls(const char *features, const char *impls) {
+    const char *p, *eq, *end;
+    size_t len;
+    int errcnt = 0;
+
+    if (*impls == '\0') {
+        fprintf(stderr, cRED "  No implementations reported" cNORM "\n");
+        return 1;
+    }
+    for (p = impls; p != NULL; p = end != NULL ? end + 1 : NULL) {
+        end = strchr(p, ',');
+        len = end != NULL ? (size_t)(end - p) : strlen(p);
+        if ((eq = memchr(p, '=', len)) == NULL) {
+            fprintf(stderr, cRED "  Malformed entry %.*s" cNORM "\n", (int)len,
+                    p);
+            errcnt++;
+            continue;
+        }
+        eq++;
+        len -= eq - p;
+        if (!(len == 7 && !strncmp(eq, "default", 7)) &&
+            !(len == 8 && !strncmp(eq, "portable", 8)) &&
+            !(len == 7 && !strncmp(eq, "unknown", 7) &&
+              has_entry(features, "avx2")) &&
+            !(len == 4 && !strncmp(eq, "avx2", 4) &&
+              has_entry(features, "avx2")) &&
+            !(len == 7 && !strncmp(eq, "aarch64", 7) &&
+              has_entry(features, "arm_neon"))) {
+            fprintf(stderr, cRED "  Variant %.*s not possible here" cNORM "\n",
+                    (int)(eq - p + len), p);
+            errcnt++;
+        }
+    }
+    return errcnt;
+}
+
+/* Finds an algorithm of "libctx" running an optimized variant or, lacking
+ * CPU support, the portable one; writes its provider name to "alg" and a
+ * variant it does not run to "*pin". Returns 0 if there is none. */
+static int find_pinnable(OSSL_LIB_CTX *libctx, const char *impls, char *alg,
+                         size_t len, const char **pin) {
+    const char *p, *eq, *end;
+    EVP_KEYMGMT *km;
+    size_t i;
+
+    for (p = impls; p != NULL; p = end != NULL ? end + 1 : NULL) {
+        end = strchr(p, ',');
+        if ((eq = strchr(p, '=')) == NULL || (end != NULL && eq > end))
+            continue;
+        eq++;
+        if (!strncmp(eq, "default", 7) || !strncmp(eq, "unknown", 7))
+            continue;
+        *pin = !strncmp(eq, "portable", 8) ? "avx2" : "portable";
+        // provider names are the liboqs ones reduced to lower case alnums
+        for (i = 0; p < eq - 1 && i < len - 1; p++)
+            if (isalnum((unsigned char)*p))
+                alg[i++] = (char)tolower((unsigned char)*p);
+        alg[i] = '\0';
+        ERR_set_mark();
+        km = EVP_KEYMGMT_fetch(libctx, alg, NULL);
+        ERR_pop_to_mark();
+        if (km != NULL) {
+            EVP_KEYMGMT_free(km);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Returns whether the errors raised include the provider's refusal; the
+ * core may add errors of its own after it. Clears the error queue. */
+static int refused(void) {
+    unsigned long err;
+    int ret = 0;
+
+    while ((err = ERR_get_error()) != 0)
+        if (ERR_GET_LIB(err) == ERR_LIB_USER &&
+            ERR_GET_REASON(err) == OQSPROV_R_UNSUPPORTED)
+            ret = 1;
+    return ret;
+}
+
+#ifndef OQS_PROVIDER_STATIC
+static int write_pin_config(const char *pin) {
+    FILE *f;
+
+    if ((f = fopen(PIN_CONFIG, "w")) == NULL)
+        return 0;
+    fprintf(f,
+            "openssl_conf = openssl_init\n\n"
+            "[openssl_init]\nproviders = provider_sect\n\n"
+            "[provider_sect]\ndefault = default_sect\n%s = oqs_sect\n\n"
+            "[default_sect]\nactivate = 1\n\n"
+            "[oqs_sect]\nactivate = 1\nimplementation = %s\n",
+            modulename, pin);
+    return fclose(f) == 0;
+}
+
+/* Checks that the instance of "pinned" refuses "alg", which the instance of
+ * "libctx" accepts, for key generation and decoding. */
+static int check_refusal(OSSL_LIB_CTX *libctx, OSSL_LIB_CTX *pinned,
+                         const char *alg) {
+    EVP_PKEY *key = NULL, *other = NULL;
+    unsigned char *der = NULL;
+    const unsigned char *derp;
+    int derlen, ret = 0;
+
+    if ((key = EVP_PKEY_Q_keygen(libctx, NULL, alg)) == NULL ||
+        (derlen = i2d_PUBKEY(key, &der)) <= 0) {
+        fprintf(stderr, cRED "  Unpinned instance refuses %s" cNORM "\n", alg);
+        goto err;
+    }
+    if ((other = EVP_PKEY_Q_keygen(pinned, NULL, alg)) != NULL || !refused()) {
+        fprintf(stderr, cRED "  Pinned instance generates %s" cNORM "\n", alg);
+        goto err;
+    }
+    derp = der;
+    if ((other = d2i_PUBKEY_ex(NULL, &derp, derlen, pinned, NULL)) != NULL ||
+        !refused()) {
+        fprintf(stderr, cRED "  Pinned instance decodes %s" cNORM "\n", alg);
+        goto err;
+    }
+    // the first instance is not affected by the pin of the second one
+    derp = der;
+    if ((other = d2i_PUBKEY_ex(NULL, &derp, derlen, libctx, NULL)) == NULL) {
+        fprintf(stderr, cRED "  Unpinned instance rejects %s" cNORM "\n", alg);
+        goto err;
+    }
+    ret = 1;
+
+err:
+    ERR_print_errors_fp(stderr);
+    OPENSSL_free(der);
+    EVP_PKEY_free(other);
+    EVP_PKEY_free(key);
+    return ret;
+}
+#endif // ifndef OQS_PROVIDER_STATIC
+
+int main(int argc, char *argv[]) {
+    OSSL_LIB_CTX *libctx = NULL, *pinned = NULL;
+    const char *pin = NULL, *topin = NULL;
+    char *features = NULL, *impls = NULL, *pfeatures = NULL, *pimpls = NULL;
+    char alg[64];
+    int errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(get_impl_params(libctx, &pin, &features, &impls));
+    printf("CPU features: %s\npin: %s\nimplementations: %s\n", features, pin,
+           impls);
+    if (strcmp(pin, "auto") != 0) {
+        fprintf(stderr, cRED "  Unpinned instance reports %s" cNORM "\n",
+                pin);
+        errcnt++;
+    }
+    errcnt += check_impls(features, impls);
+
+    if (!find_pinnable(libctx, impls, alg, sizeof(alg), &topin)) {
+        printf("No algorithm with several variants, pinning not checked\n");
+        goto end;
+    }
+#ifndef OQS_PROVIDER_STATIC
+    printf("Pinning %s for %s\n", topin, alg);
+    T((pinned = OSSL_LIB_CTX_new()) != NULL);
+    T(write_pin_config(topin));
+    load_oqs_provider(pinned, modulename, PIN_CONFIG);
+    remove(PIN_CONFIG);
+    T(get_impl_params(pinned, &pin, &pfeatures, &pimpls));
+    if (strcmp(pin, topin) != 0) {
+        fprintf(stderr, cRED "  Pinned instance reports %s" cNORM "\n", pin);
+        errcnt++;
+    }
+    if (!check_refusal(libctx, pinned, alg))
+        errcnt++;
+#else
+    printf("Static build, pinning %s for %s not checked\n", topin, alg);
+#endif
+
+end:
+    OPENSSL_free(features);
+    OPENSSL_free(impls);
+    OPENSSL_free(pfeatures);
+    OPENSSL_free(pimpls);
+    OSSL_LIB_CTX_free(pinned);
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
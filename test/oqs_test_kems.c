@@ -1,7 +1,9 @@
 // SPDX-License-Identifier: Apache-2.0 AND MIT
 
+#include <openssl/core_names.h>
 #include <openssl/evp.h>
 #include <openssl/provider.h>
+#include <openssl/x509.h>
 #include <string.h>
 
 #include "oqs/oqs.h"
@@ -11,6 +13,180 @@ static OSSL_LIB_CTX *libctx = NULL;
 static char *modulename = NULL;
 static char *configfile = NULL;
 
+/* A key from parameter generation has no key material yet; reading it must
+ * fail cleanly instead of touching key buffers that do not exist */
+static int test_oqs_kem_empty_key(EVP_PKEY *key) {
+    EVP_PKEY_CTX *ctx = NULL;
+    unsigned char *buf = NULL, pub[16];
+    size_t len;
+    int testresult;
+
+    testresult =
+        EVP_PKEY_get1_encoded_public_key(key, &buf) == 0 &&
+        !EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, pub,
+                                         sizeof(pub), &len) &&
+        i2d_PUBKEY(key, &buf) <= 0 &&
+        (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) != NULL &&
+        EVP_PKEY_encapsulate_init(ctx, NULL) <= 0 &&
+        EVP_PKEY_decapsulate_init(ctx, NULL) <= 0;
+    ERR_clear_error();
+    EVP_PKEY_CTX_free(ctx);
+    OPENSSL_free(buf);
+    return testresult;
+}
+
+/* Server side of a TLS 1.3 key share as done by libssl: a key created by
+ * parameter generation for the group gets the client's encoded public key
+ * and is encapsulated to; "key" must decapsulate to the same secret */
+static int test_oqs_kem_keyshare(const char *kemalg_name, EVP_PKEY *key) {
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *peer = NULL;
+    unsigned char *share = NULL, *out = NULL;
+    unsigned char *secenc = NULL, *secdec = NULL;
+    size_t sharelen, outlen, seclen;
+    int testresult;
+
+    testresult =
+        (sharelen = EVP_PKEY_get1_encoded_public_key(key, &share)) > 0 &&
+        (ctx = EVP_PKEY_CTX_new_from_name(libctx, kemalg_name, NULL)) !=
+            NULL &&
+        EVP_PKEY_paramgen_init(ctx) > 0 &&
+        EVP_PKEY_CTX_set_group_name(ctx, kemalg_name) > 0 &&
+        EVP_PKEY_paramgen(ctx, &peer) > 0 && test_oqs_kem_empty_key(peer) &&
+        EVP_PKEY_set1_encoded_public_key(peer, share, sharelen) > 0;
+    if (!testresult)
+        goto err;
+    EVP_PKEY_CTX_free(ctx);
+    ctx = NULL;
+
+    testresult &=
+        (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, peer, NULL)) != NULL &&
+        EVP_PKEY_encapsulate_init(ctx, NULL) &&
+        EVP_PKEY_encapsulate(ctx, NULL, &outlen, NULL, &seclen) &&
+        (out = OPENSSL_malloc(outlen)) != NULL &&
+        (secenc = OPENSSL_malloc(seclen)) != NULL &&
+        (secdec = OPENSSL_zalloc(seclen)) != NULL &&
+        EVP_PKEY_encapsulate(ctx, out, &outlen, secenc, &seclen);
+    if (!testresult)
+        goto err;
+    EVP_PKEY_CTX_free(ctx);
+    ctx = NULL;
+
+    testresult &=
+        (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) != NULL &&
+        EVP_PKEY_decapsulate_init(ctx, NULL) &&
+        EVP_PKEY_decapsulate(ctx, secdec, &seclen, out, outlen) &&
+        memcmp(secenc, secdec, seclen) == 0;
+
+err:
+    EVP_PKEY_free(peer);
+    EVP_PKEY_CTX_free(ctx);
+    OPENSSL_free(share);
+    OPENSSL_free(out);
+    OPENSSL_free(secenc);
+    OPENSSL_free(secdec);
+    return testresult;
+}
+
+/* Parameter generation without a TLS group name must return a complete key,
+ * and key generation from a parameter generation template, with or without
+ * group name, must return a key that decapsulates what is encapsulated to
+ * its encoded public key */
+static int test_oqs_kem_template(const char *kemalg_name) {
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *templ = NULL, *key = NULL;
+    unsigned char *share = NULL;
+    int with_group, testresult = 1;
+
+    for (with_group = 0; with_group < 2 && testresult; with_group++) {
+        testresult =
+            (ctx = EVP_PKEY_CTX_new_from_name(libctx, kemalg_name, NULL)) !=
+                NULL &&
+            EVP_PKEY_paramgen_init(ctx) > 0 &&
+            (!with_group ||
+             EVP_PKEY_CTX_set_group_name(ctx, kemalg_name) > 0) &&
+            EVP_PKEY_paramgen(ctx, &templ) > 0 &&
+            (with_group ||
+             EVP_PKEY_get1_encoded_public_key(templ, &share) > 0);
+        EVP_PKEY_CTX_free(ctx);
+        ctx = NULL;
+
+        testresult &=
+            (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, templ, NULL)) != NULL &&
+            EVP_PKEY_keygen_init(ctx) > 0 && EVP_PKEY_keygen(ctx, &key) > 0 &&
+            test_oqs_kem_keyshare(kemalg_name, key);
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(templ);
+        EVP_PKEY_free(key);
+        OPENSSL_free(share);
+        ctx = NULL;
+        templ = key = NULL;
+        share = NULL;
+    }
+    return testresult;
+}
+
+/* FIPS 203 input checks: an encapsulation key holding a coefficient >= q
+ * must fail the public check and be refused for encapsulation, a
+ * decapsulation key with a wrong H(ek) must fail the private check */
+static int test_oqs_mlkem_invalid_keys(const char *kemalg_name,
+                                       EVP_PKEY *key) {
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *bad = NULL;
+    unsigned char *pub = NULL, *priv = NULL;
+    size_t publen = 0, privlen = 0;
+    int testresult;
+
+    testresult =
+        EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, NULL, 0,
+                                        &publen) &&
+        EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PRIV_KEY, NULL,
+                                        0, &privlen) &&
+        (pub = OPENSSL_malloc(publen)) != NULL &&
+        (priv = OPENSSL_malloc(privlen)) != NULL &&
+        EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, pub,
+                                        publen, &publen) &&
+        EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PRIV_KEY, priv,
+                                        privlen, &privlen);
+    if (!testresult)
+        goto err;
+
+    // first coefficient 4095
+    pub[0] = 0xff;
+    pub[1] |= 0x0f;
+    testresult &=
+        (bad = key_from_octets(libctx, kemalg_name, pub, publen, NULL, 0)) !=
+            NULL &&
+        (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, bad, NULL)) != NULL &&
+        EVP_PKEY_public_check(ctx) != 1 &&
+        EVP_PKEY_encapsulate_init(ctx, NULL) <= 0;
+    ERR_clear_error();
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(bad);
+    ctx = NULL;
+    bad = NULL;
+    if (!testresult)
+        goto err;
+
+    // H(ek) precedes the final 32 bytes of the decapsulation key
+    testresult &= EVP_PKEY_get_octet_string_param(
+        key, OSSL_PKEY_PARAM_PUB_KEY, pub, publen, &publen);
+    priv[privlen - 64] ^= 0x01;
+    testresult &=
+        (bad = key_from_octets(libctx, kemalg_name, pub, publen, priv,
+                               privlen)) != NULL &&
+        (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, bad, NULL)) != NULL &&
+        EVP_PKEY_private_check(ctx) != 1 && EVP_PKEY_check(ctx) != 1;
+    ERR_clear_error();
+
+err:
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(bad);
+    OPENSSL_free(pub);
+    OPENSSL_clear_free(priv, privlen);
+    return testresult;
+}
+
 static int test_oqs_kems(const char *kemalg_name) {
     EVP_MD_CTX *mdctx = NULL;
     EVP_PKEY_CTX *ctx = NULL;
@@ -41,6 +217,9 @@ static int test_oqs_kems(const char *kemalg_name) {
 
         testresult &=
             (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) != NULL &&
+            EVP_PKEY_public_check(ctx) == 1 &&
+            EVP_PKEY_private_check(ctx) == 1 &&
+            EVP_PKEY_pairwise_check(ctx) == 1 && EVP_PKEY_check(ctx) == 1 &&
             EVP_PKEY_encapsulate_init(ctx, NULL) &&
             EVP_PKEY_encapsulate(ctx, NULL, &outlen, NULL, &seclen) &&
             (out = OPENSSL_malloc(outlen)) != NULL &&
@@ -51,7 +230,12 @@ static int test_oqs_kems(const char *kemalg_name) {
             EVP_PKEY_encapsulate(ctx, out, &outlen, secenc, &seclen) &&
             EVP_PKEY_decapsulate_init(ctx, NULL) &&
             EVP_PKEY_decapsulate(ctx, secdec, &seclen, out, outlen) &&
-            memcmp(secenc, secdec, seclen) == 0;
+            memcmp(secenc, secdec, seclen) == 0 &&
+            test_oqs_kem_keyshare(kemalg_name, key) &&
+            test_oqs_kem_template(kemalg_name);
+        // pure ML-KEM only; hybrid keys prefix the classic key length
+        if (!strncmp(kemalg_name, "mlkem", 5) && !strchr(kemalg_name, '_'))
+            testresult &= test_oqs_mlkem_invalid_keys(kemalg_name, key);
         if (!testresult)
             goto err;
 
@@ -1,7 +1,9 @@
 // SPDX-License-Identifier: Apache-2.0 AND MIT
 
+#include <openssl/core_names.h>
 #include <openssl/evp.h>
 #include <openssl/provider.h>
+#include <string.h>
 
 #include "oqs/oqs.h"
 #include "test_common.h"
@@ -15,10 +17,93 @@ static char *certsdir = NULL;
 static char *srpvfile = NULL;
 static char *tmpfilename = NULL;
 
+#ifdef EVP_PKEY_OP_SIGNMSG
+// message signing (OpenSSL 3.4+), streamed and one-shot
+static int test_oqs_message_signatures(const char *sigalg_name,
+                                       EVP_PKEY *key) {
+    EVP_SIGNATURE *sigalg = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    const unsigned char msg[] = "The quick brown fox jumps over the lazy dog";
+    unsigned char *sig = NULL;
+    size_t siglen = 0;
+    int testresult;
+
+    testresult =
+        (sigalg = EVP_SIGNATURE_fetch(libctx, sigalg_name, NULL)) != NULL &&
+        (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) != NULL &&
+        EVP_PKEY_sign_message_init(ctx, sigalg, NULL) == 1 &&
+        EVP_PKEY_sign_message_update(ctx, msg, 10) == 1 &&
+        EVP_PKEY_sign_message_update(ctx, msg + 10, sizeof(msg) - 10) == 1 &&
+        EVP_PKEY_sign_message_final(ctx, NULL, &siglen) == 1 &&
+        (sig = OPENSSL_malloc(siglen)) != NULL &&
+        EVP_PKEY_sign_message_final(ctx, sig, &siglen) == 1 &&
+        EVP_PKEY_verify_message_init(ctx, sigalg, NULL) == 1 &&
+        EVP_PKEY_CTX_set_signature(ctx, sig, siglen) == 1 &&
+        EVP_PKEY_verify_message_update(ctx, msg, sizeof(msg)) == 1 &&
+        EVP_PKEY_verify_message_final(ctx) == 1 &&
+        EVP_PKEY_verify_message_init(ctx, sigalg, NULL) == 1 &&
+        EVP_PKEY_verify(ctx, sig, siglen, msg, sizeof(msg)) == 1 &&
+        EVP_PKEY_sign_message_init(ctx, sigalg, NULL) == 1 &&
+        EVP_PKEY_sign(ctx, sig, &siglen, msg, sizeof(msg)) == 1 &&
+        EVP_PKEY_verify_message_init(ctx, sigalg, NULL) == 1 &&
+        EVP_PKEY_verify(ctx, sig, siglen, msg, sizeof(msg)) == 1;
+    if (testresult) {
+        sig[0] = ~sig[0];
+        testresult = EVP_PKEY_verify_message_init(ctx, sigalg, NULL) == 1 &&
+                     EVP_PKEY_verify(ctx, sig, siglen, msg, sizeof(msg)) != 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    EVP_SIGNATURE_free(sigalg);
+    OPENSSL_free(sig);
+    return testresult;
+}
+#endif
+
+/* FIPS 204: a private key whose tr is not H(pk) must fail the private
+ * key check */
+static int test_oqs_mldsa_invalid_key(const char *sigalg_name, EVP_PKEY *key) {
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *bad = NULL;
+    unsigned char *pub = NULL, *priv = NULL;
+    size_t publen = 0, privlen = 0;
+    int testresult;
+
+    testresult =
+        EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, NULL, 0,
+                                        &publen) &&
+        EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PRIV_KEY, NULL,
+                                        0, &privlen) &&
+        (pub = OPENSSL_malloc(publen)) != NULL &&
+        (priv = OPENSSL_malloc(privlen)) != NULL &&
+        EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, pub,
+                                        publen, &publen) &&
+        EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PRIV_KEY, priv,
+                                        privlen, &privlen);
+    if (!testresult)
+        goto err;
+
+    // the private key starts with rho, K and tr
+    priv[64] ^= 0x01;
+    testresult &=
+        (bad = key_from_octets(libctx, sigalg_name, pub, publen, priv,
+                               privlen)) != NULL &&
+        (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, bad, NULL)) != NULL &&
+        EVP_PKEY_private_check(ctx) != 1 && EVP_PKEY_check(ctx) != 1;
+    ERR_clear_error();
+
+err:
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(bad);
+    OPENSSL_free(pub);
+    OPENSSL_clear_free(priv, privlen);
+    return testresult;
+}
+
 // sign-and-hash must work with and without providing a digest algorithm
 static int test_oqs_signatures(const char *sigalg_name) {
     EVP_MD_CTX *mdctx = NULL;
-    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY_CTX *ctx = NULL, *chkctx = NULL;
     EVP_PKEY *key = NULL;
     const char msg[] = "The quick brown fox jumps over... you know what";
     unsigned char *sig;
@@ -38,6 +123,10 @@ static int test_oqs_signatures(const char *sigalg_name) {
             (ctx = EVP_PKEY_CTX_new_from_name(libctx, sigalg_name, NULL)) !=
                 NULL &&
             EVP_PKEY_keygen_init(ctx) && EVP_PKEY_generate(ctx, &key) &&
+            (chkctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) !=
+                NULL &&
+            EVP_PKEY_check(chkctx) == 1 && EVP_PKEY_public_check(chkctx) == 1 &&
+            EVP_PKEY_private_check(chkctx) == 1 &&
             (mdctx = EVP_MD_CTX_new()) != NULL &&
             EVP_DigestSignInit_ex(mdctx, NULL, "SHA512", libctx, NULL, key,
                                   NULL) &&
@@ -54,11 +143,18 @@ static int test_oqs_signatures(const char *sigalg_name) {
                                               NULL, key, NULL) &&
                       EVP_DigestVerifyUpdate(mdctx, msg, sizeof(msg)) &&
                       !EVP_DigestVerifyFinal(mdctx, sig, siglen);
+#ifdef EVP_PKEY_OP_SIGNMSG
+        testresult &= test_oqs_message_signatures(sigalg_name, key);
+#endif
+        // pure ML-DSA only; composite keys are encoded differently
+        if (!strncmp(sigalg_name, "mldsa", 5) && !strchr(sigalg_name, '_'))
+            testresult &= test_oqs_mldsa_invalid_key(sigalg_name, key);
     }
 
     EVP_MD_CTX_free(mdctx);
     EVP_PKEY_free(key);
     EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_CTX_free(chkctx);
     OPENSSL_free(sig);
     mdctx = NULL;
     key = NULL;
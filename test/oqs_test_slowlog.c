@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Runs key generation, signing and verification resp. encapsulation and
+ * decapsulation, encoding and decoding of quantum-safe keys with the slow
+ * operation log recording every operation and checks the ring read via the
+ * provider parameters: all operation types are recorded, entries come oldest
+ * first with consecutive sequence numbers and the ring does not grow beyond
+ * its configured size.
+ *
+ * Environment:
+ *   OQS_SLOW_OP_THRESHOLD_US  must be set to a small positive value, see
+ *                             CMakeLists.txt
+ *   OQS_SLOW_OP_LOG_SIZE      ring size (default 128)
+ *   OQS_SLOWLOG_ALGS          colon-separated key algorithms
+ *                             (default mldsa44:p256_mldsa44:mlkem768:
+ *                             p256_mlkem768)
+ */
+
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/provider.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oqs_prov.h"
+#include "test_common.h"
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+
+static int run_ops(const char *alg) {
+    EVP_PKEY *key = NULL, *pub = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    unsigned char msg[32] = {0}, *out = NULL, *secret = NULL, *der = NULL;
+    const unsigned char *derp;
+    size_t outlen = 0, secretlen = 0;
+    int derlen, ret = 0;
+
+    if ((key = EVP_PKEY_Q_keygen(libctx, NULL, alg)) == NULL ||
+        (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) == NULL)
+        goto err;
+    if (EVP_PKEY_can_sign(key)) {
+        if (EVP_PKEY_sign_init(ctx) <= 0 ||
+            EVP_PKEY_sign(ctx, NULL, &outlen, msg, sizeof(msg)) <= 0 ||
+            (out = OPENSSL_malloc(outlen)) == NULL ||
+            EVP_PKEY_sign(ctx, out, &outlen, msg, sizeof(msg)) <= 0 ||
+            EVP_PKEY_verify_init(ctx) <= 0 ||
+            EVP_PKEY_verify(ctx, out, outlen, msg, sizeof(msg)) != 1)
+            goto err;
+    } else {
+        if (EVP_PKEY_encapsulate_init(ctx, NULL) <= 0 ||
+            EVP_PKEY_encapsulate(ctx, NULL, &outlen, NULL, &secretlen) <= 0 ||
+            (out = OPENSSL_malloc(outlen)) == NULL ||
+            (secret = OPENSSL_malloc(secretlen)) == NULL ||
+            EVP_PKEY_encapsulate(ctx, out, &outlen, secret, &secretlen) <= 0 ||
+            EVP_PKEY_decapsulate_init(ctx, NULL) <= 0 ||
+            EVP_PKEY_decapsulate(ctx, secret, &secretlen, out, outlen) <= 0)
+            goto err;
+    }
+    if ((derlen = i2d_PUBKEY(key, &der)) <= 0)
+        goto err;
+    derp = der;
+    if ((pub = d2i_PUBKEY_ex(NULL, &derp, derlen, libctx, NULL)) == NULL)
+        goto err;
+    ret = 1;
+
+err:
+    if (!ret) {
+        fprintf(stderr, cRED "  Operations failed for %s" cNORM "\n", alg);
+        ERR_print_errors_fp(stderr);
+    }
+    OPENSSL_free(der);
+    OPENSSL_free(out);
+    OPENSSL_free(secret);
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(pub);
+    EVP_PKEY_free(key);
+    return ret;
+}
+
+/* "log" holds "len" bytes of NUL-separated entries */
+static int has_op(const char *log, size_t len, const char *op) {
+    const char *line;
+    char opstr[16];
+
+    BIO_snprintf(opstr, sizeof(opstr), "op=%s ", op);
+    for (line = log; line < log + len; line += strlen(line) + 1)
+        if (strstr(line, opstr) != NULL)
+            return 1;
+    return 0;
+}
+
+static int check_log(OSSL_PROVIDER *prov, size_t size) {
+    static const char *ops[] = {"keygen", "sign",   "verify", "encaps",
+                                "decaps", "encode", "decode"};
+    OSSL_PARAM params[3];
+    uint64_t count = 0, seq;
+    char *log = NULL, *line, *next;
+    size_t lines = 0, i;
+    int ret = 0;
+
+    params[0] = OSSL_PARAM_construct_uint64(OQS_PROV_PARAM_SLOW_OP_COUNT,
+                                            &count);
+    params[1] =
+        OSSL_PARAM_construct_utf8_string(OQS_PROV_PARAM_SLOW_OPS, NULL, 0);
+    params[2] = OSSL_PARAM_construct_end();
+    // first call returns the size of the log; no operations in between
+    if (!OSSL_PROVIDER_get_params(prov, params) ||
+        (log = OPENSSL_zalloc(params[1].return_size + 1)) == NULL)
+        goto err;
+    params[1].data = log;
+    params[1].data_size = params[1].return_size + 1;
+    if (!OSSL_PROVIDER_get_params(prov, params))
+        goto err;
+    printf("%llu slow operations recorded, last ones:\n%s",
+           (unsigned long long)count, log);
+
+    seq = count > size ? count - size : 0;
+    for (line = log; *line != '\0'; line = next, seq++, lines++) {
+        if ((next = strchr(line, '\n')) == NULL)
+            goto err;
+        *next++ = '\0';
+        if (strncmp(line, "seq=", 4) != 0 ||
+            strtoull(line + 4, NULL, 10) != seq) {
+            fprintf(stderr, cRED "  Entry out of order: %s" cNORM "\n", line);
+            goto err;
+        }
+    }
+    if (count == 0 || lines != (count < size ? count : size)) {
+        fprintf(stderr, cRED "  %zu entries for %llu recorded" cNORM "\n",
+                lines, (unsigned long long)count);
+        goto err;
+    }
+    // with a ring large enough to hold all, every operation type shows up
+    for (i = 0; count <= size && i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (!has_op(log, params[1].return_size, ops[i])) {
+            fprintf(stderr, cRED "  No %s entry" cNORM "\n", ops[i]);
+            goto err;
+        }
+    }
+    ret = 1;
+
+err:
+    OPENSSL_free(log);
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    const char *env, *algs = "mldsa44:p256_mldsa44:mlkem768:p256_mlkem768";
+    OSSL_PROVIDER *prov = NULL;
+    char *list = NULL, *alg, *next;
+    size_t size = 128;
+    int errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+    T(getenv("OQS_SLOW_OP_THRESHOLD_US") != NULL);
+    if ((env = getenv("OQS_SLOW_OP_LOG_SIZE")) != NULL)
+        T((size = strtoul(env, NULL, 10)) > 0);
+    if ((env = getenv("OQS_SLOWLOG_ALGS")) != NULL)
+        algs = env;
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T((prov = OSSL_PROVIDER_load(libctx, modulename)) != NULL);
+
+    T((list = OPENSSL_strdup(algs)) != NULL);
+    for (alg = list; alg != NULL; alg = next) {
+        if ((next = strchr(alg, ':')) != NULL)
+            *next++ = '\0';
+        if (alg_is_enabled(alg) && !run_ops(alg))
+            errcnt++;
+    }
+    OPENSSL_free(list);
+    if (!check_log(prov, size))
+        errcnt++;
+
+    OSSL_PROVIDER_unload(prov);
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
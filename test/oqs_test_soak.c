@@ -0,0 +1,581 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Soak test: runs a randomized mix of key generation, TLS handshakes,
+ * encoding/decoding, signing/verification and encapsulation/decapsulation
+ * for a configurable time and periodically samples resident set size,
+ * OpenSSL heap and secure heap usage and throughput per operation type.
+ * Fails if from the first to the last quarter of the run any memory figure
+ * grows or any throughput drops by more than the configured threshold.
+ * Throughput is compared per algorithm (per group and signature algorithm
+ * for handshakes), weighted by the operation mix of the last quarter, so
+ * that the random mix does not show as drift. All keys and TLS contexts are
+ * set up before the run; the first sample is taken after a warm-up period
+ * and not evaluated.
+ *
+ * Environment:
+ *   OQS_SOAK_SECONDS      run time (default 60)
+ *   OQS_SOAK_SAMPLES      number of samples taken (default 12)
+ *   OQS_SOAK_SEED         seed of the operation sequence (default 1)
+ *   OQS_SOAK_ALGS         colon-separated signature and KEM algorithms
+ *                         (default: all)
+ *   OQS_SOAK_GROUPS       colon-separated TLS groups (default: all)
+ *   OQS_SOAK_MAX_GROWTH   tolerated memory growth in percent (default 10)
+ *   OQS_SOAK_MAX_SLOWDOWN tolerated throughput loss in percent (default 25,
+ *                         negative: throughput is reported, not checked)
+ *   OQS_SOAK_SECHEAP      size in bytes of the secure heap (default 0)
+ */
+
+#include <errno.h>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "test_common.h"
+#include "tlstest_helpers.h"
+
+#define MAX_ALGS 256
+#define MAX_SAMPLES 1000
+
+typedef enum { OP_KEYGEN, OP_ENDECODE, OP_USE, OP_HANDSHAKE, OP_COUNT } OP;
+static const char *op_names[OP_COUNT] = {"keygen", "endecode", "sign/kem",
+                                         "handshake"};
+
+typedef struct {
+    char *name;
+    int is_kem;
+    EVP_PKEY *key;
+    SSL_CTX *sctx, *cctx; // for sigalgs usable in TLS
+    int tls_failed;
+} SOAK_ALG;
+
+/* Operations are counted per operation type and per slot: the algorithm
+ * index, for handshakes the group and signature algorithm pair.
+ */
+typedef struct {
+    size_t rss;
+    size_t heap;
+    size_t secure;
+    size_t ops[OP_COUNT];
+    double us[OP_COUNT];
+    size_t *slot_ops; // [OP_COUNT * slotcnt]
+    double *slot_us;
+} SOAK_SAMPLE;
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+static char *certsdir = NULL;
+static const char *alg_filter = NULL;
+static const char *group_filter = NULL;
+
+static SOAK_ALG algs[MAX_ALGS];
+static int algcnt = 0;
+static char *groups[MAX_ALGS];
+static int groupcnt = 0;
+static char *tls_sigalgs[MAX_ALGS];
+static int tls_sigalgcnt = 0;
+static int slotcnt = 0;
+static SOAK_ALG rsa = {"RSA", 0, NULL, NULL, NULL, 0};
+static uint64_t rng_state = 1;
+
+// xorshift64*: the operation sequence depends on the seed only
+static uint32_t soak_rand(uint32_t range) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32) % range;
+}
+
+static size_t get_rss(void) {
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/statm", "r");
+    unsigned long size, resident = 0;
+
+    if (f == NULL)
+        return 0;
+    if (fscanf(f, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+    fclose(f);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+static EVP_PKEY *soak_keygen(const char *alg) {
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_name(libctx, alg, NULL);
+    EVP_PKEY *key = NULL;
+
+    if (ctx == NULL || EVP_PKEY_keygen_init(ctx) <= 0 ||
+        EVP_PKEY_generate(ctx, &key) <= 0)
+        key = NULL;
+    EVP_PKEY_CTX_free(ctx);
+    return key;
+}
+
+/* Replaces the pool key of |alg| by a fresh one, so that key material is
+ * continuously allocated and released.
+ */
+static int op_keygen(SOAK_ALG *alg) {
+    EVP_PKEY *key = soak_keygen(alg->name);
+
+    if (key == NULL)
+        return 0;
+    EVP_PKEY_free(alg->key);
+    alg->key = key;
+    return 1;
+}
+
+// Returns -1 if there is no encoder for the key type.
+static int op_endecode(SOAK_ALG *alg) {
+    unsigned char *privder = NULL, *pubder = NULL;
+    const unsigned char *p;
+    EVP_PKEY *priv = NULL, *pub = NULL;
+    int privlen, publen, ret = 0;
+
+    privlen = i2d_PrivateKey(alg->key, &privder);
+    publen = i2d_PUBKEY(alg->key, &pubder);
+    if (privlen <= 0 || publen <= 0) {
+        ERR_clear_error();
+        ret = -1;
+        goto end;
+    }
+    p = privder;
+    priv = d2i_AutoPrivateKey_ex(NULL, &p, privlen, libctx, NULL);
+    p = pubder;
+    pub = d2i_PUBKEY_ex(NULL, &p, publen, libctx, NULL);
+    ret = priv != NULL && pub != NULL && EVP_PKEY_eq(pub, alg->key) == 1;
+
+end:
+    EVP_PKEY_free(priv);
+    EVP_PKEY_free(pub);
+    OPENSSL_free(privder);
+    OPENSSL_free(pubder);
+    return ret;
+}
+
+static int op_sign_verify(SOAK_ALG *alg) {
+    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+    unsigned char msg[256], *sig = NULL;
+    size_t siglen = 0, msglen = 1 + soak_rand(sizeof(msg));
+    int ret;
+
+    memset(msg, (int)msglen, msglen);
+    ret = mdctx != NULL &&
+          EVP_DigestSignInit_ex(mdctx, NULL, NULL, libctx, NULL, alg->key,
+                                NULL) == 1 &&
+          EVP_DigestSign(mdctx, NULL, &siglen, msg, msglen) == 1 &&
+          (sig = OPENSSL_malloc(siglen)) != NULL &&
+          EVP_DigestSign(mdctx, sig, &siglen, msg, msglen) == 1 &&
+          EVP_DigestVerifyInit_ex(mdctx, NULL, NULL, libctx, NULL, alg->key,
+                                  NULL) == 1 &&
+          EVP_DigestVerify(mdctx, sig, siglen, msg, msglen) == 1;
+    OPENSSL_free(sig);
+    EVP_MD_CTX_free(mdctx);
+    return ret;
+}
+
+static int op_encaps_decaps(SOAK_ALG *alg) {
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_pkey(libctx, alg->key, NULL);
+    unsigned char *ct = NULL, *secenc = NULL, *secdec = NULL;
+    size_t ctlen, seclen;
+    int ret;
+
+    ret = ctx != NULL && EVP_PKEY_encapsulate_init(ctx, NULL) == 1 &&
+          EVP_PKEY_encapsulate(ctx, NULL, &ctlen, NULL, &seclen) == 1 &&
+          (ct = OPENSSL_malloc(ctlen)) != NULL &&
+          (secenc = OPENSSL_malloc(seclen)) != NULL &&
+          (secdec = OPENSSL_malloc(seclen)) != NULL &&
+          EVP_PKEY_encapsulate(ctx, ct, &ctlen, secenc, &seclen) == 1 &&
+          EVP_PKEY_decapsulate_init(ctx, NULL) == 1 &&
+          EVP_PKEY_decapsulate(ctx, secdec, &seclen, ct, ctlen) == 1 &&
+          memcmp(secenc, secdec, seclen) == 0;
+    OPENSSL_free(ct);
+    OPENSSL_clear_free(secenc, seclen);
+    OPENSSL_clear_free(secdec, seclen);
+    EVP_PKEY_CTX_free(ctx);
+    return ret;
+}
+
+static SOAK_ALG *find_alg(const char *name) {
+    int i;
+
+    for (i = 0; i < algcnt; i++)
+        if (!strcmp(algs[i].name, name))
+            return &algs[i];
+    return NULL;
+}
+
+/* Creates the server certificate and the TLS contexts of |sigalg|; failing
+ * algorithms are skipped by the handshakes.
+ */
+static void setup_tls(SOAK_ALG *sigalg) {
+    char certpath[300], privkeypath[300];
+
+    snprintf(certpath, sizeof(certpath), "%s/%s_srv.crt", certsdir,
+             sigalg->name);
+    snprintf(privkeypath, sizeof(privkeypath), "%s/%s_srv.key", certsdir,
+             sigalg->name);
+    if (!create_cert_key(libctx, sigalg->name, certpath, privkeypath) ||
+        !create_tls1_3_ctx_pair(libctx, &sigalg->sctx, &sigalg->cctx, certpath,
+                                privkeypath)) {
+        fprintf(stderr, cRED "  Cannot set up TLS with %s; skipped" cNORM "\n",
+                sigalg->name);
+        ERR_print_errors_fp(stderr);
+        sigalg->tls_failed = 1;
+    }
+}
+
+/* Handshake with a random group and a server certificate of a random TLS
+ * signature algorithm (RSA if there is none); |slot| receives the pair
+ * chosen. Returns -1 if the chosen signature algorithm cannot be used.
+ */
+static int op_handshake(int *slot) {
+    SOAK_ALG *sigalg = &rsa;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    int group, sig = 0, ret = 0;
+
+    if (groupcnt == 0)
+        return -1;
+    group = soak_rand(groupcnt);
+    if (tls_sigalgcnt > 0 &&
+        (sigalg = find_alg(tls_sigalgs[sig = soak_rand(tls_sigalgcnt)])) ==
+            NULL)
+        return -1;
+    if (sigalg->tls_failed)
+        return -1;
+    *slot = group * (tls_sigalgcnt > 0 ? tls_sigalgcnt : 1) + sig;
+    ret = create_tls_objects(sigalg->sctx, sigalg->cctx, &serverssl,
+                             &clientssl) &&
+          SSL_set1_groups_list(serverssl, groups[group]) &&
+          SSL_set1_groups_list(clientssl, groups[group]) &&
+          create_tls_connection(serverssl, clientssl, SSL_ERROR_NONE);
+    if (!ret)
+        fprintf(stderr, cRED "  Handshake failed: %s / %s" cNORM "\n",
+                groups[group], sigalg->name);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    return ret;
+}
+
+// Returns the type of the operation run, -1 if none applied, -2 on error.
+static int run_op(SOAK_SAMPLE *sample) {
+    OP op = (OP)soak_rand(OP_COUNT);
+    int slot = soak_rand(algcnt);
+    SOAK_ALG *alg = &algs[slot];
+    double start = get_time_us(), us;
+    int ret;
+
+    switch (op) {
+    case OP_KEYGEN:
+        ret = op_keygen(alg);
+        break;
+    case OP_ENDECODE:
+        ret = op_endecode(alg);
+        break;
+    case OP_USE:
+        ret = alg->is_kem ? op_encaps_decaps(alg) : op_sign_verify(alg);
+        break;
+    default:
+        ret = op_handshake(&slot);
+        break;
+    }
+    if (ret < 0)
+        return -1;
+    if (ret == 0) {
+        fprintf(stderr, cRED "  %s failed for %s" cNORM "\n", op_names[op],
+                alg->name);
+        ERR_print_errors_fp(stderr);
+        return -2;
+    }
+    us = get_time_us() - start;
+    sample->us[op] += us;
+    sample->ops[op]++;
+    sample->slot_us[op * slotcnt + slot] += us;
+    sample->slot_ops[op * slotcnt + slot]++;
+    return op;
+}
+
+static void take_sample(SOAK_SAMPLE *sample) {
+    MEM_COUNTERS counters;
+
+    mem_counting_get(&counters);
+    sample->rss = get_rss();
+    sample->heap = counters.live;
+    sample->secure =
+        CRYPTO_secure_malloc_initialized() ? CRYPTO_secure_used() : 0;
+}
+
+static void print_sample(int i, const SOAK_SAMPLE *sample) {
+    int op;
+
+    printf("%4d %10zu %10zu %8zu", i, sample->rss / 1024, sample->heap / 1024,
+           sample->secure / 1024);
+    for (op = 0; op < OP_COUNT; op++)
+        printf(" %10.1f",
+               sample->us[op] > 0 ? sample->ops[op] * 1e6 / sample->us[op]
+                                  : 0.0);
+    printf("\n");
+}
+
+/* Compares a figure of the first and the last quarter of the run; returns 0
+ * if it got worse by more than |limit| percent. A negative |limit| only
+ * reports the figure.
+ */
+static int check_drift(const char *what, double first, double last,
+                       double limit, int growth_is_bad) {
+    double change;
+
+    if (first <= 0)
+        return 1;
+    change = (last - first) * 100.0 / first;
+    if (!growth_is_bad)
+        change = -change;
+    printf("  %-22s %12.1f -> %12.1f (%+.1f%%)\n", what, first, last,
+           growth_is_bad ? change : -change);
+    if (limit >= 0 && change > limit) {
+        fprintf(stderr, cRED "  %s drifted by more than %.0f%%" cNORM "\n",
+                what, limit);
+        return 0;
+    }
+    return 1;
+}
+
+/* Sums the operations of type |op| and their time per slot over |cnt|
+ * samples from |s|.
+ */
+static void sum_slots(const SOAK_SAMPLE *s, int cnt, int op, size_t *ops,
+                      double *us) {
+    int i, slot;
+
+    for (i = 0; i < cnt; i++) {
+        for (slot = 0; slot < slotcnt; slot++) {
+            ops[slot] += s[i].slot_ops[op * slotcnt + slot];
+            us[slot] += s[i].slot_us[op * slotcnt + slot];
+        }
+    }
+}
+
+static int evaluate(const SOAK_SAMPLE *samples, int samplecnt,
+                    double max_growth, double max_slowdown) {
+    // sample 0 ends the warm-up period
+    int quarter = (samplecnt - 1) / 4 > 0 ? (samplecnt - 1) / 4 : 1;
+    double first[3] = {0}, last[3] = {0};
+    size_t *ops_first = OPENSSL_zalloc(slotcnt * sizeof(size_t));
+    size_t *ops_last = OPENSSL_zalloc(slotcnt * sizeof(size_t));
+    double *us_first = OPENSSL_zalloc(slotcnt * sizeof(double));
+    double *us_last = OPENSSL_zalloc(slotcnt * sizeof(double));
+    double expected, actual;
+    size_t count;
+    char what[64];
+    int i, op, slot, ok = 1;
+
+    if (samplecnt < 3) {
+        printf("  Too few samples to check for drift\n");
+        goto end;
+    }
+    if (ops_first == NULL || ops_last == NULL || us_first == NULL ||
+        us_last == NULL) {
+        ok = 0;
+        goto end;
+    }
+    for (i = 0; i < quarter; i++) {
+        const SOAK_SAMPLE *f = &samples[1 + i];
+        const SOAK_SAMPLE *l = &samples[samplecnt - quarter + i];
+
+        first[0] += (double)f->rss / quarter;
+        first[1] += (double)f->heap / quarter;
+        first[2] += (double)f->secure / quarter;
+        last[0] += (double)l->rss / quarter;
+        last[1] += (double)l->heap / quarter;
+        last[2] += (double)l->secure / quarter;
+    }
+
+    printf("Drift from first to last quarter:\n");
+    ok &= check_drift("RSS (bytes)", first[0], last[0], max_growth, 1);
+    ok &= check_drift("heap (bytes)", first[1], last[1], max_growth, 1);
+    ok &= check_drift("secure heap (bytes)", first[2], last[2], max_growth, 1);
+    for (op = 0; op < OP_COUNT; op++) {
+        memset(ops_first, 0, slotcnt * sizeof(size_t));
+        memset(ops_last, 0, slotcnt * sizeof(size_t));
+        memset(us_first, 0, slotcnt * sizeof(double));
+        memset(us_last, 0, slotcnt * sizeof(double));
+        sum_slots(&samples[1], quarter, op, ops_first, us_first);
+        sum_slots(&samples[samplecnt - quarter], quarter, op, ops_last,
+                  us_last);
+        // the last quarter's operations at the first quarter's speed
+        expected = actual = 0;
+        count = 0;
+        for (slot = 0; slot < slotcnt; slot++) {
+            if (ops_first[slot] == 0 || ops_last[slot] == 0)
+                continue;
+            expected += ops_last[slot] * us_first[slot] / ops_first[slot];
+            actual += us_last[slot];
+            count += ops_last[slot];
+        }
+        // too few operations make for too noisy a figure
+        if (count < 20)
+            continue;
+        snprintf(what, sizeof(what), "%s (ops/s)", op_names[op]);
+        ok &= check_drift(what, count * 1e6 / expected, count * 1e6 / actual,
+                          max_slowdown, 0);
+    }
+
+end:
+    OPENSSL_free(ops_first);
+    OPENSSL_free(ops_last);
+    OPENSSL_free(us_first);
+    OPENSSL_free(us_last);
+    return ok;
+}
+
+static int add_alg(const char *name, int is_kem) {
+    if (algcnt == MAX_ALGS || !alg_is_enabled(name) ||
+        !in_list(alg_filter, name) || find_alg(name) != NULL)
+        return 1;
+    algs[algcnt].name = OPENSSL_strdup(name);
+    algs[algcnt].is_kem = is_kem;
+    if (algs[algcnt].name == NULL ||
+        (algs[algcnt].key = soak_keygen(name)) == NULL) {
+        fprintf(stderr, cRED "  Key generation failed for %s" cNORM "\n",
+                name);
+        ERR_print_errors_fp(stderr);
+        OPENSSL_free(algs[algcnt].name);
+        return 0;
+    }
+    algcnt++;
+    return 1;
+}
+
+/* "arg" points to 1 for KEMs, 0 for signature algorithms */
+static int add_provider_alg(const char *name, void *arg) {
+    return add_alg(name, *(int *)arg);
+}
+
+static int add_group(const char *name, void *arg) {
+    if (groupcnt < MAX_ALGS && alg_is_enabled(name) &&
+        in_list(group_filter, name))
+        groups[groupcnt++] = OPENSSL_strdup(name);
+    return 1;
+}
+
+static int add_tls_sigalg(const char *name, void *arg) {
+    // only algorithms in the pool, which honours OQS_SOAK_ALGS
+    if (tls_sigalgcnt < MAX_ALGS && find_alg(name) != NULL)
+        tls_sigalgs[tls_sigalgcnt++] = OPENSSL_strdup(name);
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    static SOAK_SAMPLE samples[MAX_SAMPLES];
+    static int is_sig_kem[2] = {0, 1};
+    SOAK_ALG *sigalg;
+    double seconds, interval, max_growth, max_slowdown, start, next;
+    const char *env;
+    int i, samplecnt, errcnt = 0, test = 0;
+
+    // must precede any allocation made by OpenSSL
+    T(mem_counting_init());
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 4);
+    modulename = argv[1];
+    configfile = argv[2];
+    certsdir = argv[3];
+
+    seconds = getenv_double("OQS_SOAK_SECONDS", 60);
+    samplecnt = (int)getenv_double("OQS_SOAK_SAMPLES", 12);
+    rng_state = (uint64_t)getenv_double("OQS_SOAK_SEED", 1) | 1;
+    max_growth = getenv_double("OQS_SOAK_MAX_GROWTH", 10);
+    max_slowdown = getenv_double("OQS_SOAK_MAX_SLOWDOWN", 25);
+    alg_filter = getenv("OQS_SOAK_ALGS");
+    group_filter = getenv("OQS_SOAK_GROUPS");
+    T(seconds > 0 && samplecnt > 0 && samplecnt <= MAX_SAMPLES);
+    if ((env = getenv("OQS_SOAK_SECHEAP")) != NULL && atol(env) > 0)
+        T(CRYPTO_secure_malloc_init(atol(env), 32));
+    if (mkdir(certsdir, 0700) && errno != EEXIST) {
+        fprintf(stderr, "Couldn't create certsdir %s: Err = %d\n", certsdir,
+                errno);
+        return 1;
+    }
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T(OSSL_PROVIDER_available(libctx, "default"));
+    errcnt += for_each_oqs_alg(libctx, OSSL_OP_SIGNATURE, add_provider_alg,
+                               &is_sig_kem[0]) +
+              for_each_oqs_alg(libctx, OSSL_OP_KEM, add_provider_alg,
+                               &is_sig_kem[1]) +
+              for_each_oqs_tls_alg(libctx, "TLS-GROUP", add_group, NULL) +
+              for_each_oqs_tls_alg(libctx, "TLS-SIGALG", add_tls_sigalg, NULL);
+    T(algcnt > 0);
+
+    // certificates and TLS contexts must not be created while sampling
+    if (tls_sigalgcnt == 0)
+        setup_tls(&rsa);
+    for (i = 0; i < tls_sigalgcnt; i++)
+        if ((sigalg = find_alg(tls_sigalgs[i])) != NULL)
+            setup_tls(sigalg);
+    slotcnt = groupcnt * (tls_sigalgcnt > 0 ? tls_sigalgcnt : 1);
+    if (slotcnt < algcnt)
+        slotcnt = algcnt;
+    for (i = 0; i < samplecnt; i++) {
+        T((samples[i].slot_ops =
+               OPENSSL_zalloc(OP_COUNT * slotcnt * sizeof(size_t))) != NULL);
+        T((samples[i].slot_us =
+               OPENSSL_zalloc(OP_COUNT * slotcnt * sizeof(double))) != NULL);
+    }
+
+    printf("Soaking %d algorithms, %d groups, %d TLS sigalgs for %.0f s\n",
+           algcnt, groupcnt, tls_sigalgcnt, seconds);
+    printf("%4s %10s %10s %8s", "#", "RSS KB", "heap KB", "sec KB");
+    for (i = 0; i < OP_COUNT; i++)
+        printf(" %10s", op_names[i]);
+    printf("\n");
+
+    interval = seconds * 1e6 / samplecnt;
+    start = get_time_us();
+    for (i = 0; i < samplecnt && errcnt == 0; i++) {
+        next = start + (i + 1) * interval;
+        while (get_time_us() < next)
+            if (run_op(&samples[i]) == -2)
+                errcnt++;
+        take_sample(&samples[i]);
+        print_sample(i, &samples[i]);
+    }
+
+    if (errcnt == 0 &&
+        !evaluate(samples, samplecnt, max_growth, max_slowdown))
+        errcnt++;
+
+    for (i = 0; i < samplecnt; i++) {
+        OPENSSL_free(samples[i].slot_ops);
+        OPENSSL_free(samples[i].slot_us);
+    }
+    for (i = 0; i < algcnt; i++) {
+        EVP_PKEY_free(algs[i].key);
+        SSL_CTX_free(algs[i].sctx);
+        SSL_CTX_free(algs[i].cctx);
+        OPENSSL_free(algs[i].name);
+    }
+    SSL_CTX_free(rsa.sctx);
+    SSL_CTX_free(rsa.cctx);
+    for (i = 0; i < groupcnt; i++)
+        OPENSSL_free(groups[i]);
+    for (i = 0; i < tls_sigalgcnt; i++)
+        OPENSSL_free(tls_sigalgs[i]);
+    OSSL_LIB_CTX_free(libctx);
+    if (CRYPTO_secure_malloc_initialized())
+        CRYPTO_secure_malloc_done();
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: Apache-2.0 AND MIT
+
+/* Checks the sizes published with the TLS-GROUP and TLS-SIGALG capabilities
+ * against real keys: key shares and ciphertexts of every group must match
+ * exactly, public keys and signatures of every signature algorithm must not
+ * exceed the published lengths. Then checks that oqs_tls_smallest_algs()
+ * picks algorithms meeting the security floor of which no cheaper one
+ * exists.
+ */
+
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/provider.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_common.h"
+#include "tls_sizes.h"
+
+#define MAX_ALGS 256
+#define NCERTS 2
+
+static OSSL_LIB_CTX *libctx = NULL;
+static char *modulename = NULL;
+static char *configfile = NULL;
+
+typedef struct {
+    OQS_TLS_ALG algs[MAX_ALGS];
+    size_t n;
+    const char *name_key, *secbits_key, *publen_key, *outlen_key;
+} ALG_LIST;
+
+static int collect(const OSSL_PARAM params[], void *arg) {
+    ALG_LIST *list = arg;
+    OQS_TLS_ALG *alg;
+    const OSSL_PARAM *p;
+    const char *name = NULL;
+    unsigned int val;
+
+    if (list->n == MAX_ALGS)
+        return 0;
+    alg = &list->algs[list->n++];
+    memset(alg, 0, sizeof(*alg));
+    if ((p = OSSL_PARAM_locate_const(params, list->name_key)) == NULL ||
+        !OSSL_PARAM_get_utf8_string_ptr(p, &name))
+        return 0;
+    OPENSSL_strlcpy(alg->name, name, sizeof(alg->name));
+    if ((p = OSSL_PARAM_locate_const(params, list->secbits_key)) != NULL &&
+        OSSL_PARAM_get_uint(p, &val))
+        alg->secbits = val;
+    if ((p = OSSL_PARAM_locate_const(params, list->publen_key)) != NULL &&
+        OSSL_PARAM_get_uint(p, &val))
+        alg->publen = val;
+    if ((p = OSSL_PARAM_locate_const(params, list->outlen_key)) != NULL &&
+        OSSL_PARAM_get_uint(p, &val))
+        alg->outlen = val;
+    return 1;
+}
+
+static int check_group(const OQS_TLS_ALG *alg) {
+    EVP_PKEY *key = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    unsigned char *pub = NULL, *ct = NULL, *secret = NULL;
+    size_t publen = 0, ctlen = 0, secretlen = 0;
+    int ret = 0;
+
+    if ((key = EVP_PKEY_Q_keygen(libctx, NULL, alg->name)) == NULL ||
+        (publen = EVP_PKEY_get1_encoded_public_key(key, &pub)) == 0 ||
+        (ctx = EVP_PKEY_CTX_new_from_pkey(libctx, key, NULL)) == NULL ||
+        EVP_PKEY_encapsulate_init(ctx, NULL) <= 0 ||
+        EVP_PKEY_encapsulate(ctx, NULL, &ctlen, NULL, &secretlen) <= 0 ||
+        (ct = OPENSSL_malloc(ctlen)) == NULL ||
+        (secret = OPENSSL_malloc(secretlen)) == NULL ||
+        EVP_PKEY_encapsulate(ctx, ct, &ctlen, secret, &secretlen) <= 0) {
+        fprintf(stderr, cRED "  Operations failed for %s" cNORM "\n",
+                alg->name);
+        ERR_print_errors_fp(stderr);
+        goto err;
+    }
+    ret = publen == alg->publen && ctlen == alg->outlen;
+    printf("  %-28s %5u %8zu %8zu\n", alg->name, alg->secbits, publen, ctlen);
+    if (!ret)
+        fprintf(stderr,
+                cRED "  %s: published key share %zu, ciphertext %zu" cNORM
+                     "\n",
+                alg->name, alg->publen, alg->outlen);
+
+err:
+    OPENSSL_free(pub);
+    OPENSSL_free(ct);
+    OPENSSL_free(secret);
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    return ret;
+}
+
+static int check_sigalg(const OQS_TLS_ALG *alg) {
+    const unsigned char msg[32] = {0};
+    EVP_PKEY *key = NULL;
+    EVP_MD_CTX *mdctx = NULL;
+    unsigned char *sig = NULL;
+    size_t publen = 0, siglen = 0;
+    int ret = 0;
+
+    if ((key = EVP_PKEY_Q_keygen(libctx, NULL, alg->name)) == NULL ||
+        !EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, NULL,
+                                         0, &publen) ||
+        (mdctx = EVP_MD_CTX_new()) == NULL ||
+        !EVP_DigestSignInit_ex(mdctx, NULL, NULL, libctx, NULL, key, NULL) ||
+        !EVP_DigestSign(mdctx, NULL, &siglen, msg, sizeof(msg)) ||
+        (sig = OPENSSL_malloc(siglen)) == NULL ||
+        !EVP_DigestSign(mdctx, sig, &siglen, msg, sizeof(msg))) {
+        fprintf(stderr, cRED "  Operations failed for %s" cNORM "\n",
+                alg->name);
+        ERR_print_errors_fp(stderr);
+        goto err;
+    }
+    ret = publen > 0 && publen <= alg->publen && siglen <= alg->outlen;
+    printf("  %-28s %5u %8zu %8zu\n", alg->name, alg->secbits, publen, siglen);
+    if (!ret)
+        fprintf(stderr,
+                cRED "  %s: published public key %zu, signature %zu" cNORM
+                     "\n",
+                alg->name, alg->publen, alg->outlen);
+
+err:
+    OPENSSL_free(sig);
+    EVP_MD_CTX_free(mdctx);
+    EVP_PKEY_free(key);
+    return ret;
+}
+
+/* "chosen" must meet the floor and no entry of "list" with known sizes
+ * meeting it may cost less */
+static int check_choice(const ALG_LIST *list, const OQS_TLS_ALG *chosen,
+                        unsigned int floor, int ncerts) {
+    size_t i, cost;
+
+    if (chosen->secbits < floor)
+        return 0;
+    for (i = 0; i < list->n; i++) {
+        const OQS_TLS_ALG *alg = &list->algs[i];
+
+        if (alg->secbits < floor || alg->publen == 0 || alg->outlen == 0)
+            continue;
+        if (ncerts < 0)
+            cost = alg->publen + alg->outlen;
+        else
+            cost = ncerts * (alg->publen + alg->outlen) + alg->outlen;
+        if (cost < chosen->cost) {
+            fprintf(stderr, cRED "  %s (%zu bytes) cheaper than %s" cNORM "\n",
+                    alg->name, cost, chosen->name);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    static const unsigned int floors[] = {128, 192, 256};
+    static ALG_LIST groups, sigalgs;
+    OSSL_PROVIDER *prov = NULL;
+    OQS_TLS_ALG sigalg, group;
+    size_t i;
+    int errcnt = 0, test = 0;
+
+    T((libctx = OSSL_LIB_CTX_new()) != NULL);
+    T(argc == 3);
+    modulename = argv[1];
+    configfile = argv[2];
+
+    load_oqs_provider(libctx, modulename, configfile);
+    T((prov = OSSL_PROVIDER_load(libctx, modulename)) != NULL);
+
+    groups.name_key = OSSL_CAPABILITY_TLS_GROUP_NAME;
+    groups.secbits_key = OSSL_CAPABILITY_TLS_GROUP_SECURITY_BITS;
+    groups.publen_key = OQS_TLS_SIZES_GROUP_KEYSHARE_LEN;
+    groups.outlen_key = OQS_TLS_SIZES_GROUP_CIPHERTEXT_LEN;
+    T(OSSL_PROVIDER_get_capabilities(prov, "TLS-GROUP", collect, &groups));
+    printf("%-30s %5s %8s %8s\n", "group", "bits", "share", "ct");
+    for (i = 0; i < groups.n; i++)
+        if (alg_is_enabled(groups.algs[i].name) &&
+            !check_group(&groups.algs[i]))
+            errcnt++;
+
+#ifdef OSSL_CAPABILITY_TLS_SIGALG_NAME
+    sigalgs.name_key = OSSL_CAPABILITY_TLS_SIGALG_NAME;
+    sigalgs.secbits_key = OSSL_CAPABILITY_TLS_SIGALG_SECURITY_BITS;
+    sigalgs.publen_key = OQS_TLS_SIZES_SIGALG_PUBKEY_LEN;
+    sigalgs.outlen_key = OQS_TLS_SIZES_SIGALG_SIG_LEN;
+    T(OSSL_PROVIDER_get_capabilities(prov, "TLS-SIGALG", collect, &sigalgs));
+    printf("%-30s %5s %8s %8s\n", "sigalg", "bits", "pubkey", "sig");
+    for (i = 0; i < sigalgs.n; i++)
+        if (alg_is_enabled(sigalgs.algs[i].name) &&
+            !check_sigalg(&sigalgs.algs[i]))
+            errcnt++;
+#endif
+
+    for (i = 0; i < sizeof(floors) / sizeof(floors[0]); i++) {
+        if (!oqs_tls_smallest_algs(prov, floors[i], NCERTS, &sigalg, &group)) {
+            printf("%u bits: no complete choice\n", floors[i]);
+            continue;
+        }
+        printf("%u bits: %s (%zu bytes in %d certificates) with %s (%zu "
+               "bytes)\n",
+               floors[i], sigalg.name, sigalg.cost, NCERTS, group.name,
+               group.cost);
+        if (!check_choice(&groups, &group, floors[i], -1) ||
+            !check_choice(&sigalgs, &sigalg, floors[i], NCERTS))
+            errcnt++;
+    }
+    // every build has some group of at least 128 bits
+    if (!oqs_tls_smallest_algs(prov, floors[0], NCERTS, NULL, &group))
+        errcnt++;
+
+    OSSL_PROVIDER_unload(prov);
+    OSSL_LIB_CTX_free(libctx);
+    TEST_ASSERT(errcnt == 0)
+    return !test;
+}
@@ -2,7 +2,11 @@
 
 #include "test_common.h"
 
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 void hexdump(const void *ptr, size_t len) {
     const unsigned char *p = ptr;
@@ -34,12 +38,239 @@ int alg_is_enabled(const char *algname) {
     return strstr(algname, alglist) == NULL;
 }
 
+double get_time_us(void) {
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+double get_cpu_time_us(void) {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+#endif
+    return get_time_us();
+}
+
+double getenv_double(const char *name, double dflt) {
+    const char *val = getenv(name);
+
+    return val != NULL ? strtod(val, NULL) : dflt;
+}
+
+int in_list(const char *list, const char *name) {
+    size_t len = strlen(name);
+    const char *p;
+
+    if (list == NULL)
+        return 1;
+    for (p = list; p != NULL; p = strchr(p, ':') ? strchr(p, ':') + 1 : NULL)
+        if (!strncmp(p, name, len) && (p[len] == ':' || p[len] == '\0'))
+            return 1;
+    return 0;
+}
+
+int for_each_in_list(const char *list, int (*fn)(const char *name, void *arg),
+                     void *arg) {
+    char *copy, *name, *next;
+    int errcnt = 0;
+
+    if ((copy = OPENSSL_strdup(list)) == NULL)
+        return 1;
+    for (name = copy; name != NULL; name = next) {
+        if ((next = strchr(name, ':')) != NULL)
+            *next++ = '\0';
+        if (*name != '\0' && alg_is_enabled(name) && !fn(name, arg))
+            errcnt++;
+    }
+    OPENSSL_free(copy);
+    return errcnt;
+}
+
+typedef struct {
+    int operation_id;
+    const char *capability;
+    int (*fn)(const char *name, void *arg);
+    void *arg;
+    int errcnt;
+} ALG_ITER;
+
+static int for_each_tls_cb(const OSSL_PARAM params[], void *data) {
+    ALG_ITER *it = data;
+    const char *key = OSSL_CAPABILITY_TLS_GROUP_NAME;
+    const OSSL_PARAM *p;
+
+#ifdef OSSL_CAPABILITY_TLS_SIGALG_NAME
+    if (!strcmp(it->capability, "TLS-SIGALG"))
+        key = OSSL_CAPABILITY_TLS_SIGALG_NAME;
+#endif
+    p = OSSL_PARAM_locate_const(params, key);
+    if (p == NULL || p->data_type != OSSL_PARAM_UTF8_STRING)
+        return 0;
+    if (!it->fn(p->data, it->arg))
+        it->errcnt++;
+    return 1;
+}
+
+static int for_each_provider_cb(OSSL_PROVIDER *provider, void *data) {
+    ALG_ITER *it = data;
+    const OSSL_ALGORITHM *algs;
+    int no_cache = 0;
+
+    if (strcmp(OSSL_PROVIDER_get0_name(provider), PROVIDER_NAME_OQS))
+        return 1;
+    if (it->capability != NULL) {
+        if (!OSSL_PROVIDER_get_capabilities(provider, it->capability,
+                                            for_each_tls_cb, it))
+            it->errcnt++;
+        return 1;
+    }
+    algs = OSSL_PROVIDER_query_operation(provider, it->operation_id,
+                                         &no_cache);
+    for (; algs != NULL && algs->algorithm_names != NULL; algs++)
+        if (!it->fn(algs->algorithm_names, it->arg))
+            it->errcnt++;
+    OSSL_PROVIDER_unquery_operation(provider, it->operation_id, algs);
+    return 1;
+}
+
+int for_each_oqs_alg(OSSL_LIB_CTX *libctx, int operation_id,
+                     int (*fn)(const char *name, void *arg), void *arg) {
+    ALG_ITER it = {operation_id, NULL, fn, arg, 0};
+
+    if (!OSSL_PROVIDER_do_all(libctx, for_each_provider_cb, &it))
+        it.errcnt++;
+    return it.errcnt;
+}
+
+int for_each_oqs_tls_alg(OSSL_LIB_CTX *libctx, const char *capability,
+                         int (*fn)(const char *name, void *arg), void *arg) {
+    ALG_ITER it = {0, capability, fn, arg, 0};
+
+#ifndef OSSL_CAPABILITY_TLS_SIGALG_NAME
+    // no signature algorithm capability before OpenSSL 3.2
+    if (!strcmp(capability, "TLS-SIGALG"))
+        return 0;
+#endif
+    if (!OSSL_PROVIDER_do_all(libctx, for_each_provider_cb, &it))
+        it.errcnt++;
+    return it.errcnt;
+}
+
+double bench_run(int (*op)(void *arg), void *arg, double min_us) {
+    double start = get_time_us(), now;
+    long count = 0;
+
+    do {
+        if (!op(arg))
+            return -1;
+        count++;
+    } while ((now = get_time_us()) - start < min_us || count < 3);
+    return (now - start) / count;
+}
+
+/* every counted block is prefixed with its size and whether the provider
+ * allocated it; the latter is told by the source file OpenSSL passes in
+ */
+#define MEM_HDR_LEN 16
+static MEM_COUNTERS mem_counters;
+
+static int mem_from_provider(const char *file) {
+    return file != NULL && strstr(file, "oqsprov") != NULL;
+}
+
+static void mem_account(unsigned char *hdr, size_t num, int prov) {
+    *(size_t *)hdr = num;
+    hdr[sizeof(size_t)] = (unsigned char)prov;
+    mem_counters.live += num;
+    if (prov)
+        mem_counters.live_prov += num;
+    if (mem_counters.live > mem_counters.peak)
+        mem_counters.peak = mem_counters.live;
+    mem_counters.allocs++;
+}
+
+static void mem_unaccount(const unsigned char *hdr) {
+    mem_counters.live -= *(const size_t *)hdr;
+    if (hdr[sizeof(size_t)])
+        mem_counters.live_prov -= *(const size_t *)hdr;
+}
+
+static void *count_malloc(size_t num, const char *file, int line) {
+    unsigned char *p = malloc(num + MEM_HDR_LEN);
+
+    if (p == NULL)
+        return NULL;
+    mem_account(p, num, mem_from_provider(file));
+    return p + MEM_HDR_LEN;
+}
+
+static void count_free(void *addr, const char *file, int line) {
+    unsigned char *p = addr;
+
+    if (p == NULL)
+        return;
+    p -= MEM_HDR_LEN;
+    mem_unaccount(p);
+    free(p);
+}
+
+static void *count_realloc(void *addr, size_t num, const char *file,
+                           int line) {
+    unsigned char *p = addr, *q;
+    unsigned char hdr[MEM_HDR_LEN];
+
+    if (p == NULL)
+        return count_malloc(num, file, line);
+    p -= MEM_HDR_LEN;
+    memcpy(hdr, p, sizeof(hdr));
+    if ((q = realloc(p, num + MEM_HDR_LEN)) == NULL)
+        return NULL;
+    mem_unaccount(hdr);
+    mem_account(q, num, hdr[sizeof(size_t)]);
+    return q + MEM_HDR_LEN;
+}
+
+int mem_counting_init(void) {
+    return CRYPTO_set_mem_functions(count_malloc, count_realloc, count_free);
+}
+
+void mem_counting_get(MEM_COUNTERS *counters) { *counters = mem_counters; }
+
+void mem_counting_reset_peak(void) { mem_counters.peak = mem_counters.live; }
+
 OSSL_PROVIDER *load_default_provider(OSSL_LIB_CTX *libctx) {
     OSSL_PROVIDER *provider;
     T((provider = OSSL_PROVIDER_load(libctx, "default")));
     return provider;
 }
 
+EVP_PKEY *key_from_octets(OSSL_LIB_CTX *libctx, const char *alg,
+                          unsigned char *pub, size_t publen,
+                          unsigned char *priv, size_t privlen) {
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *key = NULL;
+    OSSL_PARAM params[3], *p = params;
+
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_PKEY_PARAM_PUB_KEY, pub,
+                                             publen);
+    if (priv != NULL)
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_PKEY_PARAM_PRIV_KEY,
+                                                 priv, privlen);
+    *p = OSSL_PARAM_construct_end();
+    if ((ctx = EVP_PKEY_CTX_new_from_name(libctx, alg, NULL)) == NULL ||
+        EVP_PKEY_fromdata_init(ctx) <= 0 ||
+        EVP_PKEY_fromdata(ctx, &key,
+                          priv != NULL ? EVP_PKEY_KEYPAIR : EVP_PKEY_PUBLIC_KEY,
+                          params) <= 0)
+        key = NULL;
+    EVP_PKEY_CTX_free(ctx);
+    return key;
+}
+
 #ifdef OQS_PROVIDER_STATIC
 #define OQS_PROVIDER_ENTRYPOINT_NAME oqs_provider_init
 #else
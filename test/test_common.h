@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0 AND MIT
 
 #include <openssl/err.h>
+#include <openssl/evp.h>
 #include <openssl/provider.h>
 #include <stdio.h>
 
@@ -36,6 +37,52 @@
 void hexdump(const void *ptr, size_t len);
 int alg_is_enabled(const char *algname);
 
+/* Returns wall clock time in microseconds, for use by the benchmarks. */
+double get_time_us(void);
+/* Returns the CPU time used by the calling thread in microseconds, or the
+ * wall clock time where that is not available. */
+double get_cpu_time_us(void);
+
+/* Helpers shared by the benchmarks and long-running tests */
+
+/* Returns the environment variable "name" as a number, "dflt" if unset. */
+double getenv_double(const char *name, double dflt);
+/* Returns 1 if "list" is NULL or "name" is one of its colon-separated
+ * entries, 0 otherwise. */
+int in_list(const char *list, const char *name);
+/* Calls "fn" for every colon-separated entry of "list" passing
+ * alg_is_enabled(); returns the number of entries "fn" returned 0 for. */
+int for_each_in_list(const char *list, int (*fn)(const char *name, void *arg),
+                     void *arg);
+/* Calls "fn" for every algorithm name the oqsprovider in "libctx" offers for
+ * "operation_id" (OSSL_OP_*), resp. registers in the capability "capability"
+ * ("TLS-GROUP", "TLS-SIGALG"); returns the number of names "fn" returned 0
+ * for, plus 1 if the provider could not be queried. */
+int for_each_oqs_alg(OSSL_LIB_CTX *libctx, int operation_id,
+                     int (*fn)(const char *name, void *arg), void *arg);
+int for_each_oqs_tls_alg(OSSL_LIB_CTX *libctx, const char *capability,
+                         int (*fn)(const char *name, void *arg), void *arg);
+/* Runs "op" until at least "min_us" microseconds and 3 runs have passed;
+ * returns the average time per run in microseconds, -1 if "op" failed. */
+double bench_run(int (*op)(void *arg), void *arg, double min_us);
+
+/* Allocation accounting for the benchmarks: mem_counting_init() installs
+ * counting allocators via CRYPTO_set_mem_functions() and thus must be called
+ * before OpenSSL allocates any memory. Counters cover all allocations made
+ * through OPENSSL_malloc and friends, incl. those made by the provider;
+ * live_prov tells the provider's share if OpenSSL passes source file names
+ * (i.e. is not built with OPENSSL_NO_FILENAMES). */
+typedef struct {
+    size_t live;      /* bytes currently allocated */
+    size_t live_prov; /* part of live allocated by the provider's sources */
+    size_t peak;      /* maximum of live since the last reset */
+    size_t allocs;    /* number of allocations made */
+} MEM_COUNTERS;
+
+int mem_counting_init(void);
+void mem_counting_get(MEM_COUNTERS *counters);
+void mem_counting_reset_peak(void);
+
 /** \brief Loads the default provider.
  *
  * \param libctx Top-level OpenSSL context.
@@ -43,6 +90,12 @@ int alg_is_enabled(const char *algname);
  * \returns The default provider. */
 OSSL_PROVIDER *load_default_provider(OSSL_LIB_CTX *libctx);
 
+/* Imports a key of type "alg" from raw public and, unless "priv" is NULL,
+ * private key material; returns NULL on error. */
+EVP_PKEY *key_from_octets(OSSL_LIB_CTX *libctx, const char *alg,
+                          unsigned char *pub, size_t publen,
+                          unsigned char *priv, size_t privlen);
+
 /* Loads the oqs-provider. */
 void load_oqs_provider(OSSL_LIB_CTX *libctx, const char *modulename,
                        const char *configfile);
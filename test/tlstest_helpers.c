@@ -1,6 +1,11 @@
 // SPDX-License-Identifier: Apache-2.0 AND MIT
 #include <openssl/err.h>
 #include <openssl/ssl.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "test_common.h"
+#include "tlstest_helpers.h"
 
 #define MAXLOOPS 1000000
 
@@ -213,3 +218,112 @@ int create_tls_connection(SSL *serverssl, SSL *clientssl, int want) {
 
     return 1;
 }
+
+/* TCP/IPv4 header bytes carried by every segment */
+#define NETEM_HDR_LEN 40
+
+/* Returns the modeled time in ms it takes to deliver a flight of |len| bytes
+ * in one direction, advancing that direction's congestion window |cwnd|.
+ */
+static double netem_flight_ms(const OQS_NETEM_PARAMS *params, size_t *cwnd,
+                              size_t len, OQS_NETEM_STATS *stats) {
+    size_t mss = params->mtu > 2 * NETEM_HDR_LEN ? params->mtu - NETEM_HDR_LEN
+                                                 : NETEM_HDR_LEN;
+    size_t segments = (len + mss - 1) / mss;
+    size_t remaining = segments, sent;
+    double ms = params->latency_ms;
+
+    if (params->bandwidth_kbps > 0)
+        ms += (len + segments * NETEM_HDR_LEN) * 8 / params->bandwidth_kbps;
+
+    /* slow start: one window per round trip, window grows by acked segs */
+    for (;;) {
+        sent = remaining < *cwnd ? remaining : *cwnd;
+        remaining -= sent;
+        *cwnd += sent;
+        if (remaining == 0)
+            break;
+        ms += 2 * params->latency_ms;
+        stats->extra_rtts++;
+    }
+
+    stats->flights++;
+    stats->segments += segments;
+    stats->bytes += len;
+    return ms;
+}
+
+/* Runs a handshake over the objects created by create_tls_objects() and
+ * accounts for each flight as if it travelled over the link described by
+ * |params|. As in TLS 1.3 peers strictly alternate, modeled completion time
+ * is stats->cpu_ms + stats->network_ms. Flights written after both peers
+ * completed (i.e. session tickets) are not part of the handshake and are not
+ * counted.
+ */
+int create_netem_tls_connection(SSL *serverssl, SSL *clientssl,
+                                const OQS_NETEM_PARAMS *params,
+                                OQS_NETEM_STATS *stats) {
+    BIO *c_to_s_bio = SSL_get_wbio(clientssl);
+    BIO *s_to_c_bio = SSL_get_wbio(serverssl);
+    uint64_t c_written = 0, s_written = 0, now_written;
+    size_t c_cwnd = params->init_cwnd ? params->init_cwnd : 1;
+    size_t s_cwnd = c_cwnd;
+    int retc = -1, rets = -1, err, abortctr = 0;
+    double start;
+
+    if (c_to_s_bio == NULL || s_to_c_bio == NULL)
+        return 0;
+    memset(stats, 0, sizeof(*stats));
+
+    do {
+        if (retc <= 0) {
+            start = get_time_us() / 1000;
+            retc = SSL_connect(clientssl);
+            stats->cpu_ms += get_time_us() / 1000 - start;
+            if (retc <= 0 &&
+                (err = SSL_get_error(clientssl, retc)) != SSL_ERROR_WANT_READ &&
+                err != SSL_ERROR_WANT_WRITE) {
+                fprintf(stderr,
+                        "SSL_connect() failed returning %d, SSL error %d.\n",
+                        retc, err);
+                ERR_print_errors_fp(stderr);
+                return 0;
+            }
+            now_written = BIO_number_written(c_to_s_bio);
+            if (now_written > c_written)
+                stats->network_ms +=
+                    netem_flight_ms(params, &c_cwnd,
+                                    (size_t)(now_written - c_written), stats);
+            c_written = now_written;
+        }
+
+        if (rets <= 0) {
+            start = get_time_us() / 1000;
+            rets = SSL_accept(serverssl);
+            stats->cpu_ms += get_time_us() / 1000 - start;
+            if (rets <= 0 &&
+                (err = SSL_get_error(serverssl, rets)) != SSL_ERROR_WANT_READ &&
+                err != SSL_ERROR_WANT_WRITE &&
+                err != SSL_ERROR_WANT_X509_LOOKUP) {
+                fprintf(stderr,
+                        "SSL_accept() failed returning %d, SSL error %d.\n",
+                        rets, err);
+                ERR_print_errors_fp(stderr);
+                return 0;
+            }
+            now_written = BIO_number_written(s_to_c_bio);
+            if (now_written > s_written && retc <= 0)
+                stats->network_ms +=
+                    netem_flight_ms(params, &s_cwnd,
+                                    (size_t)(now_written - s_written), stats);
+            s_written = now_written;
+        }
+
+        if (++abortctr == MAXLOOPS) {
+            fprintf(stderr, "No progress made");
+            return 0;
+        }
+    } while (retc <= 0 || rets <= 0);
+
+    return 1;
+}
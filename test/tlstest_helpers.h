@@ -10,3 +10,31 @@ int create_tls_objects(SSL_CTX *serverctx, SSL_CTX *clientctx, SSL **sssl,
                        SSL **cssl);
 
 int create_tls_connection(SSL *serverssl, SSL *clientssl, int want);
+
+/* Simple model of the link between client and server, used to estimate the
+ * time a handshake takes on a real network rather than in memory. Every
+ * flight written by one peer is segmented at |mtu| (less 40 bytes of IP/TCP
+ * header), clocked out at |bandwidth_kbps| and delivered after |latency_ms|.
+ * Each direction starts in slow start with |init_cwnd| segments and may only
+ * send a full window per round trip, so large keyshares and certificate
+ * chains pay extra round trips just like on the wire.
+ */
+typedef struct {
+    double latency_ms;     /* one-way delay */
+    double bandwidth_kbps; /* link rate; 0 means unlimited */
+    size_t mtu;            /* bytes per IP packet, incl. headers */
+    size_t init_cwnd;      /* initial congestion window in segments */
+} OQS_NETEM_PARAMS;
+
+typedef struct {
+    double cpu_ms;     /* time spent inside SSL_connect/SSL_accept */
+    double network_ms; /* modeled time spent on the wire */
+    size_t flights;    /* number of flights exchanged */
+    size_t segments;   /* TCP segments sent in both directions */
+    size_t bytes;      /* TLS bytes sent in both directions */
+    size_t extra_rtts; /* round trips caused by congestion window limits */
+} OQS_NETEM_STATS;
+
+int create_netem_tls_connection(SSL *serverssl, SSL *clientssl,
+                                const OQS_NETEM_PARAMS *params,
+                                OQS_NETEM_STATS *stats);